@@ -0,0 +1,94 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#ifndef _BENCH_BENCH_H
+#define _BENCH_BENCH_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <xtensor/containers/xtensor.hpp>
+#include <xtensor/core/xmath.hpp>
+
+#include <weif/spectral_response.h>
+#include <weif/uniform_grid.h>
+
+
+namespace bench {
+
+template<class T> constexpr const char* type_name = "unknown";
+template<> constexpr const char* type_name<float> = "float";
+template<> constexpr const char* type_name<double> = "double";
+template<> constexpr const char* type_name<long double> = "long double";
+
+/* Prevent the compiler from discarding the benchmarked computation */
+template<class T>
+inline void do_not_optimize(const T& value) noexcept {
+	asm volatile("" : : "r"(&value) : "memory");
+}
+
+inline void print_header(std::ostream& stm = std::cout) {
+	stm << "benchmark,type,size,iterations,repetitions,min_ns_per_op,median_ns_per_op" << std::endl;
+}
+
+/*
+ * Run f() `iterations` times per repetition and print a single CSV row.
+ *
+ * The minimum over repetitions is the most stable estimate on a
+ * loaded machine, the median is reported to spot noisy runs.
+ */
+template<class F>
+void run(const std::string& name, const char* type, std::size_t size, std::size_t iterations, std::size_t repetitions, F&& f, std::ostream& stm = std::cout) {
+	using clock = std::chrono::steady_clock;
+
+	std::vector<double> per_op;
+	per_op.reserve(repetitions);
+
+	for (std::size_t r = 0; r < repetitions; ++r) {
+		const auto t1 = clock::now();
+		for (std::size_t i = 0; i < iterations; ++i) {
+			f();
+		}
+		const auto t2 = clock::now();
+
+		per_op.push_back(std::chrono::duration<double, std::nano>(t2 - t1).count() / iterations);
+	}
+
+	std::sort(per_op.begin(), per_op.end());
+
+	stm << name << ','
+		<< type << ','
+		<< size << ','
+		<< iterations << ','
+		<< repetitions << ','
+		<< per_op.front() << ','
+		<< per_op[per_op.size() / 2] << std::endl;
+}
+
+/*
+ * Synthetic Gaussian spectral response, so that benchmarks do not
+ * depend on external data files.
+ */
+template<class T>
+weif::spectral_response<T> make_synthetic_response(T center = 550, T fwhm = 100, T step = 1, T lo = 350, T hi = 850) {
+	const auto size = static_cast<std::size_t>((hi - lo) / step) + 1;
+	const weif::uniform_grid<T> grid{lo, step, size};
+	const auto sigma = fwhm / static_cast<T>(2.354820045030949382023138652918L);
+
+	xt::xtensor<T, 1> data = xt::exp(-xt::square((grid.values() - center) / sigma) / static_cast<T>(2));
+
+	return weif::spectral_response<T>{grid, data}.normalized();
+}
+
+} // bench
+
+#endif // _BENCH_BENCH_H
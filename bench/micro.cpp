@@ -0,0 +1,191 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include <xtensor/containers/xtensor.hpp>
+#include <xtensor/generators/xbuilder.hpp>
+
+#include <weif/af/angle_averaged.h>
+#include <weif/af/circular.h>
+#include <weif/af/gauss.h>
+#include <weif/af/point.h>
+#include <weif/af/square.h>
+#include <weif/detail/cubic_spline.h>
+#include <weif/digital_filter_2d.h>
+#include <weif/math.h>
+#include <weif/sf/mono.h>
+#include <weif/sf/poly.h>
+#include <weif/weight_function.h>
+#include <weif/weight_function_2d.h>
+#include <weif/weight_function_grid_2d.h>
+
+#include "bench.h"
+
+
+namespace {
+
+/* Number of points evaluated per single benchmark iteration */
+constexpr std::size_t points = 1024;
+constexpr std::size_t repetitions = 5;
+
+template<class T>
+xt::xtensor<T, 1> make_args(T lo, T hi) {
+	return xt::linspace(lo, hi, points);
+}
+
+template<class T, class F>
+void run_scalar(const std::string& name, std::size_t size, const xt::xtensor<T, 1>& args, F&& f) {
+	bench::run(name, bench::type_name<T>, size, 200, repetitions, [&] () {
+		T acc = 0;
+		for (const auto& x: args) {
+			acc += f(x);
+		}
+		bench::do_not_optimize(acc);
+	});
+}
+
+template<class T>
+void bench_jinc_pi() {
+	const auto args = make_args<T>(0, 50);
+
+	run_scalar<T>("math::jinc_pi", points, args, [] (T x) { return weif::math::jinc_pi(x); });
+}
+
+template<class T>
+void bench_cubic_spline() {
+	for (const std::size_t size: {64, 1024, 16384}) {
+		const xt::xtensor<T, 1> values = xt::sin(xt::linspace(static_cast<T>(0), static_cast<T>(10), size));
+		const weif::detail::cubic_spline<T> spline{values};
+		const auto args = make_args<T>(0, static_cast<T>(size - 1) - static_cast<T>(0.5));
+
+		run_scalar<T>("cubic_spline::operator()", size, args, [&spline] (T x) { return spline(x); });
+	}
+}
+
+template<class T>
+void bench_poly() {
+	const auto response = bench::make_synthetic_response<T>();
+
+	for (const std::size_t size: {1024, 4096, 16384}) {
+		auto sf = weif::sf::poly<T>{response, size}.normalized();
+		const auto args = make_args<T>(0, 10);
+
+		run_scalar<T>("sf::poly::operator()", size, args, [&sf] (T x) { return sf(x); });
+	}
+}
+
+template<class T>
+void bench_aperture_filters() {
+	const auto args = make_args<T>(0, 20);
+
+	run_scalar<T>("af::point::operator()", points, args, [af = weif::af::point<T>{}] (T u) { return af(u); });
+	run_scalar<T>("af::circular::operator()", points, args, [af = weif::af::circular<T>{}] (T u) { return af(u); });
+	run_scalar<T>("af::annular::operator()", points, args, [af = weif::af::annular<T>{0.3}] (T u) { return af(u); });
+	run_scalar<T>("af::cross_annular::operator()", points, args, [af = weif::af::cross_annular<T>{0.6, 0.3, 0.0}] (T u) { return af(u); });
+	run_scalar<T>("af::gauss::operator()", points, args, [af = weif::af::gauss<T>{}] (T u) { return af(u); });
+	run_scalar<T>("af::square::operator()", points, args, [af = weif::af::square<T>{}] (T u) { return af(u, u / 2); });
+
+	const weif::af::angle_averaged<T> af{weif::af::square<T>{}, 1024};
+	run_scalar<T>("af::angle_averaged::operator()", points, args, [&af] (T u) { return af(u); });
+}
+
+template<class T>
+void bench_digital_filter_2d() {
+	const weif::af::square<T> square_af{};
+	const auto args = make_args<T>(0, static_cast<T>(0.5));
+
+	for (const std::size_t size: {11, 31, 121}) {
+		const weif::digital_filter_2d<T> df{[&square_af] (T ux, T uy) noexcept {
+			const auto u2 = ux * ux + uy * uy;
+
+			return std::pow(u2 * 4, static_cast<T>(5.0/6.0)) / square_af(ux, uy);
+		}, std::array{size, size}};
+
+		bench::run("digital_filter_2d::operator()", bench::type_name<T>, size, 1, repetitions, [&] () {
+			T acc = 0;
+			for (const auto& x: args) {
+				acc += df(x, x / 2);
+			}
+			bench::do_not_optimize(acc);
+		});
+	}
+}
+
+template<class T>
+void bench_construction() {
+	const auto response = bench::make_synthetic_response<T>();
+
+	for (const std::size_t size: {1024, 4096, 16384}) {
+		bench::run("sf::poly::poly", bench::type_name<T>, size, 1, 3, [&] () {
+			weif::sf::poly<T> sf{response, size};
+			bench::do_not_optimize(sf);
+		});
+	}
+
+	for (const std::size_t size: {65, 257, 1025}) {
+		bench::run("weight_function::weight_function", bench::type_name<T>, size, 1, 3, [&] () {
+			weif::weight_function<T> wf{weif::sf::mono<T>{}, 500, weif::af::circular<T>{}, 100, size};
+			bench::do_not_optimize(wf);
+		});
+	}
+
+	for (const std::size_t size: {9, 17, 33}) {
+		bench::run("weight_function_2d::weight_function_2d", bench::type_name<T>, size, 1, 1, [&] () {
+			weif::weight_function_2d<T> wf{weif::sf::mono<T>{}, 500, weif::af::square<T>{}, 100, size};
+			bench::do_not_optimize(wf);
+		});
+	}
+
+	for (const std::size_t size: {128, 512, 1024}) {
+		bench::run("af::angle_averaged::angle_averaged", bench::type_name<T>, size, 1, 3, [&] () {
+			weif::af::angle_averaged<T> af{weif::af::square<T>{}, size};
+			bench::do_not_optimize(af);
+		});
+	}
+
+	for (const std::size_t size: {31, 61, 121}) {
+		const auto shape = std::array{size, size};
+
+		bench::run("weight_function_grid_2d::weight_function_grid_2d", bench::type_name<T>, size, 1, 3, [&] () {
+			weif::weight_function_grid_2d<T> wf{weif::sf::mono<T>{}, 500, weif::af::square<T>{}, 10, shape};
+			bench::do_not_optimize(wf);
+		});
+
+		const weif::weight_function_grid_2d<T> wf{weif::sf::mono<T>{}, 500, weif::af::square<T>{}, 10, shape};
+		bench::run("weight_function_grid_2d::operator()", bench::type_name<T>, size, 1, repetitions, [&] () {
+			auto res = wf(static_cast<T>(2));
+			bench::do_not_optimize(res);
+		});
+	}
+}
+
+template<class T>
+void bench_all() {
+	bench_jinc_pi<T>();
+	bench_cubic_spline<T>();
+	bench_poly<T>();
+	bench_aperture_filters<T>();
+	bench_digital_filter_2d<T>();
+	bench_construction<T>();
+}
+
+} // namespace
+
+
+int main() {
+	bench::print_header();
+
+	bench_all<float>();
+	bench_all<double>();
+	bench_all<long double>();
+
+	return 0;
+}
@@ -0,0 +1,283 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <xtensor/containers/xarray.hpp>
+#include <xtensor/generators/xbuilder.hpp>
+#include <xtensor/misc/xpad.hpp>
+
+#include <weif/af/angle_averaged.h>
+#include <weif/af/circular.h>
+#include <weif/af/square.h>
+#include <weif/digital_filter_2d.h>
+#include <weif/sf/poly.h>
+#include <weif/spectral_response.h>
+#include <weif/weight_function.h>
+#include <weif/weight_function_grid_2d.h>
+
+#include "bench.h"
+
+
+/*
+ * Production scenarios mirroring the programs in example/.
+ *
+ * Every scenario runs in a forked child process so that the reported
+ * peak resident set size belongs to that scenario only.
+ */
+
+using value_type = float;
+
+namespace {
+
+struct counters {
+	std::size_t spectral = 0;
+	std::size_t aperture = 0;
+};
+
+/* Spectral filter wrapper counting integrand evaluations */
+template<class SF>
+struct counting_spectral_filter {
+	using value_type = ::value_type;
+
+	SF sf;
+	counters* cnt;
+
+	value_type operator() (value_type x) const noexcept {
+		++cnt->spectral;
+		return sf(x);
+	}
+
+	value_type regular(value_type x) const noexcept {
+		++cnt->spectral;
+		return sf.regular(x);
+	}
+};
+
+/* Aperture filter wrapper counting integrand evaluations */
+template<class AF>
+struct counting_aperture_filter {
+	using value_type = ::value_type;
+
+	AF af;
+	counters* cnt;
+
+	value_type operator() (value_type u) const noexcept {
+		++cnt->aperture;
+		return af(u);
+	}
+
+	value_type operator() (value_type ux, value_type uy) const noexcept {
+		++cnt->aperture;
+		return af(ux, uy);
+	}
+};
+
+template<class SF>
+counting_spectral_filter<std::decay_t<SF>> count_spectral(SF&& sf, counters& cnt) {
+	return {std::forward<SF>(sf), &cnt};
+}
+
+template<class AF>
+counting_aperture_filter<std::decay_t<AF>> count_aperture(AF&& af, counters& cnt) {
+	return {std::forward<AF>(af), &cnt};
+}
+
+/* Two stacked responses mimic filter times detector input of the examples */
+std::pair<value_type, weif::sf::poly<value_type>> make_spectral_filter() {
+	auto sr = bench::make_synthetic_response<value_type>(500, 150)
+		.stacked(bench::make_synthetic_response<value_type>(600, 250));
+	sr.normalize();
+
+	weif::sf::poly sf{sr, 4096};
+	const auto lambda = sf.equiv_lambda();
+	sf.normalize();
+
+	return {lambda, std::move(sf)};
+}
+
+const xt::xarray<value_type> altitudes = xt::linspace(static_cast<value_type>(0), static_cast<value_type>(30), 1024);
+
+/* example/mass_weight_function.cpp */
+void mass_bank(counters& cnt) {
+	constexpr std::array<value_type, 4> inner = {0.00, 1.30, 2.20, 3.90};
+	constexpr std::array<value_type, 4> outer = {1.27, 2.15, 3.85, 5.50};
+	constexpr value_type magnification = 16.20;
+	constexpr auto wf_grid_size = 1024 + 1;
+
+	const auto [lambda, spectral_filter] = make_spectral_filter();
+
+	std::vector<weif::weight_function<value_type>> wf;
+	wf.reserve(10);
+
+	for (std::size_t i = 0; i < inner.size(); ++i) {
+		for (std::size_t j = 0; j <= i; ++j) {
+			const auto aperture_filter = weif::af::cross_annular{outer[j] / outer[i], inner[i] / outer[i], inner[j] / outer[j]};
+			wf.emplace_back(count_spectral(spectral_filter, cnt), lambda, aperture_filter, outer[i] * magnification, wf_grid_size);
+		}
+	}
+
+	for (const auto& w: wf) {
+		xt::xarray<value_type> res = w(altitudes);
+		bench::do_not_optimize(res);
+	}
+}
+
+weif::digital_filter_2d<value_type> make_digital_filter(std::size_t impulse_size) {
+	const weif::af::square<value_type> square_af{};
+
+	return {[square_af] (value_type ux, value_type uy) noexcept {
+		const auto u2 = ux * ux + uy * uy;
+
+		return std::pow(u2 * 4, static_cast<value_type>(5.0/6.0)) / square_af(ux, uy);
+	}, std::array{impulse_size, impulse_size}};
+}
+
+/* example/digital_filter_2d.cpp, sum_then_integrate = true */
+void digital_filter_sum_then_integrate(counters& cnt) {
+	constexpr value_type aperture_scale = 11;
+	constexpr auto wf_grid_size = 1024 + 1;
+
+	const auto [lambda, sf] = make_spectral_filter();
+	const weif::af::square<value_type> square_af{};
+	const auto df = make_digital_filter(121);
+
+	const weif::af::angle_averaged<value_type> af{count_aperture([&square_af, &df] (value_type ux, value_type uy) noexcept {
+		return square_af(ux, uy) * df(ux, uy);
+	}, cnt), 1024};
+	const weif::weight_function<value_type> wf{count_spectral(sf, cnt), lambda, af, aperture_scale, wf_grid_size};
+
+	xt::xarray<value_type> res = wf(altitudes);
+	bench::do_not_optimize(res);
+}
+
+/* example/digital_filter_2d.cpp, sum_then_integrate = false */
+void digital_filter_integrate_then_sum(counters& cnt) {
+	constexpr value_type aperture_scale = 11;
+	constexpr std::size_t impulse_size = 121;
+
+	const auto [lambda, sf] = make_spectral_filter();
+	const auto df = make_digital_filter(impulse_size);
+
+	const weif::weight_function_grid_2d<value_type> wf{count_spectral(sf, cnt), lambda, weif::af::square<value_type>{}, aperture_scale, aperture_scale,
+		std::array{impulse_size, impulse_size}};
+
+	const std::vector<std::vector<std::size_t>> pad_width{{0, impulse_size - 1}, {0, impulse_size - 1}};
+
+	xt::xarray<value_type> res{altitudes.shape()};
+
+	for (std::size_t i = 0; i < altitudes.size(); ++i) {
+		res(i) = xt::sum(xt::pad(wf(altitudes(i)) * df.impulse(), pad_width, xt::pad_mode::symmetric))();
+	}
+
+	bench::do_not_optimize(res);
+}
+
+/* example/weight_function_grid_2d.cpp at every altitude */
+void grid_2d_altitudes(counters& cnt) {
+	constexpr value_type aperture_scale = 11;
+	constexpr std::size_t grid_size = 121;
+
+	const auto [lambda, sf] = make_spectral_filter();
+	const weif::weight_function_grid_2d<value_type> wf{count_spectral(sf, cnt), lambda, weif::af::circular<value_type>{}, aperture_scale, aperture_scale,
+		std::array{grid_size, grid_size}};
+
+	for (std::size_t i = 0; i < altitudes.size(); ++i) {
+		auto res = wf(altitudes(i));
+		bench::do_not_optimize(res);
+	}
+}
+
+/* example/weight_function.cpp --square for several aperture scales */
+void poly_square(counters& cnt) {
+	constexpr auto wf_grid_size = 1024 + 1;
+
+	const auto [lambda, sf] = make_spectral_filter();
+	const weif::af::angle_averaged af{count_aperture(weif::af::square<value_type>{}, cnt), 1024};
+
+	for (const value_type aperture_scale: {2.0, 5.0, 10.0, 20.574}) {
+		const weif::weight_function<value_type> wf{count_spectral(sf, cnt), lambda, af, aperture_scale, wf_grid_size};
+
+		xt::xarray<value_type> res = wf(altitudes);
+		bench::do_not_optimize(res);
+	}
+}
+
+const std::vector<std::pair<std::string, std::function<void(counters&)>>> scenarios = {
+	{"mass_bank", mass_bank},
+	{"digital_filter_sum_then_integrate", digital_filter_sum_then_integrate},
+	{"digital_filter_integrate_then_sum", digital_filter_integrate_then_sum},
+	{"grid_2d_altitudes", grid_2d_altitudes},
+	{"poly_square", poly_square},
+};
+
+int run_scenario(const std::string& name, const std::function<void(counters&)>& scenario) {
+	std::cout.flush();
+
+	const pid_t pid = fork();
+	if (pid < 0) {
+		std::cerr << "fork() failed" << std::endl;
+
+		return 1;
+	}
+
+	if (pid == 0) {
+		counters cnt;
+
+		const auto t1 = std::chrono::steady_clock::now();
+		scenario(cnt);
+		const auto t2 = std::chrono::steady_clock::now();
+
+		struct rusage usage;
+		getrusage(RUSAGE_SELF, &usage);
+
+		std::cout << name << ','
+			<< bench::type_name<value_type> << ','
+			<< std::chrono::duration<double>(t2 - t1).count() << ','
+			<< usage.ru_maxrss << ','
+			<< cnt.spectral << ','
+			<< cnt.aperture << std::endl;
+
+		std::_Exit(0);
+	}
+
+	int status = 0;
+	waitpid(pid, &status, 0);
+
+	return (WIFEXITED(status) ? WEXITSTATUS(status) : 1);
+}
+
+} // namespace
+
+
+int main(int argc, char** argv) {
+	std::cout << "scenario,type,time_sec,peak_rss_kb,spectral_evaluations,aperture_evaluations" << std::endl;
+
+	int ret = 0;
+	for (const auto& [name, scenario]: scenarios) {
+		if (argc > 1 && std::find(argv + 1, argv + argc, name) == argv + argc)
+			continue;
+
+		ret |= run_scenario(name, scenario);
+	}
+
+	return ret;
+}
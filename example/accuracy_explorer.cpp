@@ -0,0 +1,297 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <variant>
+#include <vector>
+
+#include <boost/program_options.hpp>
+
+#include <xtensor/containers/xtensor.hpp>
+#include <xtensor/core/xmath.hpp>
+#include <xtensor/generators/xbuilder.hpp>
+
+#include <weif/af/angle_averaged.h>
+#include <weif/af/circular.h>
+#include <weif/af/square.h>
+#include <weif/sf/mono.h>
+#include <weif/sf/poly.h>
+#include <weif/spectral_response.h>
+#include <weif/uniform_grid.h>
+#include <weif/weight_function.h>
+
+
+/*
+ * Accuracy versus cost explorer
+ *
+ * Sweeps the construction knobs: weight function grid size, sf::poly
+ * FFT size, af::angle_averaged size and the numeric type (quadrature
+ * tolerance is derived from the type epsilon). Each configuration is
+ * compared against a long double reference built with the finest
+ * settings. The output is CSV; configurations on the Pareto front of
+ * (error, construction time, evaluation time) are marked.
+ */
+
+struct settings {
+	std::optional<long double> mono;
+	std::vector<std::string> response_filename;
+	long double aperture_scale;
+	long double central_obscuration;
+	bool square;
+	std::optional<weif::spectral_response<long double>> response;
+};
+
+struct knobs {
+	std::string type;
+	std::size_t size;
+	std::size_t fft_size;
+	std::size_t aa_size;
+};
+
+struct result {
+	knobs k;
+	double error;
+	double construction_time;
+	double evaluation_time;
+	bool pareto;
+};
+
+/* The responses are read and stacked once in main(), so the file I/O is not timed */
+template<class T>
+std::optional<weif::spectral_response<T>> make_response(const settings& s) {
+	if (!s.response) {
+		return std::nullopt;
+	}
+
+	const auto& grid = s.response->grid();
+
+	return weif::spectral_response<T>{
+		weif::uniform_grid<T>{static_cast<T>(grid.origin()), static_cast<T>(grid.delta()), grid.size()},
+		xt::cast<T>(s.response->data())};
+}
+
+template<class T>
+std::pair<T, std::variant<weif::sf::mono<T>, weif::sf::poly<T>>>
+make_spectral_filter(const settings& s, const std::optional<weif::spectral_response<T>>& response, std::size_t fft_size) {
+	if (s.mono) {
+		return {static_cast<T>(*s.mono), weif::sf::mono<T>{}};
+	}
+
+	weif::sf::poly<T> sf{*response, fft_size};
+	const auto lambda = sf.equiv_lambda();
+	sf.normalize();
+
+	return {lambda, std::move(sf)};
+}
+
+template<class T>
+std::variant<weif::af::annular<T>, weif::af::circular<T>, weif::af::angle_averaged<T>>
+make_aperture_filter(const settings& s, std::size_t aa_size) {
+	if (s.square) {
+		return weif::af::angle_averaged{weif::af::square<T>{}, aa_size};
+	}
+
+	if (s.central_obscuration != 0) {
+		return weif::af::annular<T>{static_cast<T>(s.central_obscuration)};
+	}
+
+	return weif::af::circular<T>{};
+}
+
+/* Returns weight function values at the altitudes and construction and per point evaluation times */
+template<class T>
+std::tuple<xt::xtensor<long double, 1>, double, double>
+evaluate(const settings& s, const knobs& k, const xt::xtensor<long double, 1>& altitudes) {
+	using clock = std::chrono::steady_clock;
+
+	constexpr std::size_t eval_repetitions = 100;
+
+	const xt::xtensor<T, 1> args = xt::cast<T>(altitudes);
+	const auto response = make_response<T>(s);
+
+	const auto t1 = clock::now();
+
+	const auto [lambda, spectral_filter] = make_spectral_filter<T>(s, response, k.fft_size);
+	const auto aperture_filter = make_aperture_filter<T>(s, k.aa_size);
+	const auto wf = std::visit([&] (const auto& af) {
+		return std::visit([&] (const auto& sf) {
+			return weif::weight_function<T>{sf, lambda, af, static_cast<T>(s.aperture_scale), k.size};
+		}, spectral_filter);
+	}, aperture_filter);
+
+	const auto t2 = clock::now();
+
+	xt::xtensor<T, 1> values = wf(args);
+	for (std::size_t i = 1; i < eval_repetitions; ++i) {
+		values = wf(args);
+	}
+
+	const auto t3 = clock::now();
+
+	return {xt::cast<long double>(values),
+		std::chrono::duration<double>(t2 - t1).count(),
+		std::chrono::duration<double>(t3 - t2).count() / eval_repetitions / args.size()};
+}
+
+double relative_error(const xt::xtensor<long double, 1>& actual, const xt::xtensor<long double, 1>& expected) {
+	return static_cast<double>(xt::amax(xt::abs(actual - expected))() / xt::amax(xt::abs(expected))());
+}
+
+void mark_pareto(std::vector<result>& results) {
+	for (auto& r: results) {
+		r.pareto = std::none_of(results.cbegin(), results.cend(), [&r] (const result& o) {
+			const bool no_worse = o.error <= r.error && o.construction_time <= r.construction_time && o.evaluation_time <= r.evaluation_time;
+			const bool better = o.error < r.error || o.construction_time < r.construction_time || o.evaluation_time < r.evaluation_time;
+
+			return no_worse && better;
+		});
+	}
+}
+
+int main(int argc, char** argv) {
+	namespace po = boost::program_options;
+
+	po::options_description opts;
+	po::positional_options_description pos_opts;
+	po::variables_map va;
+
+	opts.add_options()
+		("help", "Produce help message")
+		("aperture_scale", po::value<long double>()->default_value(20.574), "Aperture scale, mm.")
+		("central_obscuration", po::value<long double>()->default_value(0.0), "Central obscuration")
+		("square", "Use square aperture filter")
+		("mono", po::value<long double>(), "Use monochromatic spectral filter with given labmda")
+		("response_filename", po::value<std::vector<std::string>>()->multitoken(), "Spectral response input filename")
+		("size", po::value<std::vector<std::size_t>>()->multitoken()->default_value({129, 257, 513, 1025}, "129 257 513 1025"), "Weight function grid sizes")
+		("fft_size", po::value<std::vector<std::size_t>>()->multitoken()->default_value({1024, 2048, 4096, 8192}, "1024 2048 4096 8192"), "Polychromatic filter FFT sizes")
+		("aa_size", po::value<std::vector<std::size_t>>()->multitoken()->default_value({256, 512, 1024}, "256 512 1024"), "Angle averaged filter sizes")
+		("reference_size", po::value<std::size_t>()->default_value(4097), "Reference weight function grid size")
+		("reference_fft_size", po::value<std::size_t>()->default_value(16384), "Reference polychromatic filter FFT size")
+		("reference_aa_size", po::value<std::size_t>()->default_value(4096), "Reference angle averaged filter size")
+		("altitudes", po::value<std::size_t>()->default_value(256), "Number of test altitudes in range (0, 30] km.")
+		("spec", po::value<double>(), "Required relative error, report the cheapest configuration which meets it");
+
+	try {
+		auto parsed = po::command_line_parser(argc, argv).options(opts).positional(pos_opts).run();
+		po::store(std::move(parsed), va);
+
+		if (va.count("help")) {
+			std::cerr << opts << std::endl;
+
+			return 1;
+		}
+
+		po::notify(va);
+
+		settings s{
+			(va.count("mono") ? std::optional(va["mono"].as<long double>()) : std::nullopt),
+			(va.count("response_filename") ? va["response_filename"].as<std::vector<std::string>>() : std::vector<std::string>{}),
+			va["aperture_scale"].as<long double>(),
+			va["central_obscuration"].as<long double>(),
+			static_cast<bool>(va.count("square")),
+			std::nullopt};
+
+		if (!s.mono && s.response_filename.empty()) {
+			std::cerr << "Either --mono or --response_filename is required" << std::endl;
+
+			return 1;
+		}
+
+		if (!s.mono) {
+			s.response = weif::spectral_response<long double>::stack_from_files(s.response_filename.cbegin(), s.response_filename.cend());
+			s.response->normalize();
+		}
+
+		const auto sizes = va["size"].as<std::vector<std::size_t>>();
+		const auto fft_sizes = (s.mono ? std::vector<std::size_t>{0} : va["fft_size"].as<std::vector<std::size_t>>());
+		const auto aa_sizes = (s.square ? va["aa_size"].as<std::vector<std::size_t>>() : std::vector<std::size_t>{0});
+		const auto n_altitudes = va["altitudes"].as<std::size_t>();
+
+		/* Zero altitude is excluded since the weight function is identically zero there */
+		const xt::xtensor<long double, 1> altitudes = xt::linspace(static_cast<long double>(30) / n_altitudes, static_cast<long double>(30), n_altitudes);
+
+		const knobs reference_knobs{"long double",
+			va["reference_size"].as<std::size_t>(),
+			va["reference_fft_size"].as<std::size_t>(),
+			va["reference_aa_size"].as<std::size_t>()};
+
+		std::cerr << "Computing reference..." << std::endl;
+		const auto [reference, reference_ct, reference_et] = evaluate<long double>(s, reference_knobs, altitudes);
+		std::cerr << "Reference construction time: " << reference_ct << " sec" << std::endl;
+
+		std::vector<result> results;
+
+		for (const auto& type: {"float", "double"}) {
+			for (const auto size: sizes) {
+				for (const auto fft_size: fft_sizes) {
+					for (const auto aa_size: aa_sizes) {
+						const knobs k{type, size, fft_size, aa_size};
+						const auto [values, ct, et] = (k.type == "float" ?
+							evaluate<float>(s, k, altitudes) :
+							evaluate<double>(s, k, altitudes));
+
+						results.push_back({k, relative_error(values, reference), ct, et, false});
+					}
+				}
+			}
+		}
+
+		mark_pareto(results);
+
+		std::cout << "type,size,fft_size,aa_size,relative_error,construction_time_sec,evaluation_time_sec,pareto" << std::endl;
+		for (const auto& r: results) {
+			std::cout << r.k.type << ','
+				<< r.k.size << ','
+				<< r.k.fft_size << ','
+				<< r.k.aa_size << ','
+				<< r.error << ','
+				<< r.construction_time << ','
+				<< r.evaluation_time << ','
+				<< r.pareto << std::endl;
+		}
+
+		if (va.count("spec")) {
+			const auto spec = va["spec"].as<double>();
+
+			auto it = std::min_element(results.cbegin(), results.cend(), [spec] (const result& a, const result& b) {
+				const bool a_ok = a.error <= spec;
+				const bool b_ok = b.error <= spec;
+
+				if (a_ok != b_ok)
+					return a_ok;
+
+				return a.construction_time < b.construction_time;
+			});
+
+			if (it == results.cend() || it->error > spec) {
+				std::cerr << "No configuration meets relative error " << spec << std::endl;
+
+				return 1;
+			}
+
+			std::cerr << "Cheapest configuration: type " << it->k.type
+				<< ", size " << it->k.size
+				<< ", fft_size " << it->k.fft_size
+				<< ", aa_size " << it->k.aa_size
+				<< ", relative error " << it->error
+				<< ", construction time " << it->construction_time << " sec" << std::endl;
+		}
+
+	} catch (const po::error& e) {
+		std::cerr << e.what() << std::endl;
+		std::cerr << opts << std::endl;
+
+		return 1;
+	}
+
+	return 0;
+}
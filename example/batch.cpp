@@ -0,0 +1,202 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/program_options.hpp>
+
+#include <xtensor/containers/xarray.hpp>
+#include <xtensor/containers/xtensor.hpp>
+#include <xtensor/generators/xbuilder.hpp>
+#include <xtensor/misc/xmanipulation.hpp>
+
+#include <rapidcsv.h>
+
+#include "job.h"
+#include "output.h"
+
+
+/*
+ * Batch weight function production
+ *
+ * Reads a CSV job file with a header row. Every row describes a single
+ * output, the columns are the job fields listed in job.h.
+ *
+ * wf jobs write (size, 2) array of altitudes and values. grid_2d jobs
+ * write (grid_size, grid_size) array for a single altitude or stream
+ * (size, grid_size, grid_size) array altitude by altitude.
+ *
+ * Spectral filters, angle averaged square aperture filters and weight
+ * functions are shared between jobs with identical parameters, so every
+ * response set is read and transformed once. Jobs run on a thread pool.
+ */
+
+using jobs::value_type;
+
+namespace {
+
+std::vector<jobs::job> read_jobs(const std::string& filename, output::format default_format) {
+	rapidcsv::Document doc(filename,
+		rapidcsv::LabelParams(0, -1),
+		rapidcsv::SeparatorParams(',', true),
+		rapidcsv::ConverterParams(),
+		rapidcsv::LineReaderParams(true));
+
+	std::vector<jobs::job> ret;
+	ret.reserve(doc.GetRowCount());
+
+	for (std::size_t row = 0; row < doc.GetRowCount(); ++row) {
+		const auto field = [&doc, row] (const std::string& name) -> std::string {
+			if (doc.GetColumnIdx(name) < 0)
+				return {};
+
+			return doc.GetCell<std::string>(name, row);
+		};
+
+		try {
+			auto j = jobs::make_job(field, default_format);
+
+			if (j.output_filename.empty())
+				throw std::runtime_error("output_filename is required");
+
+			ret.push_back(std::move(j));
+		} catch (const std::exception& e) {
+			throw std::runtime_error("Row " + std::to_string(row) + ": " + e.what());
+		}
+	}
+
+	return ret;
+}
+
+class batch {
+private:
+	jobs::cache cache_;
+
+	void run_wf(const jobs::job& j) {
+		const auto wf = cache_.weight_function(j);
+		const xt::xarray<value_type> grid = xt::linspace(static_cast<value_type>(0), static_cast<value_type>(30), j.size);
+
+		output::dump(j.output_filename, j.output_format, xt::transpose(xt::vstack(xt::xtuple(grid, (*wf)(grid)))));
+	}
+
+	void run_grid_2d(const jobs::job& j) {
+		const auto wf = cache_.weight_function_grid_2d(j);
+
+		if (j.altitude) {
+			output::dump(j.output_filename, j.output_format, (*wf)(*j.altitude));
+
+			return;
+		}
+
+		const xt::xtensor<value_type, 1> altitudes = xt::linspace(static_cast<value_type>(0), static_cast<value_type>(30), j.size);
+
+		output::stream_writer<value_type> writer{j.output_filename, j.output_format, {j.grid_size, j.grid_size}, j.size};
+		for (std::size_t i = 0; i < j.size; ++i) {
+			writer.append((*wf)(altitudes(i)));
+		}
+	}
+
+public:
+	void run(const jobs::job& j) {
+		if (j.kind == "grid_2d") {
+			run_grid_2d(j);
+		} else {
+			run_wf(j);
+		}
+	}
+};
+
+} // namespace
+
+
+int main(int argc, char** argv) {
+	namespace po = boost::program_options;
+
+	po::options_description opts;
+	po::positional_options_description pos_opts;
+	po::variables_map va;
+
+	opts.add_options()
+		("help", "Produce help message")
+		("job_filename", po::value<std::string>()->required(), "Job description CSV filename")
+		("output_format", po::value<std::string>()->default_value("csv"), "Default output format: csv, npy or raw")
+		("threads", po::value<std::size_t>()->default_value(std::thread::hardware_concurrency()), "Number of worker threads");
+
+	pos_opts.add("job_filename", 1);
+
+	try {
+		auto parsed = po::command_line_parser(argc, argv).options(opts).positional(pos_opts).run();
+		po::store(std::move(parsed), va);
+
+		if (va.count("help")) {
+			std::cerr << opts << std::endl;
+
+			return 1;
+		}
+
+		po::notify(va);
+
+		const auto job_list = read_jobs(va["job_filename"].as<std::string>(), output::parse_format(va["output_format"].as<std::string>()));
+		const auto threads = std::max<std::size_t>(1, std::min(va["threads"].as<std::size_t>(), job_list.size()));
+
+		batch b;
+		std::atomic<std::size_t> next{0};
+		std::atomic<bool> failed{false};
+		std::mutex log_mutex;
+
+		const auto t1 = std::chrono::high_resolution_clock::now();
+
+		std::vector<std::thread> pool;
+		pool.reserve(threads);
+
+		for (std::size_t i = 0; i < threads; ++i) {
+			pool.emplace_back([&] () {
+				for (std::size_t k = next++; k < job_list.size(); k = next++) {
+					try {
+						b.run(job_list[k]);
+					} catch (const std::exception& e) {
+						failed = true;
+
+						std::lock_guard<std::mutex> lock(log_mutex);
+						std::cerr << job_list[k].output_filename << ": " << e.what() << std::endl;
+					}
+				}
+			});
+		}
+
+		for (auto& t: pool) {
+			t.join();
+		}
+
+		const auto t2 = std::chrono::high_resolution_clock::now();
+
+		std::cerr << "Processed " << job_list.size() << " jobs" << std::endl;
+		std::cerr << "Consumed time: " << std::chrono::duration_cast<std::chrono::duration<value_type>>(t2-t1).count() << " sec" << std::endl;
+
+		return (failed ? 1 : 0);
+
+	} catch (const po::error& e) {
+		std::cerr << e.what() << std::endl;
+		std::cerr << opts << std::endl;
+
+		return 1;
+	} catch (const std::exception& e) {
+		std::cerr << e.what() << std::endl;
+
+		return 1;
+	}
+
+	return 0;
+}
@@ -5,7 +5,6 @@
  */
 
 #include <cmath>
-#include <fstream>
 #include <iostream>
 #include <string>
 
@@ -13,7 +12,6 @@
 
 #include <xtensor/containers/xarray.hpp> // IWYU pragma: keep
 #include <xtensor/generators/xbuilder.hpp>
-#include <xtensor/io/xcsv.hpp>
 #include <xtensor/misc/xmanipulation.hpp>
 
 #include <weif/af/angle_averaged.h>
@@ -23,6 +21,8 @@
 #include <weif/weight_function.h>
 #include <weif/weight_function_grid_2d.h>
 
+#include "output.h"
+
 
 using value_type = float;
 
@@ -52,6 +52,7 @@ int main(int argc, char** argv) {
 		("impulse_size", po::value<std::size_t>()->default_value(121), "Filter impulse size")
 		("aperture_scale", po::value<value_type>()->default_value(11), "Aperture scale, mm.")
 		("output_filename", po::value<std::string>()->default_value("wf.dat"), "Output filename")
+		("output_format", po::value<std::string>()->default_value("csv"), "Output format: csv, npy or raw")
 		("response_filename", po::value<std::vector<std::string>>()->required(), "Spectral response input filename");
 
 	constexpr bool sum_then_integrate = true;
@@ -65,6 +66,7 @@ int main(int argc, char** argv) {
 		const auto impulse_size = va["impulse_size"].as<std::size_t>();
 		const auto aperture_scale = va["aperture_scale"].as<value_type>();
 		const auto output_filename = va["output_filename"].as<std::string>();
+		const auto output_format = output::parse_format(va["output_format"].as<std::string>());
 		const auto response_filename = va["response_filename"].as<std::vector<std::string>>();
 
 		const auto [lambda, sf] = make_spectral_filter(response_filename);
@@ -89,8 +91,7 @@ int main(int argc, char** argv) {
 			constexpr auto wf_grid_size = 1024 + 1;
 			const weif::weight_function<value_type> wf{sf, lambda, af, aperture_scale, wf_grid_size};
 
-			std::ofstream stm(output_filename);
-			xt::dump_csv(stm, xt::transpose(xt::vstack(xt::xtuple(grid, wf(grid)))));
+			output::dump(output_filename, output_format, xt::transpose(xt::vstack(xt::xtuple(grid, wf(grid)))));
 
 			const auto t2 = std::chrono::high_resolution_clock::now();
 
@@ -109,8 +110,7 @@ int main(int argc, char** argv) {
 				res(i) = xt::sum(xt::pad(wf(grid(i)) * df.impulse(), pad_width, xt::pad_mode::symmetric))();
 			}
 
-			std::ofstream stm(output_filename);
-			xt::dump_csv(stm, xt::transpose(xt::vstack(xt::xtuple(grid, res))));
+			output::dump(output_filename, output_format, xt::transpose(xt::vstack(xt::xtuple(grid, res))));
 
 			const auto t2 = std::chrono::high_resolution_clock::now();
 
@@ -0,0 +1,137 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include <boost/program_options.hpp>
+
+#include <xtensor/containers/xarray.hpp>
+#include <xtensor/generators/xbuilder.hpp>
+#include <xtensor/views/xview.hpp>
+
+#include <weif/af/circular.h>
+#include <weif/forward_model.h>
+#include <weif/sf/poly.h>
+#include <weif/spectral_response.h>
+#include <weif/weight_function.h>
+
+#include "output.h"
+
+
+using value_type = float;
+
+
+std::pair<value_type, weif::sf::poly<value_type>>
+make_spectral_filter(const std::vector<std::string>& response_filename) {
+	auto sr = weif::spectral_response<value_type>::stack_from_files(response_filename.cbegin(), response_filename.cend());
+	std::cerr << "Effective lambda: " << sr.effective_lambda() << std::endl;
+	sr.normalize();
+
+	weif::sf::poly sf{sr, 4096};
+	const auto lambda = sf.equiv_lambda();
+	std::cerr << "Equivalent lambda: " << lambda << std::endl;
+	sf.normalize();
+
+	return {lambda, std::move(sf)};
+}
+
+int main(int argc, char** argv) {
+	namespace po = boost::program_options;
+
+	po::options_description opts;
+	po::positional_options_description pos_opts;
+	po::variables_map va;
+
+	opts.add_options()
+		("count", po::value<std::size_t>()->default_value(1000000), "Number of random profiles")
+		("bins", po::value<std::size_t>()->default_value(32), "Number of altitude bins")
+		("altitude_max", po::value<value_type>()->default_value(30), "Upper altitude in kilometers")
+		("intensity_min", po::value<value_type>()->default_value(1e-15), "Lower layer intensity")
+		("intensity_max", po::value<value_type>()->default_value(1e-12), "Upper layer intensity")
+		("probability", po::value<value_type>()->default_value(0.25), "Probability of a layer in a bin")
+		("seed", po::value<std::uint64_t>()->default_value(0), "Random seed")
+		("threads", po::value<std::size_t>()->default_value(0), "Number of threads, 0 for hardware concurrency")
+		("magnification", po::value<value_type>()->default_value(16.20), "Magnification ratio")
+		("profiles_filename", po::value<std::string>()->default_value("profiles.npy"), "Profiles output filename")
+		("indices_filename", po::value<std::string>()->default_value("indices.npy"), "Indices output filename")
+		("output_format", po::value<std::string>()->default_value("npy"), "Output format: csv, npy or raw")
+		("response_filename", po::value<std::vector<std::string>>()->required(), "Spectral response input filename");
+
+	try {
+		auto parsed = po::command_line_parser(argc, argv).options(opts).positional(pos_opts).run();
+		po::store(std::move(parsed), va);
+
+		if (va.count("help")) {
+			std::cerr << opts << std::endl;
+
+			return 1;
+		}
+
+		po::notify(va);
+
+		const auto count = va["count"].as<std::size_t>();
+		const auto bins = va["bins"].as<std::size_t>();
+		const auto altitude_max = va["altitude_max"].as<value_type>();
+		const auto intensity_min = va["intensity_min"].as<value_type>();
+		const auto intensity_max = va["intensity_max"].as<value_type>();
+		const auto probability = va["probability"].as<value_type>();
+		const auto seed = va["seed"].as<std::uint64_t>();
+		const auto threads = va["threads"].as<std::size_t>();
+		const auto magnification = va["magnification"].as<value_type>();
+		const auto profiles_filename = va["profiles_filename"].as<std::string>();
+		const auto indices_filename = va["indices_filename"].as<std::string>();
+		const auto output_format = output::parse_format(va["output_format"].as<std::string>());
+		const auto response_filename = va["response_filename"].as<std::vector<std::string>>();
+
+		constexpr std::array<float, 4> inner = {0.00, 1.30, 2.20, 3.90};
+		constexpr std::array<float, 4> outer = {1.27, 2.15, 3.85, 5.50};
+		constexpr auto wf_grid_size = 1024 + 1;
+
+		const auto [lambda, spectral_filter] = make_spectral_filter(response_filename);
+
+		std::vector<weif::weight_function<value_type>> wf;
+		wf.reserve(10);
+
+		for (std::size_t i = 0; i < inner.size(); ++i) {
+			for (std::size_t j = 0; j <= i; ++j) {
+				const auto aperture_filter = weif::af::cross_annular{outer[j] / outer[i], inner[i] / outer[i], inner[j] / outer[j]};
+				wf.emplace_back(spectral_filter, lambda, aperture_filter, outer[i] * magnification, wf_grid_size);
+			}
+		}
+
+		const auto t1 = std::chrono::high_resolution_clock::now();
+
+		const xt::xarray<value_type> edges = xt::linspace(static_cast<value_type>(0), altitude_max, bins + 1);
+		const weif::forward_model<value_type> model{wf, edges};
+		const weif::prior::log_uniform<value_type> prior{intensity_min, intensity_max, probability};
+
+		output::stream_writer<value_type> profiles_writer{profiles_filename, output_format, {bins}, count};
+		output::stream_writer<value_type> indices_writer{indices_filename, output_format, {wf.size()}, count};
+
+		model.generate_blocks(prior, count, [&] (std::size_t, const auto& profiles, const auto& indices) {
+			for (std::size_t i = 0; i < profiles.shape()[0]; ++i) {
+				profiles_writer.append(xt::view(profiles, i, xt::all()));
+				indices_writer.append(xt::view(indices, i, xt::all()));
+			}
+		}, seed, threads);
+
+		const auto t2 = std::chrono::high_resolution_clock::now();
+
+		std::cerr << "Consumed time: " << std::chrono::duration_cast<std::chrono::duration<value_type>>(t2-t1).count() << " sec" << std::endl;
+
+	} catch (const po::error& e) {
+		std::cerr << e.what() << std::endl;
+		std::cerr << opts << std::endl;
+
+		return 1;
+	}
+
+	return 0;
+}
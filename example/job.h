@@ -0,0 +1,344 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#ifndef _WEIF_EXAMPLE_JOB_H
+#define _WEIF_EXAMPLE_JOB_H
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include <weif/af/angle_averaged.h>
+#include <weif/af/circular.h>
+#include <weif/af/square.h>
+#include <weif/af/point.h>
+#include <weif/sf/mono.h>
+#include <weif/sf/poly.h>
+#include <weif/spectral_response.h>
+#include <weif/weight_function.h>
+#include <weif/weight_function_grid_2d.h>
+
+#include "output.h"
+
+
+/*
+ * Weight function job description and construction cache shared by the
+ * batch runner and the evaluation service
+ *
+ * A job is described by named string fields, empty fields take defaults:
+ *
+ *   output_filename      Output filename (batch runner only)
+ *   kind                 wf (default) or grid_2d
+ *   response_filename    Spectral response files separated by ';'
+ *   mono                 Monochromatic lambda instead of response_filename
+ *   carrier              Carrier wavelength for polychromatic filter
+ *   aperture             point, circular (default), annular or square
+ *   aperture_scale       Aperture scale, mm.
+ *   central_obscuration  Central obscuration for annular aperture
+ *   size                 wf: output altitude grid size (default 1024),
+ *                        grid_2d: number of altitudes in [0, 30] km.
+ *   altitude             grid_2d: single altitude, km. Overrides size.
+ *   grid_step            grid_2d: grid step, mm.
+ *   grid_size            grid_2d: grid size (default 121)
+ *   output_format        csv, npy or raw
+ */
+
+namespace jobs {
+
+using value_type = float;
+
+/* Thread-safe memoization: the first caller computes, others wait.
+ * Failed computations are not cached, waiting callers receive the
+ * exception and the next caller starts over. When the capacity is
+ * exceeded, the oldest computed entries are evicted, the callers keep
+ * their values. */
+template<class Key, class Value>
+class shared_cache {
+private:
+	std::mutex mutex_;
+	std::map<Key, std::shared_future<Value>> map_;
+	std::deque<Key> order_;
+	std::size_t capacity_;
+
+	/* Called with the mutex locked, pending entries are never evicted */
+	void evict() {
+		for (auto it = order_.begin(); map_.size() > capacity_ && it != order_.end(); ) {
+			const auto entry = map_.find(*it);
+
+			if (entry->second.wait_for(std::chrono::seconds::zero()) != std::future_status::ready) {
+				++it;
+				continue;
+			}
+
+			map_.erase(entry);
+			it = order_.erase(it);
+		}
+	}
+
+public:
+	explicit shared_cache(std::size_t capacity = std::numeric_limits<std::size_t>::max()):
+		capacity_{capacity} {}
+
+	template<class F>
+	Value get(const Key& key, F&& f) {
+		std::promise<Value> promise;
+		std::shared_future<Value> future;
+		bool inserted = false;
+
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+
+			auto [it, ok] = map_.try_emplace(key);
+			if (ok) {
+				it->second = promise.get_future().share();
+				order_.push_back(key);
+			}
+
+			future = it->second;
+			inserted = ok;
+
+			if (ok) {
+				evict();
+			}
+		}
+
+		if (!inserted) {
+			return future.get();
+		}
+
+		try {
+			promise.set_value(f());
+		} catch (...) {
+			/* Do not memoize the failure, the next caller retries */
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+
+				map_.erase(key);
+				order_.erase(std::find(order_.begin(), order_.end(), key));
+			}
+
+			promise.set_exception(std::current_exception());
+			throw;
+		}
+
+		return future.get();
+	}
+
+	std::size_t size() {
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		return map_.size();
+	}
+};
+
+struct job {
+	std::string output_filename;
+	std::string kind;
+	std::vector<std::string> response_filename;
+	std::optional<value_type> mono;
+	std::optional<value_type> carrier;
+	std::string aperture;
+	value_type aperture_scale;
+	value_type central_obscuration;
+	std::size_t size;
+	std::optional<value_type> altitude;
+	value_type grid_step;
+	std::size_t grid_size;
+	output::format output_format;
+};
+
+inline std::vector<std::string> split(const std::string& s, char delim) {
+	std::vector<std::string> ret;
+	std::istringstream stm(s);
+
+	for (std::string item; std::getline(stm, item, delim); ) {
+		if (!item.empty())
+			ret.push_back(item);
+	}
+
+	return ret;
+}
+
+/* Build and validate a job, field(name) returns the field value or an empty string */
+inline job make_job(const std::function<std::string(const std::string&)>& field, output::format default_format) {
+	const auto number = [&field] (const std::string& name) -> std::optional<value_type> {
+		const auto s = field(name);
+		if (s.empty())
+			return std::nullopt;
+
+		return static_cast<value_type>(std::stold(s));
+	};
+
+	const auto kind = field("kind");
+	const auto aperture = field("aperture");
+	const auto output_format = field("output_format");
+
+	job j{
+		field("output_filename"),
+		(kind.empty() ? "wf" : kind),
+		split(field("response_filename"), ';'),
+		number("mono"),
+		number("carrier"),
+		(aperture.empty() ? "circular" : aperture),
+		number("aperture_scale").value_or(20.574),
+		number("central_obscuration").value_or(0),
+		static_cast<std::size_t>(number("size").value_or(1024)),
+		number("altitude"),
+		number("grid_step").value_or(11),
+		static_cast<std::size_t>(number("grid_size").value_or(121)),
+		(output_format.empty() ? default_format : output::parse_format(output_format))};
+
+	if (j.kind != "wf" && j.kind != "grid_2d")
+		throw std::runtime_error("Unknown kind " + j.kind);
+	if (j.aperture != "point" && j.aperture != "circular" && j.aperture != "annular" && j.aperture != "square")
+		throw std::runtime_error("Unknown aperture " + j.aperture);
+	if (!j.mono && j.response_filename.empty())
+		throw std::runtime_error("Either mono or response_filename is required");
+
+	return j;
+}
+
+/*
+ * Constructed objects are shared between jobs with identical parameters:
+ * every response set is read and transformed once, and every weight
+ * function is built once. A long running service bounds the number of
+ * kept objects of every kind by the capacity.
+ */
+class cache {
+public:
+	using spectral_filter_type = std::variant<weif::sf::mono<value_type>, weif::sf::poly<value_type>>;
+	using spectral_value_type = std::shared_ptr<const std::pair<value_type, spectral_filter_type>>;
+	using wf_value_type = std::shared_ptr<const weif::weight_function<value_type>>;
+	using grid_2d_value_type = std::shared_ptr<const weif::weight_function_grid_2d<value_type>>;
+	using aa_value_type = std::shared_ptr<const weif::af::angle_averaged<value_type>>;
+
+private:
+	using spectral_key_type = std::tuple<std::vector<std::string>, std::optional<value_type>, std::optional<value_type>>;
+	using wf_key_type = std::tuple<spectral_key_type, std::string, value_type, value_type>;
+	using grid_2d_key_type = std::tuple<spectral_key_type, std::string, value_type, value_type, value_type, std::size_t>;
+
+	shared_cache<spectral_key_type, spectral_value_type> spectral_cache_;
+	shared_cache<std::size_t, aa_value_type> aa_cache_;
+	shared_cache<wf_key_type, wf_value_type> wf_cache_;
+	shared_cache<grid_2d_key_type, grid_2d_value_type> grid_2d_cache_;
+
+	static spectral_key_type spectral_key(const job& j) {
+		if (j.mono)
+			return {{}, j.mono, std::nullopt};
+
+		return {j.response_filename, std::nullopt, j.carrier};
+	}
+
+	aa_value_type square_filter() {
+		return aa_cache_.get(1024, [] () {
+			return std::make_shared<const weif::af::angle_averaged<value_type>>(weif::af::square<value_type>{}, 1024);
+		});
+	}
+
+public:
+	explicit cache(std::size_t capacity = std::numeric_limits<std::size_t>::max()):
+		spectral_cache_{capacity},
+		wf_cache_{capacity},
+		grid_2d_cache_{capacity} {}
+
+	spectral_value_type spectral_filter(const job& j) {
+		return spectral_cache_.get(spectral_key(j), [&j] () {
+			if (j.mono) {
+				return std::make_shared<const std::pair<value_type, spectral_filter_type>>(*j.mono, weif::sf::mono<value_type>{});
+			}
+
+			auto sr = weif::spectral_response<value_type>::stack_from_files(j.response_filename.cbegin(), j.response_filename.cend());
+			sr.normalize();
+
+			auto sf = [&] () {
+				if (j.carrier)
+					return weif::sf::poly{sr, 4096, *j.carrier};
+
+				return weif::sf::poly{sr, 4096};
+			} ();
+			const auto lambda = sf.equiv_lambda();
+			sf.normalize();
+
+			return std::make_shared<const std::pair<value_type, spectral_filter_type>>(lambda, std::move(sf));
+		});
+	}
+
+	wf_value_type weight_function(const job& j) {
+		const auto central_obscuration = (j.aperture == "annular" ? j.central_obscuration : 0);
+		const auto aperture_scale = (j.aperture == "point" ? 0 : j.aperture_scale);
+
+		return wf_cache_.get({spectral_key(j), j.aperture, aperture_scale, central_obscuration}, [&] () {
+			const auto entry = spectral_filter(j);
+			const auto& [lambda, filter] = *entry;
+
+			constexpr auto wf_grid_size = 1024 + 1;
+			const auto make = [&] (const auto& af) {
+				return std::visit([&] (const auto& sf) {
+					return std::make_shared<const weif::weight_function<value_type>>(sf, lambda, af, aperture_scale, wf_grid_size);
+				}, filter);
+			};
+
+			if (j.aperture == "point")
+				return make(weif::af::point<value_type>{});
+			if (j.aperture == "square")
+				return make(*square_filter());
+			if (j.aperture == "annular")
+				return make(weif::af::annular<value_type>{central_obscuration});
+
+			return make(weif::af::circular<value_type>{});
+		});
+	}
+
+	grid_2d_value_type weight_function_grid_2d(const job& j) {
+		const auto central_obscuration = (j.aperture == "annular" ? j.central_obscuration : 0);
+
+		return grid_2d_cache_.get({spectral_key(j), j.aperture, j.aperture_scale, central_obscuration, j.grid_step, j.grid_size}, [&] () {
+			const auto entry = spectral_filter(j);
+			const auto& [lambda, filter] = *entry;
+			const auto shape = std::array{j.grid_size, j.grid_size};
+
+			const auto make = [&] (const auto& af) {
+				return std::visit([&] (const auto& sf) {
+					return std::make_shared<const weif::weight_function_grid_2d<value_type>>(sf, lambda, af, j.aperture_scale, j.grid_step, shape);
+				}, filter);
+			};
+
+			if (j.aperture == "point")
+				return make(weif::af::point<value_type>{});
+			if (j.aperture == "square")
+				return make(weif::af::square<value_type>{});
+			if (j.aperture == "annular")
+				return make(weif::af::annular<value_type>{central_obscuration});
+
+			return make(weif::af::circular<value_type>{});
+		});
+	}
+
+	/* Number of constructed weight functions */
+	std::size_t size() {
+		return wf_cache_.size() + grid_2d_cache_.size();
+	}
+};
+
+} // jobs
+
+#endif // _WEIF_EXAMPLE_JOB_H
@@ -5,7 +5,6 @@
  */
 
 #include <chrono>
-#include <fstream>
 #include <iostream>
 #include <variant>
 #include <vector>
@@ -14,7 +13,6 @@
 
 #include <xtensor/containers/xarray.hpp>
 #include <xtensor/generators/xbuilder.hpp>
-#include <xtensor/io/xcsv.hpp>
 #include <xtensor/misc/xmanipulation.hpp>
 
 #include <weif/af/circular.h>
@@ -22,6 +20,8 @@
 #include <weif/spectral_response.h>
 #include <weif/weight_function.h>
 
+#include "output.h"
+
 
 using value_type = float;
 
@@ -51,6 +51,7 @@ int main(int argc, char** argv) {
 		("size", po::value<std::size_t>()->default_value(1024), "Output grid size")
 		("magnification", po::value<value_type>()->default_value(16.20), "Magnification ratio")
 		("output_filename", po::value<std::string>()->default_value("weights.dat"), "Output filename")
+		("output_format", po::value<std::string>()->default_value("csv"), "Output format: csv, npy or raw")
 		("response_filename", po::value<std::vector<std::string>>()->required(), "Spectral response input filename");
 
 	try {
@@ -68,6 +69,7 @@ int main(int argc, char** argv) {
 		const auto size = va["size"].as<std::size_t>();
 		const auto magnification = va["magnification"].as<value_type>();
 		const auto output_filename = va["output_filename"].as<std::string>();
+		const auto output_format = output::parse_format(va["output_format"].as<std::string>());
 		const auto response_filename = va["response_filename"].as<std::vector<std::string>>();
 
 		constexpr std::array<float, 4> inner = {0.00, 1.30, 2.20, 3.90};
@@ -94,8 +96,7 @@ int main(int argc, char** argv) {
 			}
 		}
 
-		std::ofstream stm(output_filename);
-		xt::dump_csv(stm, xt::transpose(xt::vstack(xt::xtuple(grid,
+		output::dump(output_filename, output_format, xt::transpose(xt::vstack(xt::xtuple(grid,
 			wf[0](grid),
 			wf[1](grid),
 			wf[2](grid),
@@ -0,0 +1,204 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#ifndef _WEIF_EXAMPLE_OUTPUT_H
+#define _WEIF_EXAMPLE_OUTPUT_H
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <boost/program_options/errors.hpp>
+
+#include <xtensor/containers/xarray.hpp>
+#include <xtensor/core/xeval.hpp>
+#include <xtensor/io/xcsv.hpp>
+#include <xtensor/io/xnpy.hpp>
+
+
+/*
+ * Output helpers shared by the example tools
+ *
+ * Besides text CSV, the results may be written as NumPy .npy files or as
+ * raw little-endian arrays accompanied by a sidecar "<filename>.hdr"
+ * text header listing dtype, shape and order. Binary formats are much
+ * faster to write and read back than CSV for large grids.
+ */
+
+namespace output {
+
+enum class format {
+	csv,
+	npy,
+	raw
+};
+
+inline format parse_format(const std::string& s) {
+	if (s == "csv")
+		return format::csv;
+	if (s == "npy")
+		return format::npy;
+	if (s == "raw")
+		return format::raw;
+
+	throw boost::program_options::invalid_option_value(s);
+}
+
+namespace detail {
+
+/* NumPy dtype description, i.e. "<f4" for little-endian float */
+template<class T>
+std::string dtype() {
+	static_assert(std::is_floating_point_v<T>, "type T is not supported");
+
+	return "<f" + std::to_string(sizeof(T));
+}
+
+template<class T>
+void write_le(std::ostream& stm, const T* data, std::size_t size) {
+	if constexpr (std::endian::native == std::endian::little) {
+		stm.write(reinterpret_cast<const char*>(data), size * sizeof(T));
+	} else {
+		std::vector<char> buf(size * sizeof(T));
+		const auto* src = reinterpret_cast<const char*>(data);
+
+		for (std::size_t i = 0; i < size; ++i) {
+			std::reverse_copy(src + i * sizeof(T), src + (i + 1) * sizeof(T), buf.data() + i * sizeof(T));
+		}
+
+		stm.write(buf.data(), buf.size());
+	}
+}
+
+/* NumPy format version 1.0 header for C-ordered array */
+template<class T>
+void write_npy_header(std::ostream& stm, const std::vector<std::size_t>& shape) {
+	std::string dims;
+	for (const auto d: shape) {
+		dims += std::to_string(d) + ", ";
+	}
+	if (shape.size() > 1) {
+		dims.resize(dims.size() - 2);
+	} else {
+		dims.resize(dims.size() - 1);
+	}
+
+	std::string dict = "{'descr': '" + dtype<T>() + "', 'fortran_order': False, 'shape': (" + dims + "), }";
+
+	/* Magic, version and length take 10 bytes, total header size is a multiple of 64 */
+	const std::size_t unpadded = 10 + dict.size() + 1;
+	dict.append((64 - unpadded % 64) % 64, ' ');
+	dict.push_back('\n');
+
+	const auto len = static_cast<std::uint16_t>(dict.size());
+	const char preamble[] = {'\x93', 'N', 'U', 'M', 'P', 'Y', '\x01', '\x00',
+		static_cast<char>(len & 0xff), static_cast<char>(len >> 8)};
+
+	stm.write(preamble, sizeof(preamble));
+	stm.write(dict.data(), dict.size());
+}
+
+template<class T>
+void write_raw_header(const std::string& filename, const std::vector<std::size_t>& shape) {
+	std::ofstream stm(filename + ".hdr");
+
+	stm << "dtype " << dtype<T>() << std::endl;
+	stm << "shape";
+	for (const auto d: shape) {
+		stm << ' ' << d;
+	}
+	stm << std::endl;
+	stm << "order C" << std::endl;
+}
+
+} // detail
+
+/* Write the whole array in given format */
+template<class E>
+void dump(const std::string& filename, format fmt, const xt::xexpression<E>& e) {
+	const auto& a = xt::eval(e.derived_cast());
+
+	switch (fmt) {
+	case format::npy: {
+		xt::dump_npy(filename, a);
+	} break;
+	case format::raw: {
+		using value_type = typename std::decay_t<decltype(a)>::value_type;
+
+		std::ofstream stm(filename, std::ios::binary);
+		detail::write_le(stm, a.data(), a.size());
+		detail::write_raw_header<value_type>(filename, std::vector<std::size_t>(a.shape().cbegin(), a.shape().cend()));
+	} break;
+	default: {
+		std::ofstream stm(filename);
+		xt::dump_csv(stm, a);
+	} break;
+	}
+}
+
+/*
+ * Streaming writer for a stack of equally shaped slices
+ *
+ * The resulting array has shape (count, slice_shape...), only a single
+ * slice is kept in memory at a time. CSV output concatenates the 2D
+ * slices row-wise.
+ */
+template<class T>
+class stream_writer {
+public:
+	using value_type = T;
+
+private:
+	std::ofstream stm_;
+	format format_;
+	std::vector<std::size_t> slice_shape_;
+	std::size_t slice_size_;
+
+public:
+	stream_writer(const std::string& filename, format fmt, const std::vector<std::size_t>& slice_shape, std::size_t count):
+		stm_{filename, (fmt == format::csv ? std::ios::out : std::ios::out | std::ios::binary)},
+		format_{fmt},
+		slice_shape_{slice_shape},
+		slice_size_{std::accumulate(slice_shape.cbegin(), slice_shape.cend(), std::size_t{1}, std::multiplies<std::size_t>{})} {
+
+		std::vector<std::size_t> shape{count};
+		shape.insert(shape.end(), slice_shape.cbegin(), slice_shape.cend());
+
+		if (format_ == format::npy) {
+			detail::write_npy_header<value_type>(stm_, shape);
+		} else if (format_ == format::raw) {
+			detail::write_raw_header<value_type>(filename, shape);
+		}
+	}
+
+	template<class E>
+	void append(const xt::xexpression<E>& e) {
+		xt::xarray<value_type> slice = e.derived_cast();
+
+		if (slice.size() != slice_size_)
+			throw std::runtime_error("Slice shape mismatch");
+
+		if (format_ == format::csv) {
+			const auto rows = (slice_shape_.size() > 1 ? slice_shape_.front() : std::size_t{1});
+
+			slice.reshape({rows, slice_size_ / rows});
+			xt::dump_csv(stm_, slice);
+		} else {
+			detail::write_le(stm_, slice.data(), slice.size());
+		}
+	}
+};
+
+} // output
+
+#endif // _WEIF_EXAMPLE_OUTPUT_H
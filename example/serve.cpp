@@ -0,0 +1,319 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <boost/program_options.hpp>
+
+#include <xtensor/containers/xadapt.hpp>
+#include <xtensor/containers/xtensor.hpp>
+#include <xtensor/generators/xbuilder.hpp>
+#include <xtensor/views/xview.hpp>
+
+#include "job.h"
+
+
+/*
+ * Local weight function evaluation service
+ *
+ * Listens on a Unix domain socket and evaluates weight_function and
+ * weight_function_grid_2d for the clients. Constructed objects are kept
+ * in a cache shared by all connections, so only the first request for a
+ * configuration pays the construction cost.
+ *
+ * A connection carries any number of request frames, each one answered
+ * by a response frame. Integers and floats are in the host byte order.
+ *
+ * Request frame:
+ *   uint32  magic, 0x46494557
+ *   uint32  configuration length in bytes
+ *   uint32  number of altitudes
+ *   char[]  configuration: "name=value" lines with the job fields
+ *           described in job.h (kind, response_filename, aperture, ...)
+ *   float[] altitudes, km.
+ *
+ * Response frame:
+ *   uint32  magic, 0x46494557
+ *   uint32  status: 0 on success, 1 on error
+ *   uint64  payload length: number of floats on success, number of
+ *           bytes of the error message otherwise
+ *   payload wf: one value per altitude,
+ *           grid_2d: (grid_size, grid_size) array per altitude,
+ *           or the error message
+ *
+ * The sizes are limited before anything is allocated: a frame with a
+ * too long configuration or too many altitudes closes the connection,
+ * a too large grid is reported as an error. At most cache_capacity
+ * constructed objects of every kind are kept.
+ */
+
+using jobs::value_type;
+
+namespace {
+
+constexpr std::uint32_t magic = 0x46494557;
+
+constexpr std::uint32_t max_config_length = 64 * 1024;
+constexpr std::uint32_t max_count = 1024 * 1024;
+constexpr std::size_t max_grid_size = 1024;
+constexpr std::size_t max_response_values = 64 * 1024 * 1024;
+constexpr std::size_t cache_capacity = 64;
+
+struct request_header {
+	std::uint32_t magic;
+	std::uint32_t config_length;
+	std::uint32_t count;
+};
+
+struct response_header {
+	std::uint32_t magic;
+	std::uint32_t status;
+	std::uint64_t length;
+};
+
+/* Returns false on orderly shutdown before the first byte */
+bool read_all(int fd, void* buf, std::size_t size) {
+	auto* p = static_cast<char*>(buf);
+
+	for (std::size_t done = 0; done < size; ) {
+		const auto ret = ::recv(fd, p + done, size - done, 0);
+
+		if (ret == 0) {
+			if (done == 0)
+				return false;
+
+			throw std::runtime_error("Unexpected end of stream");
+		}
+
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+
+			throw std::system_error(errno, std::generic_category(), "recv");
+		}
+
+		done += ret;
+	}
+
+	return true;
+}
+
+void write_all(int fd, const void* buf, std::size_t size) {
+	const auto* p = static_cast<const char*>(buf);
+
+	for (std::size_t done = 0; done < size; ) {
+		const auto ret = ::send(fd, p + done, size - done, MSG_NOSIGNAL);
+
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+
+			throw std::system_error(errno, std::generic_category(), "send");
+		}
+
+		done += ret;
+	}
+}
+
+jobs::job parse_config(const std::string& config) {
+	std::map<std::string, std::string> fields;
+	std::istringstream stm(config);
+
+	for (std::string line; std::getline(stm, line); ) {
+		const auto pos = line.find('=');
+		if (pos == std::string::npos)
+			continue;
+
+		fields[line.substr(0, pos)] = line.substr(pos + 1);
+	}
+
+	return jobs::make_job([&fields] (const std::string& name) -> std::string {
+		const auto it = fields.find(name);
+
+		return (it == fields.end() ? std::string{} : it->second);
+	}, output::format::csv);
+}
+
+class server {
+private:
+	jobs::cache cache_{cache_capacity};
+	std::mutex log_mutex_;
+
+	void respond(int fd, const jobs::job& j, const std::vector<value_type>& altitudes) {
+		if (j.kind == "grid_2d") {
+			if (j.grid_size > max_grid_size || altitudes.size() * j.grid_size * j.grid_size > max_response_values)
+				throw std::runtime_error("Grid is too large");
+
+			const auto wf = cache_.weight_function_grid_2d(j);
+
+			/* Evaluate everything before the header, so a failure is still reported by respond_error() */
+			xt::xtensor<value_type, 3> res = xt::empty<value_type>({altitudes.size(), j.grid_size, j.grid_size});
+			for (std::size_t i = 0; i < altitudes.size(); ++i) {
+				xt::view(res, i) = (*wf)(altitudes[i]);
+			}
+
+			const response_header header{magic, 0, res.size()};
+
+			write_all(fd, &header, sizeof(header));
+			write_all(fd, res.data(), res.size() * sizeof(value_type));
+
+			return;
+		}
+
+		const auto wf = cache_.weight_function(j);
+		const xt::xtensor<value_type, 1> res = (*wf)(xt::adapt(altitudes, {altitudes.size()}));
+		const response_header header{magic, 0, res.size()};
+
+		write_all(fd, &header, sizeof(header));
+		write_all(fd, res.data(), res.size() * sizeof(value_type));
+	}
+
+	void respond_error(int fd, const std::string& message) {
+		const response_header header{magic, 1, message.size()};
+
+		write_all(fd, &header, sizeof(header));
+		write_all(fd, message.data(), message.size());
+	}
+
+	void log(const std::string& message) {
+		std::lock_guard<std::mutex> lock(log_mutex_);
+
+		std::cerr << message << std::endl;
+	}
+
+public:
+	void serve(int fd) {
+		try {
+			for (request_header header; read_all(fd, &header, sizeof(header)); ) {
+				if (header.magic != magic)
+					throw std::runtime_error("Bad frame magic");
+				if (header.config_length > max_config_length || header.count > max_count)
+					throw std::runtime_error("Frame is too large");
+
+				std::string config(header.config_length, '\0');
+				std::vector<value_type> altitudes(header.count);
+
+				if (!read_all(fd, config.data(), config.size()) || !read_all(fd, altitudes.data(), altitudes.size() * sizeof(value_type)))
+					throw std::runtime_error("Unexpected end of stream");
+
+				try {
+					respond(fd, parse_config(config), altitudes);
+				} catch (const std::system_error&) {
+					throw;
+				} catch (const std::exception& e) {
+					respond_error(fd, e.what());
+				}
+			}
+		} catch (const std::exception& e) {
+			log(std::string{"Connection closed: "} + e.what());
+		}
+
+		::close(fd);
+	}
+};
+
+} // namespace
+
+
+int main(int argc, char** argv) {
+	namespace po = boost::program_options;
+
+	po::options_description opts;
+	po::positional_options_description pos_opts;
+	po::variables_map va;
+
+	opts.add_options()
+		("help", "Produce help message")
+		("socket", po::value<std::string>()->default_value("weif.sock"), "Unix domain socket path");
+
+	try {
+		auto parsed = po::command_line_parser(argc, argv).options(opts).positional(pos_opts).run();
+		po::store(std::move(parsed), va);
+
+		if (va.count("help")) {
+			std::cerr << opts << std::endl;
+
+			return 1;
+		}
+
+		po::notify(va);
+
+		const auto socket_path = va["socket"].as<std::string>();
+
+		sockaddr_un addr{};
+		addr.sun_family = AF_UNIX;
+		if (socket_path.size() >= sizeof(addr.sun_path)) {
+			std::cerr << "Socket path is too long" << std::endl;
+
+			return 1;
+		}
+		std::strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+
+		const int listen_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+		if (listen_fd < 0) {
+			std::cerr << "socket: " << std::strerror(errno) << std::endl;
+
+			return 1;
+		}
+
+		::unlink(socket_path.c_str());
+		if (::bind(listen_fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) < 0 || ::listen(listen_fd, SOMAXCONN) < 0) {
+			std::cerr << socket_path << ": " << std::strerror(errno) << std::endl;
+
+			return 1;
+		}
+
+		std::signal(SIGPIPE, SIG_IGN);
+		std::cerr << "Listening on " << socket_path << std::endl;
+
+		/* Detached connection threads share the ownership of the server */
+		const auto srv = std::make_shared<server>();
+
+		for (;;) {
+			const int fd = ::accept(listen_fd, nullptr, nullptr);
+			if (fd < 0) {
+				if (errno == EINTR || errno == ECONNABORTED)
+					continue;
+
+				std::cerr << "accept: " << std::strerror(errno) << std::endl;
+
+				break;
+			}
+
+			std::thread([srv, fd] () { srv->serve(fd); }).detach();
+		}
+
+		::close(listen_fd);
+		::unlink(socket_path.c_str());
+
+	} catch (const po::error& e) {
+		std::cerr << e.what() << std::endl;
+		std::cerr << opts << std::endl;
+
+		return 1;
+	}
+
+	return 0;
+}
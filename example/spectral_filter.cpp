@@ -4,7 +4,6 @@
  * Copyright (C) 2022-2023  Matwey V. Kornilov <matwey.kornilov@gmail.com>
  */
 
-#include <fstream>
 #include <iostream>
 #include <string>
 
@@ -12,11 +11,12 @@
 
 #include <xtensor/containers/xarray.hpp> // IWYU pragma: keep
 #include <xtensor/generators/xbuilder.hpp>
-#include <xtensor/io/xcsv.hpp>
 #include <xtensor/misc/xmanipulation.hpp>
 
 #include <weif/sf/poly.h>
 
+#include "output.h"
+
 
 using value_type = float;
 
@@ -32,7 +32,8 @@ int main(int argc, char** argv) {
 		("normalize", "Normalize the filter")
 		("carrier", po::value<value_type>(), "Carrier wavelength")
 		("response_filename", po::value<std::vector<std::string>>()->required(), "Spectral response input filename")
-		("filter_filename", po::value<std::string>(), "Spectral filter output filename");
+		("filter_filename", po::value<std::string>(), "Spectral filter output filename")
+		("output_format", po::value<std::string>()->default_value("csv"), "Output format: csv, npy or raw");
 
 	pos_opts.add("filter_filename", 1);
 
@@ -43,6 +44,7 @@ int main(int argc, char** argv) {
 
 		const auto response_filename = va["response_filename"].as<std::vector<std::string>>();
 		const auto filter_filename   = va["filter_filename"].as<std::string>();
+		const auto output_format = output::parse_format(va["output_format"].as<std::string>());
 		const auto size = va["size"].as<std::size_t>();
 		const std::optional<value_type> carrier{va.count("carrier") ? std::optional(va["carrier"].as<value_type>()) : std::nullopt};
 
@@ -65,8 +67,7 @@ int main(int argc, char** argv) {
 
 		xt::xarray<value_type> grid = xt::linspace(static_cast<value_type>(0), static_cast<value_type>(5), size);
 
-		std::ofstream stm(filter_filename);
-		xt::dump_csv(stm, xt::transpose(xt::vstack(xt::xtuple(grid, sf(xt::square(grid)), sf.regular(xt::square(grid))))));
+		output::dump(filter_filename, output_format, xt::transpose(xt::vstack(xt::xtuple(grid, sf(xt::square(grid)), sf.regular(xt::square(grid))))));
 
 	} catch (const po::error& e) {
 		std::cerr << e.what() << std::endl;
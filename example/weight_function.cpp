@@ -5,7 +5,6 @@
  */
 
 #include <chrono>
-#include <fstream>
 #include <iostream>
 #include <variant>
 #include <vector>
@@ -14,7 +13,6 @@
 
 #include <xtensor/containers/xarray.hpp>
 #include <xtensor/generators/xbuilder.hpp>
-#include <xtensor/io/xcsv.hpp>
 #include <xtensor/misc/xmanipulation.hpp>
 
 #include <weif/af/angle_averaged.h>
@@ -26,6 +24,8 @@
 #include <weif/spectral_response.h>
 #include <weif/weight_function.h>
 
+#include "output.h"
+
 
 using value_type = float;
 
@@ -81,6 +81,7 @@ int main(int argc, char** argv) {
 		("aperture_scale", po::value<value_type>()->default_value(20.574), "Aperture scale, mm.")
 		("central_obscuration", po::value<value_type>()->default_value(0.0), "Central obscuration")
 		("output_filename", po::value<std::string>()->default_value("wf.dat"), "Output filename")
+		("output_format", po::value<std::string>()->default_value("csv"), "Output format: csv, npy or raw")
 		("response_filename", po::value<std::vector<std::string>>()->required(), "Spectral response input filename")
 		("square", "Use square aperture filter")
 		("carrier", po::value<value_type>(), "Carrier wavelength")
@@ -102,6 +103,7 @@ int main(int argc, char** argv) {
 		const auto aperture_scale = va["aperture_scale"].as<value_type>();
 		const auto central_obscuration = va["central_obscuration"].as<value_type>();
 		const auto output_filename = va["output_filename"].as<std::string>();
+		const auto output_format = output::parse_format(va["output_format"].as<std::string>());
 		const auto response_filename = va["response_filename"].as<std::vector<std::string>>();
 		const bool square = va.count("square");
 		const std::optional<value_type> carrier{
@@ -125,8 +127,7 @@ int main(int argc, char** argv) {
 
 		const auto t2 = std::chrono::high_resolution_clock::now();
 
-		std::ofstream stm(output_filename);
-		xt::dump_csv(stm, xt::transpose(xt::vstack(xt::xtuple(grid, wf(grid)))));
+		output::dump(output_filename, output_format, xt::transpose(xt::vstack(xt::xtuple(grid, wf(grid)))));
 
 		std::cerr << "Consumed time: " << std::chrono::duration_cast<std::chrono::duration<value_type>>(t2-t1).count() << " sec" << std::endl;
 
@@ -5,7 +5,6 @@
  */
 
 #include <chrono>
-#include <fstream>
 #include <iostream>
 #include <variant>
 #include <vector>
@@ -14,7 +13,6 @@
 
 #include <xtensor/containers/xarray.hpp>
 #include <xtensor/generators/xbuilder.hpp>
-#include <xtensor/io/xcsv.hpp>
 #include <xtensor/misc/xmanipulation.hpp>
 
 #include <weif/af/circular.h>
@@ -25,6 +23,8 @@
 #include <weif/spectral_response.h>
 #include <weif/weight_function_grid_2d.h>
 
+#include "output.h"
+
 
 using value_type = float;
 
@@ -75,6 +75,8 @@ int main(int argc, char** argv) {
 		("output_filename", po::value<std::string>()->default_value("wf.dat"), "Output filename")
 		("response_filename", po::value<std::vector<std::string>>()->required(), "Spectral response input filename")
 		("altitude", po::value<value_type>()->default_value(2), "Altitude, km.")
+		("altitudes", po::value<std::size_t>(), "Number of altitudes in range [0, 30] km. Overrides --altitude and writes (altitudes, grid_size, grid_size) array")
+		("output_format", po::value<std::string>()->default_value("csv"), "Output format: csv, npy or raw")
 		("mono", po::value<value_type>(), "Use monochromatic spectral filter with given labmda");
 
 	try {
@@ -96,6 +98,7 @@ int main(int argc, char** argv) {
 		const auto output_filename = va["output_filename"].as<std::string>();
 		const auto response_filename = va["response_filename"].as<std::vector<std::string>>();
 		const auto altitude = va["altitude"].as<value_type>();
+		const auto output_format = output::parse_format(va["output_format"].as<std::string>());
 
 		const auto [lambda, spectral_filter] = make_spectral_filter(
 			response_filename,
@@ -114,8 +117,18 @@ int main(int argc, char** argv) {
 
 		const auto t2 = std::chrono::high_resolution_clock::now();
 
-		std::ofstream stm(output_filename);
-		xt::dump_csv(stm, wf(altitude));
+		if (va.count("altitudes")) {
+			/* Write altitude by altitude, the whole cube is never kept in memory */
+			const auto altitudes = va["altitudes"].as<std::size_t>();
+			const xt::xarray<value_type> altitude_grid = xt::linspace(static_cast<value_type>(0), static_cast<value_type>(30), altitudes);
+
+			output::stream_writer<value_type> writer{output_filename, output_format, {grid_size, grid_size}, altitudes};
+			for (std::size_t i = 0; i < altitudes; ++i) {
+				writer.append(wf(altitude_grid(i)));
+			}
+		} else {
+			output::dump(output_filename, output_format, wf(altitude));
+		}
 
 		std::cerr << "Consumed time: " << std::chrono::duration_cast<std::chrono::duration<value_type>>(t2-t1).count() << " sec" << std::endl;
 
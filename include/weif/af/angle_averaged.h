@@ -8,11 +8,14 @@
 #define _WEIF_AF_ANGLE_AVERAGED_H
 
 #include <cstdlib>
+#include <memory>
 #include <utility>
 
 #include <boost/math/quadrature/tanh_sinh.hpp>
 
 #include <weif/detail/cubic_spline.h>
+#include <weif/progress_token.h>
+#include <weif/quadrature_statistics.h>
 #include <weif/uniform_grid.h>
 #include <weif_export.h>
 
@@ -28,21 +31,27 @@ public:
 private:
 	uniform_grid<value_type> grid_;
 	detail::cubic_spline<value_type> af_;
+	std::shared_ptr<const quadrature_statistics<value_type>> statistics_;
 
 	template<class AF>
-	static auto integrate_aperture_function(AF&& aperture_filter, std::size_t size) {
+	static auto integrate_aperture_function(AF&& aperture_filter, std::size_t size, quadrature_statistics<value_type>* statistics, progress_token* progress) {
 		using boost::math::quadrature::tanh_sinh;
 
 		auto integrator = std::make_unique<tanh_sinh<value_type>>();
 
+		if (progress) {
+			progress->expect(size);
+		}
+
 		return xt::make_lambda_xfunction([
 			integrator = std::move(integrator),
-			aperture_filter = std::forward<AF>(aperture_filter)] (value_type z) -> value_type {
+			aperture_filter = std::forward<AF>(aperture_filter),
+			statistics,
+			progress] (value_type z) -> value_type {
 
 			const auto tol = std::pow(std::numeric_limits<value_type>::epsilon(), static_cast<value_type>(2.0/3.0));
 			const auto u = (static_cast<value_type>(1) - z) / z;
-
-			return integrator->integrate([u, &aperture_filter] (value_type phi, value_type theta) noexcept {
+			const auto ret = detail::integrate_node(*integrator, [u, &aperture_filter] (value_type phi, value_type theta) noexcept {
 				using namespace std;
 				using namespace boost::math;
 
@@ -56,19 +65,28 @@ private:
 				const auto uy = u * s;
 
 				return aperture_filter(ux, uy);
-			}, tol) / 2;
+			}, tol, z, statistics) / 2;
+
+			if (progress) {
+				progress->advance();
+			}
+
+			return ret;
 		}, xt::linspace(static_cast<value_type>(0), static_cast<value_type>(1), size));
 	}
 
 	template<class E>
-	explicit angle_averaged(const xt::xexpression<E>& values):
+	angle_averaged(const xt::xexpression<E>& values, std::shared_ptr<const quadrature_statistics<value_type>> statistics):
 		grid_{static_cast<value_type>(0), static_cast<value_type>(1) / (values.derived_cast().size() - 1), values.derived_cast().size()},
-		af_{values, detail::first_order_boundary<value_type>{0, 0}} {}
+		af_{values, detail::first_order_boundary<value_type>{0, 0}},
+		statistics_{std::move(statistics)} {}
 
 public:
 	template<class AF>
-	angle_averaged(AF&& aperture_filter, std::size_t size):
-		angle_averaged(integrate_aperture_function(std::forward<AF>(aperture_filter), size)) {}
+	angle_averaged(AF&& aperture_filter, std::size_t size, const std::shared_ptr<quadrature_statistics<value_type>>& statistics = nullptr, progress_token* progress = nullptr):
+		angle_averaged(integrate_aperture_function(std::forward<AF>(aperture_filter), size, statistics.get(), progress), statistics) {}
+
+	const auto& statistics() const noexcept { return statistics_; }
 
 	value_type operator() (value_type u) const noexcept {
 		const value_type z = (static_cast<value_type>(1) / (static_cast<value_type>(1) + u) - grid_.origin()) / grid_.delta();
@@ -93,6 +111,10 @@ public:
 
 template<class AF>
 angle_averaged(AF&&, std::size_t) -> angle_averaged<typename std::decay_t<AF>::value_type>;
+template<class AF, class S>
+angle_averaged(AF&&, std::size_t, S&&) -> angle_averaged<typename std::decay_t<AF>::value_type>;
+template<class AF, class S>
+angle_averaged(AF&&, std::size_t, S&&, progress_token*) -> angle_averaged<typename std::decay_t<AF>::value_type>;
 
 } // af
 } // weif
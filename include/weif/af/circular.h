@@ -8,8 +8,12 @@
 #define _WEIF_AF_CIRCULAR_H
 
 #include <cmath>
+#include <cstddef>
+#include <limits>
 #include <type_traits>
 
+#include <boost/math/special_functions/bessel.hpp>
+
 #include <xtensor/core/xmath.hpp>
 #include <xtensor/utils/xutils.hpp>
 #include <xtensor/core/xvectorize.hpp>
@@ -67,6 +71,74 @@ struct WEIF_EXPORT circular {
 		return this->operator()(std::hypot(ux, uy));
 	}
 
+	/**
+	 * @brief Taylor coefficient of circular aperture filter
+	 *
+	 * Evaluates the coefficient of \f$ u^{2n} \f$ in the expansion
+	 * \f[
+	 * A(u) = \sum_{n \ge 0} \frac{(-1)^n (2n + 2)!}{n! (n + 2)! ((n + 1)!)^2} \left(\frac{\pi u}{2}\right)^{2n}.
+	 * \f]
+	 *
+	 * @param n Half of the power of \f$ u \f$
+	 * @return Taylor coefficient
+	 */
+	value_type taylor(std::size_t n) const noexcept {
+		constexpr auto PI = xt::numeric_constants<value_type>::PI;
+
+		value_type ret = 1;
+		for (std::size_t j = 0; j < n; ++j) {
+			ret *= -PI * PI * static_cast<value_type>(2 * j + 3) / static_cast<value_type>(2 * (j + 1) * (j + 2) * (j + 3));
+		}
+
+		return ret;
+	}
+
+	/**
+	 * @brief Mellin transform of circular aperture filter
+	 *
+	 * Evaluates the analytic continuation of
+	 * \f[
+	 * \int_0^{\infty} u^{s - 1} A(u) du =
+	 * \frac{2 \Gamma\left(\frac{3 - s}{2}\right) \Gamma\left(\frac{s}{2}\right)}{\pi^{s + 1/2} \Gamma\left(2 - \frac{s}{2}\right) \Gamma\left(3 - \frac{s}{2}\right)},
+	 * \f]
+	 * that converges for \f$ 0 < s < 3 \f$.
+	 *
+	 * @param s Mellin transform argument
+	 * @return Mellin transform value
+	 */
+	value_type mellin(value_type s) const noexcept {
+		using namespace std;
+
+		constexpr auto PI = xt::numeric_constants<value_type>::PI;
+
+		return 2 * pow(PI, -s) * tgamma((3 - s) / 2) * tgamma(s / 2) / (sqrt(PI) * tgamma(2 - s / 2) * tgamma(3 - s / 2));
+	}
+
+	/**
+	 * @brief Large frequency coefficient of circular aperture filter
+	 *
+	 * Evaluates the coefficient of \f$ u^{-3-2n} \f$ in the asymptotic
+	 * expansion of the non-oscillating part of \f$ A(u) \f$ at large
+	 * \f$ u \f$, the leading one is \f$ 4 / \pi^4 \f$.
+	 *
+	 * @param n Index of the term
+	 * @return Asymptotic coefficient
+	 */
+	value_type tail(std::size_t n) const noexcept {
+		using namespace std;
+
+		constexpr auto PI = xt::numeric_constants<value_type>::PI;
+
+		const auto s = static_cast<value_type>(3 + 2 * n);
+
+		value_type ret = 4 * pow(PI, -s) * tgamma(s / 2) / (sqrt(PI) * tgamma(2 - s / 2) * tgamma(3 - s / 2));
+		for (std::size_t j = 1; j <= n; ++j) {
+			ret /= -static_cast<value_type>(j);
+		}
+
+		return ret;
+	}
+
 
 	/**
 	 * @brief Call operator for circular aperture filter with tensor input (radial coordinates)
@@ -168,6 +240,137 @@ public:
 		return std::pow(value, 2) / norm;
 	}
 
+	/**
+	 * @brief Derivative of annular aperture filter with respect to the obscuration
+	 *
+	 * Evaluates
+	 * \f[
+	 * \frac{\partial A}{\partial \epsilon} = \frac{4 \epsilon v}{(1 - \epsilon^2)^2} \left(\frac{v}{1 - \epsilon^2} - J_0(\pi \epsilon u)\right),
+	 * \f]
+	 * where \f$ v = \mathrm{jinc}_1(\pi u) - \epsilon^2 \mathrm{jinc}_1(\pi \epsilon u) \f$.
+	 *
+	 * @param u Dimensionless spatial frequency magnitude
+	 * @return Derivative of aperture filter value at specified frequency
+	 *
+	 * @see weight_function_sensitivity
+	 */
+	value_type derivative(value_type u) const noexcept {
+		if (obscuration() == static_cast<value_type>(0))
+			return static_cast<value_type>(0);
+
+		const auto norm = static_cast<value_type>(1) - std::pow(obscuration(), 2);
+		const auto piu = xt::numeric_constants<value_type>::PI * u;
+		const auto value = math::jinc_pi(piu) - std::pow(obscuration(), 2) * math::jinc_pi(obscuration() * piu);
+
+		return 4 * obscuration() * value / std::pow(norm, 2) * (value / norm - boost::math::cyl_bessel_j(0, obscuration() * piu));
+	}
+
+	/**
+	 * @brief Taylor coefficient of annular aperture filter
+	 *
+	 * Evaluates the coefficient of \f$ u^{2n} \f$ in the expansion of
+	 * \f$ A(u) \f$ as the Cauchy product of the series for
+	 * \f$ \mathrm{jinc}_1(\pi u) - \epsilon^2 \mathrm{jinc}_1(\pi \epsilon u) \f$.
+	 *
+	 * @param n Half of the power of \f$ u \f$
+	 * @return Taylor coefficient
+	 */
+	value_type taylor(std::size_t n) const noexcept {
+		using namespace std;
+
+		constexpr auto PI = xt::numeric_constants<value_type>::PI;
+
+		const auto eps2 = pow(obscuration(), 2);
+		const auto coefficient = [eps2] (std::size_t j) {
+			value_type ret = (1 - pow(eps2, static_cast<value_type>(j + 1))) / (1 - eps2);
+
+			for (std::size_t i = 1; i <= j; ++i) {
+				ret *= -PI * PI / static_cast<value_type>(4 * i * (i + 1));
+			}
+
+			return ret;
+		};
+
+		value_type ret = 0;
+		for (std::size_t j = 0; j <= n; ++j) {
+			ret += coefficient(j) * coefficient(n - j);
+		}
+
+		return ret;
+	}
+
+	/**
+	 * @brief Mellin transform of annular aperture filter
+	 *
+	 * Evaluates the analytic continuation of
+	 * \f$ \int_0^{\infty} u^{s - 1} A(u) du \f$, that converges for
+	 * \f$ 0 < s < 3 \f$. The transform of the cross term is given by the
+	 * Weber-Schafheitlin integral
+	 * \f[
+	 * \int_0^{\infty} u^{s - 1} \mathrm{jinc}_1(\pi u) \mathrm{jinc}_1(\pi \epsilon u) du =
+	 * \frac{4 \Gamma\left(\frac{s}{2}\right)}{\pi^s 2^{3 - s} \Gamma\left(2 - \frac{s}{2}\right)}
+	 * {}_2F_1\left(\frac{s}{2}, \frac{s}{2} - 1; 2; \epsilon^2\right).
+	 * \f]
+	 *
+	 * @param s Mellin transform argument
+	 * @return Mellin transform value
+	 *
+	 * @see circular::mellin()
+	 */
+	value_type mellin(value_type s) const noexcept {
+		using namespace std;
+
+		constexpr auto PI = xt::numeric_constants<value_type>::PI;
+
+		const auto circular_mellin = circular<value_type>{}.mellin(s);
+
+		if (obscuration() == static_cast<value_type>(0))
+			return circular_mellin;
+
+		const auto eps2 = pow(obscuration(), 2);
+		const auto a = s / 2;
+		const auto b = s / 2 - 1;
+
+		/* The hypergeometric series converges for \epsilon < 1 */
+		value_type hypergeometric = 1;
+		value_type term = 1;
+		for (std::size_t n = 0; n < 100000; ++n) {
+			term *= (a + n) * (b + n) / ((2 + n) * (n + 1)) * eps2;
+			hypergeometric += term;
+
+			if (abs(term) <= std::numeric_limits<value_type>::epsilon() * abs(hypergeometric))
+				break;
+		}
+
+		const auto cross = 4 * pow(PI, -s) * tgamma(s / 2) / (pow(static_cast<value_type>(2), 3 - s) * tgamma(2 - s / 2)) * hypergeometric;
+
+		return (circular_mellin * (1 + pow(obscuration(), 4 - s)) - 2 * eps2 * cross) / pow(1 - eps2, 2);
+	}
+
+	/**
+	 * @brief Large frequency coefficient of annular aperture filter
+	 *
+	 * Evaluates the coefficient of \f$ u^{-3-2n} \f$ in the asymptotic
+	 * expansion of the non-oscillating part of \f$ A(u) \f$ at large
+	 * \f$ u \f$. The cross term oscillates and does not contribute.
+	 *
+	 * @param n Index of the term
+	 * @return Asymptotic coefficient
+	 *
+	 * @see circular::tail()
+	 */
+	value_type tail(std::size_t n) const noexcept {
+		using namespace std;
+
+		const auto s = static_cast<value_type>(3 + 2 * n);
+		const auto circular_tail = circular<value_type>{}.tail(n);
+
+		if (obscuration() == static_cast<value_type>(0))
+			return circular_tail;
+
+		return circular_tail * (1 + pow(obscuration(), 4 - s)) / pow(1 - pow(obscuration(), 2), 2);
+	}
+
 	/**
 	 * @brief Call operator for annular aperture in Cartesian coordinates
 	 *
@@ -8,6 +8,7 @@
 #define _WEIF_AF_GAUSS_H
 
 #include <cmath>
+#include <cstddef>
 
 #include <xtensor/utils/xutils.hpp>
 #include <xtensor/core/xmath.hpp>
@@ -66,6 +67,45 @@ struct WEIF_EXPORT gauss {
 		return std::exp(-ux*ux-uy*uy);
 	}
 
+	/**
+	 * @brief Taylor coefficient of Gaussian aperture filter
+	 *
+	 * Evaluates the coefficient \f$ (-1)^n / n! \f$ of \f$ u^{2n} \f$.
+	 *
+	 * @param n Half of the power of \f$ u \f$
+	 * @return Taylor coefficient
+	 */
+	value_type taylor(std::size_t n) const noexcept {
+		value_type ret = 1;
+		for (std::size_t j = 1; j <= n; ++j) {
+			ret /= -static_cast<value_type>(j);
+		}
+
+		return ret;
+	}
+
+	/**
+	 * @brief Mellin transform of Gaussian aperture filter
+	 *
+	 * Evaluates the analytic continuation of
+	 * \f$ \int_0^{\infty} u^{s - 1} A(u) du = \frac{1}{2} \Gamma\left(\frac{s}{2}\right) \f$.
+	 *
+	 * @param s Mellin transform argument
+	 * @return Mellin transform value
+	 */
+	value_type mellin(value_type s) const noexcept {
+		return std::tgamma(s / 2) / 2;
+	}
+
+	/**
+	 * @brief Large frequency coefficient of Gaussian aperture filter
+	 * @param n Index of the term
+	 * @return Zero, since the filter decays faster than any power
+	 */
+	value_type tail(std::size_t n) const noexcept {
+		return static_cast<value_type>(0);
+	}
+
         /**
          * @brief Vectorized evaluation for Gaussian aperture filter (radial coordinates)
          *
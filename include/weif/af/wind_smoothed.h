@@ -0,0 +1,265 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#ifndef _WEIF_AF_WIND_SMOOTHED_H
+#define _WEIF_AF_WIND_SMOOTHED_H
+
+#include <cmath>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+#include <boost/math/special_functions/bessel.hpp>
+#include <boost/math/special_functions/sinc.hpp>
+
+#include <xtensor/core/xmath.hpp>
+#include <xtensor/utils/xutils.hpp>
+
+#include <weif_export.h>
+
+
+namespace weif {
+namespace af {
+
+/**
+ * @brief Aperture filter smoothed by the finite exposure time
+ *
+ * @tparam AF Underlying aperture filter type
+ *
+ * During the exposure \f$ \tau \f$ the pattern moves with the wind
+ * velocity \f$ V \f$ by the distance \f$ V \tau \f$ along the direction
+ * \f$ \hat{e} \f$, so the aperture filter is multiplied by the squared
+ * Fourier transform of the uniform motion:
+ * \f[
+ * A_s(\vec{u}) = A(\vec{u}) \mathrm{sinc}^2(\pi s \vec{u} \cdot \hat{e}),
+ * \f]
+ * where \f$ s = V \tau / D \f$ is the shift in the units of the aperture
+ * scale. The filter depends on \f$ V \f$ and \f$ \tau \f$ only through
+ * \f$ s \f$, so a grid of exposure times and wind velocities reduces to
+ * a single parameter.
+ *
+ * The radial call operator gives the average over the wind direction,
+ * that is used by the one-dimensional weight_function. For axially
+ * symmetric \f$ A(u) \f$, the angular average of the smoothing factor
+ * follows from \f$ \mathrm{sinc}^2(a) = \int_{-1}^{1} (1 - |t|) e^{2 i a t} dt \f$:
+ * \f[
+ * S(c) = 2 \int_0^1 (1 - t) J_0(c t) dt = \frac{2}{c} \left( J_1(c) + 2 \sum_{k \ge 1} J_{2k+1}(c) \right),
+ * \f]
+ * where \f$ c = 2 \pi s u \f$. The Bessel functions of all orders are
+ * obtained at once by the Miller backward recurrence for \f$ c \le 100 \f$.
+ * For larger \f$ c \f$, where the quadrature of weight_function probes
+ * the filter up to \f$ u \sim 10^{70} \f$, the integral of \f$ J_0 \f$
+ * is taken by its asymptotic expansion:
+ * \f[
+ * S(c) = \frac{2}{c} \left( 1 - \frac{J_0(c)}{c} \sum_{k \ge 0} \frac{(-1)^k (2k-1)!! (2k+1)!!}{c^{2k}} + J_1(c) \sum_{k \ge 1} \frac{(-1)^k ((2k-1)!!)^2}{c^{2k}} \right).
+ * \f]
+ * So the cost is bounded instead of the nested angular quadrature of
+ * angle_averaged. The Cartesian call operator keeps the direction and is
+ * used by weight_function_2d.
+ *
+ * @see angle_averaged
+ */
+template<class AF>
+class WEIF_EXPORT wind_smoothed {
+public:
+	using aperture_filter_type = AF; ///< Underlying aperture filter type
+	using value_type = typename AF::value_type; ///< Numeric type used for calculations
+
+private:
+	aperture_filter_type aperture_filter_;
+	value_type shift_;
+	value_type direction_;
+
+	/* The integral of J_0 from c to infinity is expanded by parts with
+	 * (t J_1)' = t J_0 and J_0' = -J_1, the terms decrease until k ~ c / 2 */
+	static value_type average_asymptotic(value_type c) noexcept {
+		using namespace std;
+
+		constexpr std::size_t max_terms = 16;
+
+		const auto c2 = c * c;
+
+		value_type p = 1;
+		value_type q = 1;
+		value_type sum_p = 0;
+		value_type sum_q = 1;
+
+		for (std::size_t k = 1; k < max_terms; ++k) {
+			const auto m = static_cast<value_type>(2 * k - 1);
+
+			p *= -m * m / c2;
+			q *= -m * (m + 2) / c2;
+			sum_p += p;
+			sum_q += q;
+
+			if (abs(q) < std::numeric_limits<value_type>::epsilon())
+				break;
+		}
+
+		return 2 * (1 - boost::math::cyl_bessel_j(0, c) / c * sum_q + boost::math::cyl_bessel_j(1, c) * sum_p) / c;
+	}
+
+public:
+	/**
+	 * @brief Construct smoothed aperture filter
+	 * @param aperture_filter Underlying aperture filter
+	 * @param shift Wind shift during the exposure \f$ s = V \tau / D \f$ in the units of the aperture scale
+	 * @param direction Wind direction angle in radians with respect to the x-axis
+	 */
+	wind_smoothed(aperture_filter_type aperture_filter, value_type shift, value_type direction = 0):
+		aperture_filter_{std::move(aperture_filter)},
+		shift_{shift},
+		direction_{direction} {}
+
+	/// @return Underlying aperture filter
+	const aperture_filter_type& aperture_filter() const noexcept { return aperture_filter_; }
+	/// @return Wind shift during the exposure in the units of the aperture scale
+	value_type shift() const noexcept { return shift_; }
+	/// @return Wind direction angle in radians
+	value_type direction() const noexcept { return direction_; }
+
+	/**
+	 * @brief Angular average of the smoothing factor
+	 * @param c Argument \f$ c = 2 \pi s u \f$
+	 * @return \f$ S(c) \f$
+	 */
+	static value_type average(value_type c) noexcept {
+		using namespace std;
+
+		constexpr auto big = static_cast<value_type>(1) / std::numeric_limits<value_type>::epsilon();
+		/* The smallest term of the asymptotic series is about exp(-c) */
+		constexpr auto asymptotic = static_cast<value_type>(100);
+
+		c = abs(c);
+
+		/* The next term of the Taylor series is c^4 / 960 */
+		if (c < sqrt(sqrt(std::numeric_limits<value_type>::epsilon())))
+			return 1 - c * c / 24;
+
+		if (isinf(c))
+			return static_cast<value_type>(0);
+
+		if (!(c <= asymptotic))
+			return average_asymptotic(c);
+
+		/* The start order where J_n(c) is negligible, below 180 here */
+		const auto order = static_cast<unsigned long>(c + sqrt(40 * c + 40 * 40)) + 2;
+		const auto start = order + order % 2;
+
+		value_type next = 0;
+		value_type current = 1;
+		value_type even = 0; /* J_0 + 2 \sum J_{2k} */
+		value_type odd = 0;  /* \sum_{k \ge 1} J_{2k+1} */
+		value_type first = 0;
+
+		for (auto n = start; n > 0; --n) {
+			/* current is J_n, evaluate J_{n-1} */
+			const auto previous = 2 * static_cast<value_type>(n) / c * current - next;
+
+			next = current;
+			current = previous;
+
+			const auto m = n - 1;
+
+			if (m == 1) {
+				first = current;
+			} else if (m % 2 == 0) {
+				even += (m == 0 ? current : 2 * current);
+			} else {
+				odd += current;
+			}
+
+			if (abs(current) > big) {
+				const auto scale = abs(current);
+
+				current /= scale;
+				next /= scale;
+				even /= scale;
+				odd /= scale;
+				first /= scale;
+			}
+		}
+
+		return 2 * (first + 2 * odd) / (c * even);
+	}
+
+
+	/**
+	 * @brief Call operator for direction averaged filter in radial coordinates
+	 *
+	 * Evaluates \f$ A(u) S(2 \pi s u) \f$.
+	 *
+	 * @param u Dimensionless spatial frequency magnitude
+	 * @return Filter transmission value at given frequency
+	 */
+	value_type operator() (value_type u) const noexcept {
+		constexpr auto PI = xt::numeric_constants<value_type>::PI;
+
+		const auto a = aperture_filter_(u);
+
+		if (a == static_cast<value_type>(0))
+			return a;
+
+		return a * average(2 * PI * shift_ * u);
+	}
+
+	/**
+	 * @brief Call operator for smoothed filter in Cartesian coordinates
+	 *
+	 * Evaluates \f$ A(u_x, u_y) \mathrm{sinc}^2(\pi s (u_x \cos\theta + u_y \sin\theta)) \f$.
+	 *
+	 * @param ux Dimensionless spatial frequency in x-direction
+	 * @param uy Dimensionless spatial frequency in y-direction
+	 * @return Filter transmission value at given frequency coordinates
+	 */
+	value_type operator() (value_type ux, value_type uy) const noexcept {
+		using namespace std;
+		using boost::math::sinc_pi;
+
+		constexpr auto PI = xt::numeric_constants<value_type>::PI;
+
+		const auto a = aperture_filter_(ux, uy);
+
+		if (a == static_cast<value_type>(0))
+			return a;
+
+		const auto projection = ux * cos(direction_) + uy * sin(direction_);
+
+		return a * pow(sinc_pi(PI * shift_ * projection), 2);
+	}
+
+	/**
+	 * @brief Vectorized evaluation for direction averaged filter (radial coordinates)
+	 * @param e Input tensor of frequency magnitudes
+	 * @return Tensor of transmission values with same shape as input
+	 */
+	template<class E, xt::enable_xexpression<E, bool> = true>
+	auto operator() (E&& e) const noexcept {
+		return xt::make_lambda_xfunction([this] (const auto& u) -> value_type {
+			return this->operator()(u);
+		}, std::forward<E>(e));
+	}
+
+	/**
+	 * @brief Vectorized evaluation for smoothed filter (Cartesian coordinates)
+	 * @param ex Tensor of x-component frequencies
+	 * @param ey Tensor of y-component frequencies
+	 * @return (Nx, Ny) shaped tensor of transmission values
+	 */
+	template<class EX, class EY, xt::enable_xexpression<EX, bool> = true, xt::enable_xexpression<EY, bool> = true>
+	auto operator() (EX&& ex, EY&& ey) const noexcept {
+		auto [xx, yy] = xt::meshgrid(std::forward<EX>(ex), std::forward<EY>(ey));
+
+		return xt::make_lambda_xfunction([this] (const auto& ux, const auto& uy) -> value_type {
+			return this->operator()(ux, uy);
+		}, std::move(xx), std::move(yy));
+	}
+};
+
+} // af
+} // weif
+
+#endif // _WEIF_AF_WIND_SMOOTHED_H
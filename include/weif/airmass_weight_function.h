@@ -0,0 +1,244 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#ifndef _WEIF_AIRMASS_WEIGHT_FUNCTION_H
+#define _WEIF_AIRMASS_WEIGHT_FUNCTION_H
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include <xtensor/containers/xtensor.hpp> // IWYU pragma: keep
+#include <xtensor/core/xexpression.hpp> // IWYU pragma: keep
+#include <xtensor/core/xmath.hpp>
+#include <xtensor/generators/xbuilder.hpp>
+#include <xtensor/views/xview.hpp>
+
+#include <weif/progress_token.h>
+#include <weif/sf/poly.h>
+#include <weif/spectral_response.h>
+#include <weif/uniform_grid.h>
+#include <weif/weight_function.h>
+#include <weif_export.h>
+
+
+namespace weif {
+
+/**
+ * @brief Scintillation weight function at arbitrary zenith angles
+ *
+ * @tparam T Numeric type for calculations
+ *
+ * At the zenith angle \f$ \gamma \f$ the layer at altitude \f$ h \f$ is
+ * at the distance \f$ h X \f$ along the line of sight, where
+ * \f$ X = \sec\gamma \f$ is the airmass, and the layer thickness is
+ * \f$ X dh \f$. So the weight function per unit altitude is
+ * \f[
+ * W_X(h) = X W(h X).
+ * \f]
+ *
+ * For airmass independent spectral filters, i.e. sf::mono, the single
+ * precomputed dimensionless table is reused for all airmasses. For
+ * polychromatic responses the atmospheric transmission \f$ t(\lambda) \f$
+ * changes the effective response to \f$ F(\lambda) t^X(\lambda) \f$, so
+ * both the spectral filter and the equivalent wavelength depend on the
+ * airmass. In this case the weight function for every distinct airmass is
+ * computed once and kept in the cache.
+ *
+ * The cache may be shared between threads. Concurrent requests of the
+ * same missing airmass may compute it more than once, but the first
+ * computed weight function is kept.
+ *
+ * @code
+ * airmass_weight_function<double> wf{response, transmission, af::circular<double>{}, aperture_scale, 1024, 4096};
+ * const xt::xtensor<double, 2> w = wf(altitudes, airmasses); // shape (altitudes.size(), airmasses.size())
+ * @endcode
+ *
+ * @see weight_function
+ * @see weight_function_cache
+ */
+template<class T>
+class WEIF_EXPORT airmass_weight_function {
+public:
+	using value_type = T; ///< Numeric type for calculations
+	using weight_function_type = weight_function<value_type>; ///< Weight function type at fixed airmass
+
+private:
+	using function_type = std::function<weight_function_type(value_type, progress_token*)>;
+
+	std::shared_ptr<const weight_function_type> fixed_;
+	function_type fun_;
+	mutable std::mutex mutex_;
+	mutable std::map<value_type, std::shared_ptr<const weight_function_type>> functions_;
+
+	static spectral_response<value_type> make_response(const spectral_response<value_type>& response,
+		const spectral_response<value_type>& transmission, value_type airmass) {
+
+		return response.stacked(spectral_response<value_type>{transmission.grid(), xt::pow(transmission.data(), airmass)}).normalized();
+	}
+
+public:
+	/**
+	 * @brief Construct from airmass independent weight function
+	 * @param wf Weight function at the zenith
+	 */
+	explicit airmass_weight_function(weight_function_type wf):
+		fixed_{std::make_shared<const weight_function_type>(std::move(wf))} {}
+
+	/**
+	 * @brief Construct for airmass independent spectral filter
+	 * @param spectral_filter Spectral filter function, i.e. sf::mono
+	 * @param lambda Wavelength in nanometers
+	 * @param aperture_filter Aperture filter function
+	 * @param aperture_scale Aperture scale in millimeters
+	 * @param size Number of grid points for precomputation
+	 * @param progress Optional progress and cancellation token
+	 *
+	 * @throws cancelled If cancellation is requested through the progress token
+	 */
+	template<class SF, class AF>
+	airmass_weight_function(SF&& spectral_filter, value_type lambda, AF&& aperture_filter, value_type aperture_scale, std::size_t size,
+		progress_token* progress = nullptr):
+		airmass_weight_function(weight_function_type{std::forward<SF>(spectral_filter), lambda, std::forward<AF>(aperture_filter), aperture_scale,
+			size, nullptr, progress}) {}
+
+	/**
+	 * @brief Construct for polychromatic response seen through the atmosphere
+	 * @param response Spectral response of the instrument above the atmosphere
+	 * @param transmission Atmospheric transmission at the zenith on the grid compatible with the response
+	 * @param aperture_filter Aperture filter function
+	 * @param aperture_scale Aperture scale in millimeters
+	 * @param grid Grid of the dimensionless weight functions
+	 * @param filter_size Interpolation grid size of sf::poly
+	 *
+	 * No weight function is computed at the construction.
+	 *
+	 * @throws mismatched_grids If the grids of the response and the transmission can not be intersected
+	 */
+	template<class AF>
+	airmass_weight_function(const spectral_response<value_type>& response, const spectral_response<value_type>& transmission,
+		AF&& aperture_filter, value_type aperture_scale, const uniform_grid<value_type>& grid, std::size_t filter_size):
+		fun_{[response, transmission, aperture_filter = std::forward<AF>(aperture_filter), aperture_scale, grid, filter_size]
+			(value_type airmass, progress_token* progress) -> weight_function_type {
+
+			sf::poly<value_type> spectral_filter{make_response(response, transmission, airmass), filter_size, progress};
+			const auto lambda = spectral_filter.equiv_lambda();
+			spectral_filter.normalize();
+
+			return weight_function_type{std::move(spectral_filter), lambda, aperture_filter, aperture_scale, grid, nullptr, progress};
+		}} {
+
+		/* Fail early for incompatible grids */
+		response.grid().intersect(transmission.grid());
+	}
+
+	/**
+	 * @brief Construct for polychromatic response seen through the atmosphere
+	 * @param response Spectral response of the instrument above the atmosphere
+	 * @param transmission Atmospheric transmission at the zenith on the grid compatible with the response
+	 * @param aperture_filter Aperture filter function
+	 * @param aperture_scale Aperture scale in millimeters
+	 * @param size Number of grid points for precomputation
+	 * @param filter_size Interpolation grid size of sf::poly
+	 *
+	 * @throws mismatched_grids If the grids of the response and the transmission can not be intersected
+	 */
+	template<class AF>
+	airmass_weight_function(const spectral_response<value_type>& response, const spectral_response<value_type>& transmission,
+		AF&& aperture_filter, value_type aperture_scale, std::size_t size, std::size_t filter_size):
+		airmass_weight_function(response, transmission, std::forward<AF>(aperture_filter), aperture_scale,
+			uniform_grid{static_cast<value_type>(0), static_cast<value_type>(1) / (size-1), size}, filter_size) {}
+
+	/// @return Number of cached weight functions
+	std::size_t size() const {
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		return (fixed_ ? 1 : functions_.size());
+	}
+
+	/// Discard cached weight functions
+	void clear() {
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		functions_.clear();
+	}
+
+	/**
+	 * @brief Weight function along the line of sight for given airmass
+	 * @param airmass Airmass \f$ X = \sec\gamma \f$
+	 * @param progress Optional progress and cancellation token, used when the weight function is computed
+	 * @return Shared weight function \f$ W(h) \f$ of the distance \f$ h \f$ along the line of sight
+	 *
+	 * @throws cancelled If cancellation is requested through the progress token
+	 */
+	std::shared_ptr<const weight_function_type> weight(value_type airmass, progress_token* progress = nullptr) const {
+		if (fixed_)
+			return fixed_;
+
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+
+			if (auto it = functions_.find(airmass); it != functions_.end())
+				return it->second;
+		}
+
+		auto ret = std::make_shared<const weight_function_type>(fun_(airmass, progress));
+
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		return functions_.emplace(airmass, std::move(ret)).first->second;
+	}
+
+	/**
+	 * @brief Evaluate weight function at specific altitude and airmass
+	 * @param altitude Atmospheric altitude in kilometers
+	 * @param airmass Airmass \f$ X = \sec\gamma \f$
+	 * @return \f$ X W(h X) \f$
+	 *
+	 * @throws cancelled If cancellation is requested through the progress token
+	 */
+	value_type operator() (value_type altitude, value_type airmass, progress_token* progress = nullptr) const {
+		return airmass * (*weight(airmass, progress))(altitude * airmass);
+	}
+
+	/**
+	 * @brief Evaluate weight function for all pairs of altitudes and airmasses
+	 * @param altitudes One-dimensional altitude values expression in kilometers
+	 * @param airmasses One-dimensional airmass values expression
+	 * @param progress Optional progress and cancellation token, used when the weight functions are computed
+	 * @return Tensor of shape (altitudes.size(), airmasses.size()) of \f$ X W(h X) \f$
+	 *
+	 * @throws cancelled If cancellation is requested through the progress token
+	 */
+	template<class E1, class E2>
+	xt::xtensor<value_type, 2> operator() (const xt::xexpression<E1>& altitudes, const xt::xexpression<E2>& airmasses,
+		progress_token* progress = nullptr) const {
+
+		const auto& h = altitudes.derived_cast();
+		const auto& x = airmasses.derived_cast();
+
+		xt::xtensor<value_type, 2> ret = xt::empty<value_type>({h.size(), x.size()});
+
+		for (std::size_t j = 0; j < x.size(); ++j) {
+			const value_type airmass = x(j);
+			const auto wf = weight(airmass, progress);
+
+			xt::view(ret, xt::all(), j) = airmass * (*wf)(airmass * h);
+		}
+
+		return ret;
+	}
+};
+
+extern template class airmass_weight_function<float>;
+extern template class airmass_weight_function<double>;
+extern template class airmass_weight_function<long double>;
+
+} // weif
+
+#endif // _WEIF_AIRMASS_WEIGHT_FUNCTION_H
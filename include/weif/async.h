@@ -0,0 +1,90 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#ifndef _WEIF_ASYNC_H
+#define _WEIF_ASYNC_H
+
+#include <functional>
+#include <future>
+#include <memory>
+#include <tuple>
+#include <utility>
+
+
+namespace weif {
+namespace detail {
+
+/* std::make_tuple() turns std::reference_wrapper arguments into references */
+template<class T, class... Args>
+auto make_constructor(Args&&... args) {
+	return [args = std::make_tuple(std::forward<Args>(args)...)] () mutable {
+		return std::apply([] (auto&... a) {
+			return T(a...);
+		}, args);
+	};
+}
+
+template<class T, class... Args>
+auto make_construct_task(Args&&... args) {
+	return std::make_shared<std::packaged_task<T()>>(make_constructor<T>(std::forward<Args>(args)...));
+}
+
+} // detail
+
+/**
+ * @brief Construct an object asynchronously
+ *
+ * @tparam T Type to construct, i.e. sf::poly, weight_function or weight_function_grid_2d
+ * @param args Constructor arguments
+ * @return Future holding the constructed object
+ *
+ * The construction runs by std::async with std::launch::async, so
+ * the destructor of the returned future waits for the construction to
+ * complete. Use make_async_on() to run the construction on a thread
+ * pool or another executor. The arguments are copied into the task like for
+ * std::thread; wrap an argument into std::ref() or std::cref() to pass
+ * it by reference, in which case the caller must keep it alive until the
+ * future is ready. A progress_token pointer may be passed among the
+ * arguments to track or cancel the construction, the cancellation is
+ * then reported by the future as weif::cancelled.
+ *
+ * @code
+ * auto f = weif::make_async<weif::weight_function<double>>(std::cref(sf), lambda, af::circular<double>{}, aperture_scale, 1025);
+ * ...
+ * const auto wf = f.get();
+ * @endcode
+ */
+template<class T, class... Args>
+std::future<T> make_async(Args&&... args) {
+	return std::async(std::launch::async, detail::make_constructor<T>(std::forward<Args>(args)...));
+}
+
+/**
+ * @brief Construct an object asynchronously using given executor
+ *
+ * @tparam T Type to construct, i.e. sf::poly, weight_function or weight_function_grid_2d
+ * @param executor Callable accepting a copyable nullary task, for instance a thread pool submit function
+ * @param args Constructor arguments
+ * @return Future holding the constructed object
+ *
+ * The executor is invoked once with the construction task, it is
+ * responsible to run the task exactly once.
+ *
+ * @see make_async()
+ */
+template<class T, class Executor, class... Args>
+std::future<T> make_async_on(Executor&& executor, Args&&... args) {
+	auto task = detail::make_construct_task<T>(std::forward<Args>(args)...);
+	auto ret = task->get_future();
+
+	std::invoke(std::forward<Executor>(executor), [task = std::move(task)] () { (*task)(); });
+
+	return ret;
+}
+
+} // weif
+
+#endif // _WEIF_ASYNC_H
@@ -0,0 +1,322 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#ifndef _WEIF_COVARIANCE_MAP_2D_H
+#define _WEIF_COVARIANCE_MAP_2D_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <complex>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#include <xtensor/containers/xtensor.hpp> // IWYU pragma: keep
+#include <xtensor/core/xmath.hpp>
+#include <xtensor/generators/xbuilder.hpp>
+#include <xtensor/views/xview.hpp>
+
+#include <weif/detail/fftw3_wrap.h>
+#include <weif/error.h>
+#include <weif_export.h>
+
+
+namespace weif {
+
+/**
+ * @brief Streaming estimator of spatial covariance maps of pupil intensity
+ *
+ * @tparam T Numeric type for calculations
+ *
+ * Accumulates the spatial auto-covariance of the normalized intensity
+ * fluctuations \f$ \delta I = I / \langle I \rangle - 1 \f$ over the
+ * sequence of pupil images. The mean intensity \f$ \langle I \rangle \f$
+ * is computed for every frame over the pupil mask. The autocorrelation of
+ * every frame is computed by the zero-padded real-to-complex FFT, and the
+ * power spectra are summed, so only a single backward transform is
+ * required when the map is requested.
+ *
+ * The map is returned on the lattice of weight_function_grid_2d: the
+ * element \f$ (j, k) \f$ is the covariance at the baseline
+ * \f$ (j \Delta, k \Delta) \f$, where \f$ \Delta \f$ is the pixel pitch
+ * projected onto the pupil plane, which has to coincide with the grid step
+ * of the weight function. The baselines \f$ (\pm j, \pm k) \f$ are pooled
+ * together and every lag is normalized by the number of overlapping
+ * pupil pixel pairs, so the map is directly comparable with
+ * \f$ \int C_n^2(h) W_{jk}(h) dh \f$, the pixel playing the role of the
+ * aperture.
+ *
+ * @see weight_function_grid_2d
+ * @see profile_restoration_2d
+ */
+template<class T>
+class WEIF_EXPORT covariance_map_2d {
+public:
+	using value_type = T; ///< Numeric type for calculations
+	using complex_type = std::complex<T>;
+	using shape_type = std::array<std::size_t, 2>;
+	using result_type = xt::xtensor<value_type, 2>; ///< Map tensor type
+
+private:
+	shape_type frame_shape_;
+	shape_type shape_;
+	shape_type padded_shape_;
+	xt::xtensor<value_type, 2> mask_;
+	value_type mask_sum_;
+	detail::fft_plan_r2c<T> forward_;
+	detail::fft_plan_c2r<T> backward_;
+	xt::xtensor<value_type, 2> overlap_;
+	xt::xtensor<value_type, 2> power_;
+	xt::xtensor<value_type, 2> buffer_;
+	std::size_t frames_ = 0;
+
+	std::size_t spectrum_size() const noexcept { return std::get<1>(padded_shape_) / 2 + 1; }
+
+	/* In-place transform buffer of the padded frame */
+	xt::xtensor<value_type, 2> make_buffer() const {
+		return xt::zeros<value_type>({std::get<0>(padded_shape_), 2 * spectrum_size()});
+	}
+
+	/* Puts normalized frame into the buffer, returns false for non-positive mean */
+	template<class E>
+	bool normalize(const E& frame, xt::xtensor<value_type, 2>& buffer) const noexcept {
+		const auto [nx, ny] = frame_shape_;
+		const auto stride = buffer.shape()[1];
+
+		value_type sum = 0;
+		for (std::size_t i = 0; i < nx; ++i) {
+			for (std::size_t j = 0; j < ny; ++j) {
+				sum += mask_(i, j) * static_cast<value_type>(frame(i, j));
+			}
+		}
+
+		if (!(sum > static_cast<value_type>(0)))
+			return false;
+
+		const auto mean = sum / mask_sum_;
+
+		buffer.fill(static_cast<value_type>(0));
+		for (std::size_t i = 0; i < nx; ++i) {
+			for (std::size_t j = 0; j < ny; ++j) {
+				buffer.data()[i * stride + j] = mask_(i, j) * (static_cast<value_type>(frame(i, j)) / mean - static_cast<value_type>(1));
+			}
+		}
+
+		return true;
+	}
+
+	/* Adds power spectrum of the buffer */
+	void accumulate(xt::xtensor<value_type, 2>& buffer, xt::xtensor<value_type, 2>& power) const noexcept {
+		auto spectrum = reinterpret_cast<complex_type*>(buffer.data());
+
+		forward_(buffer.data(), spectrum);
+
+		for (std::size_t i = 0; i < power.size(); ++i) {
+			power.data()[i] += std::norm(spectrum[i]);
+		}
+	}
+
+	/* Autocorrelation from power spectrum, unnormalized */
+	xt::xtensor<value_type, 2> correlate(const xt::xtensor<value_type, 2>& power) const {
+		auto buffer = make_buffer();
+		auto spectrum = reinterpret_cast<complex_type*>(buffer.data());
+
+		for (std::size_t i = 0; i < power.size(); ++i) {
+			spectrum[i] = power.data()[i];
+		}
+
+		backward_(spectrum, buffer.data());
+
+		return buffer;
+	}
+
+	/* Pools the lags (j, k) and (j, -k) on the lattice */
+	result_type fold(const xt::xtensor<value_type, 2>& correlation) const {
+		const auto [n0, n1] = shape_;
+		const auto [p0, p1] = padded_shape_;
+
+		result_type ret{shape_};
+
+		for (std::size_t j = 0; j < n0; ++j) {
+			for (std::size_t k = 0; k < n1; ++k) {
+				ret(j, k) = correlation(j, k) + (j > 0 && k > 0 ? correlation(j, p1 - k) : static_cast<value_type>(0));
+			}
+		}
+
+		return ret;
+	}
+
+public:
+	/**
+	 * @brief Construct covariance map estimator with pupil mask
+	 * @param e Pupil mask of the frame shape, non-zero values are the mask weights
+	 * @param shape Lattice dimensions (Nx, Ny), usually weight_function_grid_2d::shape()
+	 *
+	 * @throws mismatched_shape If the lattice is larger than the frame
+	 */
+	template<class E>
+	covariance_map_2d(const xt::xexpression<E>& e, shape_type shape):
+		frame_shape_{e.derived_cast().shape()[0], e.derived_cast().shape()[1]},
+		shape_{shape},
+		padded_shape_{std::get<0>(frame_shape_) + std::get<0>(shape_) - 1, std::get<1>(frame_shape_) + std::get<1>(shape_) - 1},
+		mask_{e.derived_cast()},
+		mask_sum_{xt::sum(mask_)()},
+		forward_{std::array{static_cast<int>(std::get<0>(padded_shape_)), static_cast<int>(std::get<1>(padded_shape_))}, nullptr, nullptr, FFTW_ESTIMATE},
+		backward_{std::array{static_cast<int>(std::get<0>(padded_shape_)), static_cast<int>(std::get<1>(padded_shape_))}, nullptr, nullptr, FFTW_ESTIMATE},
+		power_{xt::zeros<value_type>({std::get<0>(padded_shape_), spectrum_size()})},
+		buffer_{make_buffer()} {
+
+		if (std::get<0>(shape_) == 0 || std::get<1>(shape_) == 0 ||
+			std::get<0>(shape_) > std::get<0>(frame_shape_) || std::get<1>(shape_) > std::get<1>(frame_shape_))
+			throw mismatched_shape{std::get<0>(shape_), std::get<1>(shape_), std::get<0>(frame_shape_), std::get<1>(frame_shape_)};
+
+		const auto stride = buffer_.shape()[1];
+
+		for (std::size_t i = 0; i < std::get<0>(frame_shape_); ++i) {
+			for (std::size_t j = 0; j < std::get<1>(frame_shape_); ++j) {
+				buffer_.data()[i * stride + j] = mask_(i, j);
+			}
+		}
+
+		xt::xtensor<value_type, 2> mask_power = xt::zeros_like(power_);
+		accumulate(buffer_, mask_power);
+		overlap_ = fold(correlate(mask_power));
+	}
+
+	/**
+	 * @brief Construct covariance map estimator for full frames
+	 * @param frame_shape Frame dimensions
+	 * @param shape Lattice dimensions (Nx, Ny), usually weight_function_grid_2d::shape()
+	 *
+	 * @throws mismatched_shape If the lattice is larger than the frame
+	 */
+	covariance_map_2d(shape_type frame_shape, shape_type shape):
+		covariance_map_2d(xt::ones<value_type>(frame_shape), shape) {}
+
+	/// @return Frame dimensions
+	const auto& frame_shape() const noexcept { return frame_shape_; }
+
+	/// @return Lattice dimensions (Nx, Ny)
+	const auto& shape() const noexcept { return shape_; }
+
+	/// @return Number of accumulated frames
+	std::size_t frames() const noexcept { return frames_; }
+
+	/// Discard accumulated frames
+	void reset() noexcept {
+		power_.fill(static_cast<value_type>(0));
+		frames_ = 0;
+	}
+
+	/**
+	 * @brief Accumulate single frame
+	 * @param e Frame of intensities
+	 *
+	 * Frames with non-positive mean intensity over the mask are skipped.
+	 *
+	 * @throws mismatched_shape If the frame shape differs from the mask shape
+	 */
+	template<class E>
+	void push(const xt::xexpression<E>& e) {
+		const auto& frame = e.derived_cast();
+
+		if (frame.dimension() != 2 || frame.shape()[0] != std::get<0>(frame_shape_) || frame.shape()[1] != std::get<1>(frame_shape_))
+			throw mismatched_shape{frame.shape()[0], (frame.dimension() > 1 ? frame.shape()[1] : std::size_t{1}), std::get<0>(frame_shape_), std::get<1>(frame_shape_)};
+
+		if (normalize(frame, buffer_)) {
+			accumulate(buffer_, power_);
+			++frames_;
+		}
+	}
+
+	/**
+	 * @brief Accumulate sequence of frames using several threads
+	 * @param e Frames of shape (M, frame dimensions)
+	 * @param threads Number of threads, zero stands for the hardware concurrency
+	 *
+	 * The frames are split into contiguous chunks, every thread owns its
+	 * transform buffer and power accumulator, while the transform plans
+	 * are shared.
+	 *
+	 * @throws mismatched_shape If the frame shape differs from the mask shape
+	 */
+	template<class E>
+	void push_frames(const xt::xexpression<E>& e, std::size_t threads = 0) {
+		const auto& frames = e.derived_cast();
+
+		if (frames.dimension() != 3 || frames.shape()[1] != std::get<0>(frame_shape_) || frames.shape()[2] != std::get<1>(frame_shape_))
+			throw mismatched_shape{(frames.dimension() > 1 ? frames.shape()[1] : std::size_t{1}), (frames.dimension() > 2 ? frames.shape()[2] : std::size_t{1}),
+				std::get<0>(frame_shape_), std::get<1>(frame_shape_)};
+
+		const auto count = frames.shape()[0];
+
+		if (threads == 0)
+			threads = std::max(std::thread::hardware_concurrency(), 1u);
+		threads = std::max(std::min(threads, count), std::size_t{1});
+
+		std::vector<xt::xtensor<value_type, 2>> buffers(threads, make_buffer());
+		std::vector<xt::xtensor<value_type, 2>> powers(threads, xt::zeros_like(power_));
+		std::vector<std::size_t> accepted(threads, 0);
+
+		const auto worker = [&] (std::size_t t) noexcept {
+			for (std::size_t i = count * t / threads; i < count * (t + 1) / threads; ++i) {
+				if (normalize(xt::view(frames, i, xt::all(), xt::all()), buffers[t])) {
+					accumulate(buffers[t], powers[t]);
+					++accepted[t];
+				}
+			}
+		};
+
+		std::vector<std::thread> pool;
+		pool.reserve(threads - 1);
+		for (std::size_t t = 1; t < threads; ++t) {
+			pool.emplace_back(worker, t);
+		}
+
+		worker(0);
+
+		for (auto& thread: pool) {
+			thread.join();
+		}
+
+		for (std::size_t t = 0; t < threads; ++t) {
+			power_ += powers[t];
+			frames_ += accepted[t];
+		}
+	}
+
+	/**
+	 * @brief Covariance map of accumulated frames
+	 * @return 2D tensor of shape (Nx, Ny)
+	 *
+	 * The lags without overlapping pupil pixels are set to zero.
+	 */
+	result_type operator() () const {
+		if (frames_ == 0)
+			return xt::zeros<value_type>(shape_);
+
+		/* Lags without overlap are round-off level */
+		const auto threshold = std::numeric_limits<value_type>::epsilon() * 16 * mask_sum_;
+		auto ret = fold(correlate(power_));
+
+		for (std::size_t i = 0; i < ret.size(); ++i) {
+			const auto count = overlap_.data()[i];
+
+			ret.data()[i] = (count > threshold ? ret.data()[i] / (count * static_cast<value_type>(frames_)) : static_cast<value_type>(0));
+		}
+
+		return ret;
+	}
+};
+
+extern template class covariance_map_2d<float>;
+extern template class covariance_map_2d<double>;
+extern template class covariance_map_2d<long double>;
+
+} // weif
+
+#endif // _WEIF_COVARIANCE_MAP_2D_H
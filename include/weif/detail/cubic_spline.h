@@ -139,6 +139,19 @@ public:
 		}, e.derived_cast());
 	}
 
+	/* First derivative with respect to the node index coordinate */
+	value_type derivative(const value_type x) const noexcept {
+		const auto idx = static_cast<std::size_t>(x);
+		const auto delta0 = x - static_cast<value_type>(idx);
+		const auto delta1 = static_cast<value_type>(1) - delta0;
+		const auto d20 = d2_(idx) / 6;
+		const auto d21 = d2_(idx+1) / 6;
+		const auto y0 = values_(idx);
+		const auto y1 = values_(idx+1);
+
+		return 3 * (d21 * delta0 * delta0 - d20 * delta1 * delta1) + (y1 - d21) - (y0 - d20);
+	}
+
 	template<class U>
 	auto operator+ (const U x) const noexcept {
 		const auto ret{*this};
@@ -1,7 +1,7 @@
 /*
  * SPDX-License-Identifier: GPL-3.0-or-later
  *
- * Copyright (C) 2022-2023  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
  */
 
 #ifndef _WEIF_DETAIL_FFTW3_WRAP_H
@@ -12,14 +12,23 @@
 #include <complex>
 #include <cstdlib>
 #include <memory>
+#include <mutex>
 #include <type_traits>
 
 #include <fftw3.h> // IWYU pragma: export
 
+#include <weif_export.h>
+
 
 namespace weif {
 namespace detail {
 
+/*
+ * FFTW planner is not thread-safe: plans are created and destroyed
+ * under this process-wide lock, while execution runs unlocked.
+ */
+WEIF_EXPORT std::mutex& fftw_planner_mutex() noexcept;
+
 template<class T>
 struct fftw_traits;
 
@@ -30,9 +39,15 @@ struct fftw_traits<float> {
 	using plan_type = fftwf_plan;
 	constexpr static auto destroy_plan = &fftwf_destroy_plan;
 
+	constexpr static auto plan_dft = &fftwf_plan_dft;
+	constexpr static auto execute_dft = &fftwf_execute_dft;
+
 	constexpr static auto plan_dft_r2c = &fftwf_plan_dft_r2c;
 	constexpr static auto execute_dft_r2c = &fftwf_execute_dft_r2c;
 
+	constexpr static auto plan_dft_c2r = &fftwf_plan_dft_c2r;
+	constexpr static auto execute_dft_c2r = &fftwf_execute_dft_c2r;
+
 	constexpr static auto plan_r2r = &fftwf_plan_r2r;
 	constexpr static auto execute_r2r = &fftwf_execute_r2r;
 };
@@ -44,9 +59,15 @@ struct fftw_traits<double> {
 	using plan_type = fftw_plan;
 	constexpr static auto destroy_plan = &fftw_destroy_plan;
 
+	constexpr static auto plan_dft = &fftw_plan_dft;
+	constexpr static auto execute_dft = &fftw_execute_dft;
+
 	constexpr static auto plan_dft_r2c = &fftw_plan_dft_r2c;
 	constexpr static auto execute_dft_r2c = &fftw_execute_dft_r2c;
 
+	constexpr static auto plan_dft_c2r = &fftw_plan_dft_c2r;
+	constexpr static auto execute_dft_c2r = &fftw_execute_dft_c2r;
+
 	constexpr static auto plan_r2r = &fftw_plan_r2r;
 	constexpr static auto execute_r2r = &fftw_execute_r2r;
 };
@@ -58,9 +79,15 @@ struct fftw_traits<long double> {
 	using plan_type = fftwl_plan;
 	constexpr static auto destroy_plan = &fftwl_destroy_plan;
 
+	constexpr static auto plan_dft = &fftwl_plan_dft;
+	constexpr static auto execute_dft = &fftwl_execute_dft;
+
 	constexpr static auto plan_dft_r2c = &fftwl_plan_dft_r2c;
 	constexpr static auto execute_dft_r2c = &fftwl_execute_dft_r2c;
 
+	constexpr static auto plan_dft_c2r = &fftwl_plan_dft_c2r;
+	constexpr static auto execute_dft_c2r = &fftwl_execute_dft_c2r;
+
 	constexpr static auto plan_r2r = &fftwl_plan_r2r;
 	constexpr static auto execute_r2r = &fftwl_execute_r2r;
 };
@@ -74,11 +101,21 @@ public:
 
 private:
 	struct deleter {
-		constexpr void operator() (plan_type plan) const noexcept {
+		void operator() (plan_type plan) const noexcept {
+			std::lock_guard<std::mutex> lock(fftw_planner_mutex());
+
 			traits_type::destroy_plan(plan);
 		}
 	};
 
+protected:
+	template<class F>
+	static plan_type make_plan(F&& f) noexcept {
+		std::lock_guard<std::mutex> lock(fftw_planner_mutex());
+
+		return f();
+	}
+
 public:
 	explicit fft_plan(plan_type plan) noexcept:
 		plan_{plan} {
@@ -86,6 +123,9 @@ public:
 		assert(plan != nullptr);
 	}
 
+	fft_plan(fft_plan&&) noexcept = default;
+	fft_plan& operator=(fft_plan&&) noexcept = default;
+
 	operator plan_type() const noexcept {
 		return plan_.get();
 	}
@@ -97,6 +137,25 @@ private:
 	std::unique_ptr<std::remove_pointer_t<plan_type>, deleter> plan_;
 };
 
+template<class T>
+struct fft_plan_c2c:
+	public detail::fft_plan<T> {
+	using traits_type = detail::fftw_traits<T>;
+	using value_type = T;
+	using complex_type = std::complex<T>;
+
+	template<std::size_t Rank>
+	fft_plan_c2c(const std::array<int, Rank>& n, complex_type* in, complex_type* out, int sign, unsigned flags) noexcept:
+		detail::fft_plan<T>(detail::fft_plan<T>::make_plan([&] () {
+			return traits_type::plan_dft(n.size(), n.data(),
+				reinterpret_cast<typename traits_type::complex_type*>(in), reinterpret_cast<typename traits_type::complex_type*>(out), sign, flags);
+		})) {}
+
+	void operator() (complex_type* in, complex_type* out) const noexcept {
+		traits_type::execute_dft(*this, reinterpret_cast<typename traits_type::complex_type*>(in), reinterpret_cast<typename traits_type::complex_type*>(out));
+	}
+};
+
 template<class T>
 struct fft_plan_r2c:
 	public detail::fft_plan<T> {
@@ -106,14 +165,35 @@ struct fft_plan_r2c:
 
 	template<std::size_t Rank>
 	fft_plan_r2c(const std::array<int, Rank>& n, value_type* in, complex_type* out, unsigned flags) noexcept:
-		detail::fft_plan<T>(traits_type::plan_dft_r2c(n.size(), n.data(),
-			in, reinterpret_cast<typename traits_type::complex_type*>(out), flags)) {}
+		detail::fft_plan<T>(detail::fft_plan<T>::make_plan([&] () {
+			return traits_type::plan_dft_r2c(n.size(), n.data(),
+				in, reinterpret_cast<typename traits_type::complex_type*>(out), flags);
+		})) {}
 
 	void operator() (value_type* in, complex_type* out) const noexcept {
 		traits_type::execute_dft_r2c(*this, in, reinterpret_cast<typename traits_type::complex_type*>(out));
 	}
 };
 
+template<class T>
+struct fft_plan_c2r:
+	public detail::fft_plan<T> {
+	using traits_type = detail::fftw_traits<T>;
+	using value_type = T;
+	using complex_type = std::complex<T>;
+
+	template<std::size_t Rank>
+	fft_plan_c2r(const std::array<int, Rank>& n, complex_type* in, value_type* out, unsigned flags) noexcept:
+		detail::fft_plan<T>(detail::fft_plan<T>::make_plan([&] () {
+			return traits_type::plan_dft_c2r(n.size(), n.data(),
+				reinterpret_cast<typename traits_type::complex_type*>(in), out, flags);
+		})) {}
+
+	void operator() (complex_type* in, value_type* out) const noexcept {
+		traits_type::execute_dft_c2r(*this, reinterpret_cast<typename traits_type::complex_type*>(in), out);
+	}
+};
+
 template<class T>
 struct fft_plan_r2r:
 	public detail::fft_plan<T> {
@@ -122,16 +202,24 @@ struct fft_plan_r2r:
 
 	template<std::size_t Rank>
 	fft_plan_r2r(const std::array<int, Rank>& n, value_type* in, value_type* out, const std::array<fftw_r2r_kind, Rank>& kind, unsigned flags) noexcept:
-		detail::fft_plan<T>(traits_type::plan_r2r(n.size(), n.data(), in, out, kind.data(), flags)) {}
+		detail::fft_plan<T>(detail::fft_plan<T>::make_plan([&] () {
+			return traits_type::plan_r2r(n.size(), n.data(), in, out, kind.data(), flags);
+		})) {}
 
 	void operator() (value_type* in, value_type* out) const noexcept {
 		traits_type::execute_r2r(*this, in, out);
 	}
 };
 
+template<class T, std::size_t Rank>
+fft_plan_c2c(const std::array<int, Rank>& n, std::complex<T>* in, std::complex<T>* out, int sign, unsigned flags) -> fft_plan_c2c<T>;
+
 template<class T, std::size_t Rank>
 fft_plan_r2c(const std::array<int, Rank>& n, T* in, std::complex<T>* out, unsigned flags) -> fft_plan_r2c<T>;
 
+template<class T, std::size_t Rank>
+fft_plan_c2r(const std::array<int, Rank>& n, std::complex<T>* in, T* out, unsigned flags) -> fft_plan_c2r<T>;
+
 template<class T, std::size_t Rank>
 fft_plan_r2r(const std::array<int, Rank>& n, T* in, T* out, const std::array<fftw_r2r_kind, Rank>& kind, unsigned flags) -> fft_plan_r2r<T>;
 
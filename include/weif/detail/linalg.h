@@ -0,0 +1,213 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#ifndef _WEIF_DETAIL_LINALG_H
+#define _WEIF_DETAIL_LINALG_H
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include <xtensor/containers/xtensor.hpp>
+#include <xtensor/generators/xbuilder.hpp>
+
+
+/*
+ * Small dense linear algebra on row-major xtensor matrices, enough for
+ * the model reduction and the restoration problems without pulling a
+ * BLAS/LAPACK dependency.
+ */
+
+namespace weif {
+namespace detail {
+
+/* Returns a * b */
+template<class T>
+xt::xtensor<T, 2> multiply(const xt::xtensor<T, 2>& a, const xt::xtensor<T, 2>& b) {
+	const auto n = a.shape()[0];
+	const auto m = a.shape()[1];
+	const auto k = b.shape()[1];
+
+	assert(b.shape()[0] == m);
+
+	xt::xtensor<T, 2> c = xt::zeros<T>({n, k});
+
+	for (std::size_t i = 0; i < n; ++i) {
+		T* ci = c.data() + i * k;
+
+		for (std::size_t l = 0; l < m; ++l) {
+			const T ail = a.data()[i * m + l];
+			const T* bl = b.data() + l * k;
+
+			for (std::size_t j = 0; j < k; ++j) {
+				ci[j] += ail * bl[j];
+			}
+		}
+	}
+
+	return c;
+}
+
+/* Returns transpose(a) * b */
+template<class T>
+xt::xtensor<T, 2> multiply_tn(const xt::xtensor<T, 2>& a, const xt::xtensor<T, 2>& b) {
+	const auto m = a.shape()[0];
+	const auto n = a.shape()[1];
+	const auto k = b.shape()[1];
+
+	assert(b.shape()[0] == m);
+
+	xt::xtensor<T, 2> c = xt::zeros<T>({n, k});
+
+	for (std::size_t l = 0; l < m; ++l) {
+		const T* al = a.data() + l * n;
+		const T* bl = b.data() + l * k;
+
+		for (std::size_t i = 0; i < n; ++i) {
+			const T ali = al[i];
+			T* ci = c.data() + i * k;
+
+			for (std::size_t j = 0; j < k; ++j) {
+				ci[j] += ali * bl[j];
+			}
+		}
+	}
+
+	return c;
+}
+
+/*
+ * Orthonormalizes the columns in place by the modified Gram-Schmidt
+ * process. Linearly dependent columns are set to zero.
+ */
+template<class T>
+void orthonormalize(xt::xtensor<T, 2>& a) {
+	using namespace std;
+
+	const auto n = a.shape()[0];
+	const auto k = a.shape()[1];
+	const auto tiny = std::numeric_limits<T>::epsilon() * std::numeric_limits<T>::epsilon();
+
+	std::vector<T> norm0(k);
+	for (std::size_t j = 0; j < k; ++j) {
+		T s = 0;
+		for (std::size_t i = 0; i < n; ++i) {
+			s += a(i, j) * a(i, j);
+		}
+
+		norm0[j] = s;
+	}
+
+	for (std::size_t j = 0; j < k; ++j) {
+		for (std::size_t p = 0; p < j; ++p) {
+			T dot = 0;
+			for (std::size_t i = 0; i < n; ++i) {
+				dot += a(i, p) * a(i, j);
+			}
+
+			for (std::size_t i = 0; i < n; ++i) {
+				a(i, j) -= dot * a(i, p);
+			}
+		}
+
+		T s = 0;
+		for (std::size_t i = 0; i < n; ++i) {
+			s += a(i, j) * a(i, j);
+		}
+
+		const T scale = (s > tiny * norm0[j] && s > static_cast<T>(0) ? static_cast<T>(1) / sqrt(s) : static_cast<T>(0));
+		for (std::size_t i = 0; i < n; ++i) {
+			a(i, j) *= scale;
+		}
+	}
+}
+
+/*
+ * Cyclic Jacobi eigenvalue algorithm for small symmetric matrices.
+ * Returns eigenvalues in descending order and the corresponding
+ * eigenvectors in columns.
+ */
+template<class T>
+std::pair<xt::xtensor<T, 1>, xt::xtensor<T, 2>> symmetric_eigen(xt::xtensor<T, 2> a) {
+	using namespace std;
+
+	const auto n = a.shape()[0];
+	xt::xtensor<T, 2> v = xt::eye<T>(n);
+
+	for (std::size_t sweep = 0; sweep < 64; ++sweep) {
+		T off = 0;
+		T total = 0;
+
+		for (std::size_t p = 0; p < n; ++p) {
+			for (std::size_t q = 0; q < n; ++q) {
+				total += a(p, q) * a(p, q);
+				off += (p != q ? a(p, q) * a(p, q) : static_cast<T>(0));
+			}
+		}
+
+		if (off <= std::numeric_limits<T>::epsilon() * std::numeric_limits<T>::epsilon() * total) {
+			break;
+		}
+
+		for (std::size_t p = 0; p < n; ++p) {
+			for (std::size_t q = p + 1; q < n; ++q) {
+				if (a(p, q) == static_cast<T>(0)) {
+					continue;
+				}
+
+				const T theta = (a(q, q) - a(p, p)) / (2 * a(p, q));
+				const T t = (theta >= 0 ? static_cast<T>(1) : static_cast<T>(-1)) / (abs(theta) + sqrt(theta * theta + static_cast<T>(1)));
+				const T c = static_cast<T>(1) / sqrt(t * t + static_cast<T>(1));
+				const T s = t * c;
+
+				for (std::size_t k = 0; k < n; ++k) {
+					const T x = a(k, p), y = a(k, q);
+					a(k, p) = c * x - s * y;
+					a(k, q) = s * x + c * y;
+				}
+
+				for (std::size_t k = 0; k < n; ++k) {
+					const T x = a(p, k), y = a(q, k);
+					a(p, k) = c * x - s * y;
+					a(q, k) = s * x + c * y;
+				}
+
+				for (std::size_t k = 0; k < n; ++k) {
+					const T x = v(k, p), y = v(k, q);
+					v(k, p) = c * x - s * y;
+					v(k, q) = s * x + c * y;
+				}
+			}
+		}
+	}
+
+	std::vector<std::size_t> order(n);
+	std::iota(order.begin(), order.end(), std::size_t{0});
+	std::sort(order.begin(), order.end(), [&a] (std::size_t i, std::size_t j) { return a(i, i) > a(j, j); });
+
+	xt::xtensor<T, 1> values{std::array{n}};
+	xt::xtensor<T, 2> vectors{std::array{n, n}};
+
+	for (std::size_t j = 0; j < n; ++j) {
+		values(j) = a(order[j], order[j]);
+
+		for (std::size_t i = 0; i < n; ++i) {
+			vectors(i, j) = v(i, order[j]);
+		}
+	}
+
+	return {std::move(values), std::move(vectors)};
+}
+
+} // detail
+} // weif
+
+#endif // _WEIF_DETAIL_LINALG_H
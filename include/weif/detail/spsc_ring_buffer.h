@@ -0,0 +1,118 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#ifndef _WEIF_DETAIL_SPSC_RING_BUFFER_H
+#define _WEIF_DETAIL_SPSC_RING_BUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+
+namespace weif {
+namespace detail {
+
+/*
+ * Bounded lock-free queue for exactly one producer thread and exactly
+ * one consumer thread. The capacity is rounded up to the power of two,
+ * the indices grow monotonically and are wrapped by the mask.
+ */
+template<class T>
+class spsc_ring_buffer {
+public:
+	using value_type = T;
+
+private:
+	static constexpr std::size_t cache_line = 64;
+
+	std::vector<value_type> storage_;
+	std::size_t mask_;
+	alignas(cache_line) std::atomic<std::size_t> head_{0}; /* written by the consumer */
+	alignas(cache_line) std::atomic<std::size_t> tail_{0}; /* written by the producer */
+
+	static std::size_t round_up(std::size_t capacity) noexcept {
+		std::size_t ret = 1;
+
+		while (ret < capacity) {
+			ret <<= 1;
+		}
+
+		return ret;
+	}
+
+public:
+	explicit spsc_ring_buffer(std::size_t capacity):
+		storage_(round_up(capacity)),
+		mask_{storage_.size() - 1} {}
+
+	spsc_ring_buffer(const spsc_ring_buffer&) = delete;
+	spsc_ring_buffer& operator=(const spsc_ring_buffer&) = delete;
+
+	std::size_t capacity() const noexcept { return storage_.size(); }
+
+	/* Approximate number of queued elements */
+	std::size_t size() const noexcept {
+		return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+	}
+
+	/* Producer side, returns false when the queue is full */
+	bool try_push(const value_type& value) noexcept {
+		const auto tail = tail_.load(std::memory_order_relaxed);
+		const auto head = head_.load(std::memory_order_acquire);
+
+		if (tail - head == storage_.size())
+			return false;
+
+		storage_[tail & mask_] = value;
+		tail_.store(tail + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	/* Consumer side, returns false when the queue is empty */
+	bool try_pop(value_type& value) noexcept {
+		const auto head = head_.load(std::memory_order_relaxed);
+		const auto tail = tail_.load(std::memory_order_acquire);
+
+		if (head == tail)
+			return false;
+
+		value = storage_[head & mask_];
+		head_.store(head + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	/* Consumer side, calls f for every queued element, returns the number
+	 * of elements. When f throws, the elements processed before are
+	 * released and the element f has thrown for stays in the queue. */
+	template<class F>
+	std::size_t consume(F&& f) {
+		const auto head = head_.load(std::memory_order_relaxed);
+		const auto tail = tail_.load(std::memory_order_acquire);
+
+		auto i = head;
+
+		try {
+			for (; i != tail; ++i) {
+				f(storage_[i & mask_]);
+			}
+		} catch (...) {
+			head_.store(i, std::memory_order_release);
+
+			throw;
+		}
+
+		head_.store(tail, std::memory_order_release);
+
+		return tail - head;
+	}
+};
+
+} // detail
+} // weif
+
+#endif // _WEIF_DETAIL_SPSC_RING_BUFFER_H
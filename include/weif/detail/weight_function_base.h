@@ -7,8 +7,11 @@
 #ifndef _WEIF_DETAIL_WEIGHT_FUNCTION_BASE_H
 #define _WEIF_DETAIL_WEIGHT_FUNCTION_BASE_H
 
+#include <chrono>
 #include <cmath>
 #include <functional>
+#include <memory>
+#include <type_traits>
 
 #include <boost/math/quadrature/exp_sinh.hpp>
 #include <boost/math/quadrature/tanh_sinh.hpp>
@@ -19,7 +22,12 @@
 #include <xtensor/core/xmath.hpp>
 
 #include <weif/detail/cubic_spline.h>
+#include <weif/detail/weight_function_series.h>
+#include <weif/error.h>
 #include <weif/math.h>
+#include <weif/progress_token.h>
+#include <weif/quadrature_statistics.h>
+#include <weif/spectrum/kolmogorov.h>
 #include <weif/uniform_grid.h>
 #include <weif_export.h>
 
@@ -27,6 +35,31 @@
 namespace weif {
 namespace detail {
 
+/*
+ * The precomputed tables use the dimensionless variable
+ * $z = 1 / (1 + D / \sqrt{\lambda h})$ instead of the altitude $h$.
+ * The grid step is used for the scale $D$ of the grids of apertures when
+ * the aperture scale is zero.
+ */
+template<class T>
+T altitude_scale(T aperture_scale, T grid_step) noexcept {
+	return (aperture_scale > static_cast<T>(0) ? aperture_scale : grid_step);
+}
+
+template<class T>
+T altitude_to_z(T altitude, T lambda, T scale) noexcept {
+	const T fresnel_radius = std::sqrt(lambda * altitude);
+
+	return static_cast<T>(1) / (static_cast<T>(1) + scale / fresnel_radius);
+}
+
+template<class T>
+T z_to_altitude(T z, T lambda, T scale) noexcept {
+	const T fresnel_radius = scale * z / (static_cast<T>(1) - z);
+
+	return fresnel_radius * fresnel_radius / lambda;
+}
+
 template<class T>
 class WEIF_EXPORT weight_function_base {
 public:
@@ -37,6 +70,17 @@ private:
 	value_type aperture_scale_;
 	uniform_grid<value_type> grid_;
 	cubic_spline<value_type> wf_;
+	std::shared_ptr<const quadrature_statistics<value_type>> statistics_;
+	bool scale_invariant_;
+
+	/* The derivatives below assume that the dimensionless weight function
+	 * depends on D and lambda only through x = D / sqrt(lambda z). The
+	 * spectra with the outer or the inner scale also depend on L0 / D and
+	 * l0 / D, which are frozen in the table. */
+	void check_scale_invariant() const {
+		if (!scale_invariant_)
+			throw error("Weight function derivatives are available for the Kolmogorov spectrum only");
+	}
 
 protected:
 	inline value_type operator() (value_type altitude) const noexcept {
@@ -46,44 +90,130 @@ protected:
 		/* 1e13 = pow(1e3, 5.0/6.0) * pow(1e9, 7.0/6.0) */
 		constexpr const value_type c = weif::math::Kolmogorov_Cn2_scale<value_type> * (16 * 1e13) * PI * PI;
 
-		const value_type fresnel_radius = sqrt(lambda() * altitude);
-		const value_type z = (static_cast<value_type>(1) / (static_cast<value_type>(1) + aperture_scale() / fresnel_radius) - grid_.origin()) / grid_.delta();
+		const value_type z = (altitude_to_z(altitude, lambda(), aperture_scale()) - grid_.origin()) / grid_.delta();
 
 		return c * pow(altitude, static_cast<value_type>(5.0/6.0)) / pow(lambda(), static_cast<value_type>(7.0/6.0)) * wf_(z);
 	}
 
+	/* Derivative of operator() with respect to the aperture scale */
+	inline value_type aperture_scale_derivative(value_type altitude) const {
+		using namespace std;
+
+		check_scale_invariant();
+
+		const value_type fresnel_radius = sqrt(lambda() * altitude);
+
+		return scale_derivative(altitude) / fresnel_radius;
+	}
+
+	/* Derivative of operator() with respect to the wavelength at fixed shape of the spectral filter */
+	inline value_type lambda_derivative(value_type altitude) const {
+		using namespace std;
+
+		check_scale_invariant();
+
+		const value_type fresnel_radius = sqrt(lambda() * altitude);
+		const value_type x = aperture_scale() / fresnel_radius;
+
+		return -(static_cast<value_type>(7.0/6.0) * operator()(altitude) + x / 2 * scale_derivative(altitude)) / lambda();
+	}
+
+private:
+	/* Derivative of operator() with respect to x = D / sqrt(lambda z), dz/dx = -z^2 */
+	inline value_type scale_derivative(value_type altitude) const noexcept {
+		using namespace std;
+
+		constexpr const auto PI = xt::numeric_constants<value_type>::PI;
+		constexpr const value_type c = weif::math::Kolmogorov_Cn2_scale<value_type> * (16 * 1e13) * PI * PI;
+
+		const value_type z = altitude_to_z(altitude, lambda(), aperture_scale());
+		const value_type derivative = -z * z * wf_.derivative((z - grid_.origin()) / grid_.delta()) / grid_.delta();
+
+		return c * pow(altitude, static_cast<value_type>(5.0/6.0)) / pow(lambda(), static_cast<value_type>(7.0/6.0)) * derivative;
+	}
+
 public:
 	template<class E>
-	weight_function_base(value_type lambda, value_type aperture_scale, const uniform_grid<value_type>& grid, const xt::xexpression<E>& values):
+	weight_function_base(value_type lambda, value_type aperture_scale, const uniform_grid<value_type>& grid, const xt::xexpression<E>& values,
+		std::shared_ptr<const quadrature_statistics<value_type>> statistics = nullptr, bool scale_invariant = true):
 		lambda_{lambda},
 		aperture_scale_{aperture_scale},
 		grid_{grid},
-		wf_{values, first_order_boundary<value_type>{0, 0}} {}
+		wf_{values, first_order_boundary<value_type>{0, 0}},
+		statistics_{std::move(statistics)},
+		scale_invariant_{scale_invariant} {}
 
 	const auto& lambda() const noexcept { return lambda_; /* nm */ }
 	const auto& aperture_scale() const noexcept { return aperture_scale_; /* mm */ }
+	const auto& statistics() const noexcept { return statistics_; }
+	const auto& scale_invariant() const noexcept { return scale_invariant_; }
 };
 
-template<class SF, class AF, class E>
-auto dimensionless_weight_function(SF&& spectral_filter, AF&& aperture_filter, E&& e) noexcept {
-	using namespace std::placeholders;
-	using boost::math::quadrature::exp_sinh;
-	using value_type = xt::get_value_type_t<std::decay_t<E>>;
+/*
+ * The nodes of the dimensionless weight function depend on the altitude
+ * through the aperture scale only, so the point aperture can not carry
+ * the geometric scales of the spectrum. Returns the spectrum policy
+ * scaled to the aperture scale.
+ */
+template<class T, class Spectrum>
+Spectrum scaled_spectrum(const Spectrum& spectrum, T aperture_scale) {
+	if (aperture_scale == static_cast<T>(0) && !spectrum.scale_invariant())
+		throw error("Point aperture weight function is available for the Kolmogorov spectrum only");
 
-	auto spectrum_fcnt = [
+	return spectrum.scaled(aperture_scale);
+}
+
+/*
+ * Returns the copyable radial integrand $u \Phi(u, x) S(u^2) A(r x u)$
+ * of the dimensionless weight function as a function of $(u, x)$,
+ * $u^{-8/3} S(u^2) A(r x u)$ for Kolmogorov spectrum. The spectrum
+ * policy has to be scaled to the scale $x$ is measured in, and $r$ is
+ * the aperture scale in the same units, zero for the point aperture.
+ * Non-finite values of the integrand are treated as zero.
+ */
+template<class T, class SF, class AF, class Spectrum>
+auto make_spectrum_integrand(SF&& spectral_filter, AF&& aperture_filter, const Spectrum& spectrum, T aperture_ratio = static_cast<T>(1)) {
+	using value_type = T;
+
+	return [
 		spectral_filter = std::forward<SF>(spectral_filter),
-		aperture_filter = std::forward<AF>(aperture_filter)
+		aperture_filter = std::forward<AF>(aperture_filter),
+		spectrum,
+		aperture_ratio
 	] (value_type u, value_type x) noexcept -> value_type {
 		using namespace std;
 
-		const auto t = pow(u, static_cast<value_type>(8.0/3.0));
+		/* u^{-8/3} for Kolmogorov spectrum */
+		const auto t = u * spectrum(u * u, x);
 
-		if (t == static_cast<value_type>(0)) {
+		if (!isfinite(t) || t == static_cast<value_type>(0)) {
 			return static_cast<value_type>(0);
 		}
 
-		return spectral_filter(u * u) * aperture_filter(x * u) / t;
+		return spectral_filter(u * u) * aperture_filter(aperture_ratio * x * u) * t;
 	};
+}
+
+/*
+ * Returns the copyable functor evaluating the dimensionless weight
+ * function at a single node z. The spectrum policy has to be scaled
+ * to the aperture scale, see spectrum::kolmogorov::scaled().
+ *
+ * When make_analytic_node() is overloaded for the filters and the
+ * spectrum, or the filters expose their moments, the nodes are
+ * evaluated analytically where the series reach the quadrature
+ * tolerance, and the quadrature is used for the remaining nodes only.
+ */
+template<class T, class SF, class AF, class Spectrum = spectrum::kolmogorov<T>>
+auto dimensionless_weight_function_node(SF&& spectral_filter, AF&& aperture_filter,
+	quadrature_statistics<T>* statistics = nullptr, progress_token* progress = nullptr, const Spectrum& spectrum = Spectrum{}) {
+	using namespace std::placeholders;
+	using boost::math::quadrature::exp_sinh;
+	using value_type = T;
+
+	auto analytic = make_analytic_node(spectral_filter, aperture_filter, spectrum);
+
+	auto spectrum_fcnt = make_spectrum_integrand<value_type>(std::forward<SF>(spectral_filter), std::forward<AF>(aperture_filter), spectrum);
 
 	/* exp-sinh quadrature works poorly for higher altutudes due to
 	 * $\sin^2(\pi u^2)$ term. Tanaka, et al. (doi: 10.1007/s00211-008-0195-1)
@@ -91,28 +221,75 @@ auto dimensionless_weight_function(SF&& spectral_filter, AF&& aperture_filter, E
 	 * is unbounded in $D_{DE,3}$. However, it seems that there are
 	 * alternative DE and SE quadratures which could work better.
 	 */
-	auto integrator = std::make_unique<exp_sinh<value_type>>();
+	auto integrator = std::make_shared<const exp_sinh<value_type>>();
 
-	auto fcnt = [
+	return [
 		integrator = std::move(integrator),
-		spectrum_fcnt = std::move(spectrum_fcnt)
+		analytic = std::move(analytic),
+		spectrum_fcnt = std::move(spectrum_fcnt),
+		statistics,
+		progress
 	] (value_type z) -> value_type {
 		const auto tol = std::pow(std::numeric_limits<value_type>::epsilon(), static_cast<value_type>(2.0/3.0));
 		const auto x = (static_cast<value_type>(1) - z) / z;
 
-		return integrator->integrate(std::bind(std::cref(spectrum_fcnt), _1, x), tol);
+		if constexpr (!std::is_same_v<std::decay_t<decltype(analytic)>, std::nullptr_t>) {
+			const auto t1 = std::chrono::steady_clock::now();
+
+			if (const auto node = analytic(x, tol)) {
+				if (statistics) {
+					const auto t2 = std::chrono::steady_clock::now();
+
+					statistics->push({z, 0, 0, node->error, std::abs(node->value),
+						std::chrono::duration_cast<typename quadrature_statistics<value_type>::duration_type>(t2 - t1), true, node->terms});
+				}
+
+				if (progress) {
+					progress->advance();
+				}
+
+				return node->value;
+			}
+		}
+
+		const auto ret = integrate_node(*integrator, std::bind(std::cref(spectrum_fcnt), _1, x), tol, z, statistics);
+
+		if (progress) {
+			progress->advance();
+		}
+
+		return ret;
 	};
+}
+
+template<class SF, class AF, class E, class Spectrum = spectrum::kolmogorov<xt::get_value_type_t<std::decay_t<E>>>>
+auto dimensionless_weight_function(SF&& spectral_filter, AF&& aperture_filter, E&& e,
+	quadrature_statistics<xt::get_value_type_t<std::decay_t<E>>>* statistics = nullptr, progress_token* progress = nullptr,
+	const Spectrum& spectrum = Spectrum{}) noexcept {
+	using value_type = xt::get_value_type_t<std::decay_t<E>>;
+
+	if (progress) {
+		progress->expect(e.size());
+	}
 
-	return xt::make_lambda_xfunction(std::move(fcnt), std::forward<E>(e));
+	return xt::make_lambda_xfunction(
+		dimensionless_weight_function_node<value_type>(std::forward<SF>(spectral_filter), std::forward<AF>(aperture_filter), statistics, progress, spectrum),
+		std::forward<E>(e));
 }
 
-template<class SF, class AF, class E>
-auto dimensionless_weight_function_2d(SF&& spectral_filter, AF&& aperture_filter, E&& e) noexcept {
+template<class SF, class AF, class E, class Spectrum = spectrum::kolmogorov<xt::get_value_type_t<std::decay_t<E>>>>
+auto dimensionless_weight_function_2d(SF&& spectral_filter, AF&& aperture_filter, E&& e,
+	quadrature_statistics<xt::get_value_type_t<std::decay_t<E>>>* statistics = nullptr, progress_token* progress = nullptr,
+	const Spectrum& spectrum = Spectrum{}) noexcept {
 	using namespace std::placeholders;
 	using boost::math::quadrature::exp_sinh;
 	using boost::math::quadrature::tanh_sinh;
 	using value_type = xt::get_value_type_t<std::decay_t<E>>;
 
+	if (progress) {
+		progress->expect(e.size());
+	}
+
 	auto axial_integrator = std::make_unique<tanh_sinh<value_type>>();
 
 	auto spectrum_fcnt_axial = [
@@ -133,35 +310,51 @@ auto dimensionless_weight_function_2d(SF&& spectral_filter, AF&& aperture_filter
 		return aperture_filter(xu * c, xu * s);
 	};
 
+	/* Every radial node is expensive here, so cancellation is also checked per radial evaluation */
 	auto spectrum_fcnt = [
 		axial_integrator = std::move(axial_integrator),
 		spectral_filter = std::forward<SF>(spectral_filter),
-		spectrum_fcnt_axial = std::move(spectrum_fcnt_axial)
-	] (value_type u, value_type x) noexcept -> value_type {
+		spectrum_fcnt_axial = std::move(spectrum_fcnt_axial),
+		spectrum,
+		progress
+	] (value_type u, value_type x) -> value_type {
 		using namespace std;
 
-		const auto t = pow(u, static_cast<value_type>(8.0/3.0));
+		if (progress) {
+			progress->check();
+		}
+
+		/* u^{-8/3} for Kolmogorov spectrum */
+		const auto t = u * spectrum(u * u, x);
 
-		if (t == static_cast<value_type>(0)) {
+		if (!isfinite(t) || t == static_cast<value_type>(0)) {
 			return static_cast<value_type>(0);
 		}
 
 		const auto tol = std::pow(std::numeric_limits<value_type>::epsilon(), static_cast<value_type>(2.0/3.0));
 		const auto af = axial_integrator->integrate(std::bind(std::cref(spectrum_fcnt_axial), u, x, _1, _2), tol);
 
-		return spectral_filter(u * u) * af / t;
+		return spectral_filter(u * u) * af * t;
 	};
 
 	auto radial_integrator = std::make_unique<exp_sinh<value_type>>();
 
+	/* Statistics are collected for the outer radial integral only */
 	auto fcnt = [
 		radial_integrator = std::move(radial_integrator),
-		spectrum_fcnt = std::move(spectrum_fcnt)
+		spectrum_fcnt = std::move(spectrum_fcnt),
+		statistics,
+		progress
 	] (value_type z) -> value_type {
 		const auto tol = std::pow(std::numeric_limits<value_type>::epsilon(), static_cast<value_type>(2.0/3.0));
 		const auto x = (static_cast<value_type>(1) - z) / z;
+		const auto ret = integrate_node(*radial_integrator, std::bind(std::cref(spectrum_fcnt), _1, x), tol, z, statistics);
+
+		if (progress) {
+			progress->advance();
+		}
 
-		return radial_integrator->integrate(std::bind(std::cref(spectrum_fcnt), _1, x), tol);
+		return ret;
 	};
 
 	return xt::make_lambda_xfunction(std::move(fcnt), std::forward<E>(e)) * static_cast<value_type>(0.5);
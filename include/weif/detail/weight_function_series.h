@@ -0,0 +1,435 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#ifndef _WEIF_DETAIL_WEIGHT_FUNCTION_SERIES_H
+#define _WEIF_DETAIL_WEIGHT_FUNCTION_SERIES_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include <xtensor/core/xmath.hpp>
+
+#include <weif/af/circular.h>
+#include <weif/sf/mono.h>
+#include <weif/spectrum/kolmogorov.h>
+
+
+namespace weif {
+namespace detail {
+
+template<class T>
+struct analytic_node {
+	using value_type = T;
+
+	value_type value;
+	value_type error;
+	std::size_t terms;
+};
+
+/*
+ * Dimensionless weight function for sf::mono, af::annular and the
+ * Kolmogorov spectrum
+ *
+ *   I(x) = \int_0^\infty u^{-8/3} \sin^2(\pi u^2) A(x u) du
+ *
+ * evaluated through the Mellin-Barnes integral
+ *
+ *   I(x) = \frac{1}{2\pi i} \int G(s) F(1 - s) x^{-s} ds,
+ *
+ * where G(s) is the Mellin transform of A(v) and
+ *
+ *   F(1 - s) = -\frac{\Gamma(w) \cos(\pi w / 2)}{4 (2\pi)^w}, w = -\frac{s + 5/3}{2},
+ *
+ * is the Mellin transform of u^{-8/3} \sin^2(\pi u^2).
+ *
+ * The residues at the left poles s = -5/3 and s = -2k give the series
+ *
+ *   I(x) = \frac{1}{2} G(-5/3) x^{5/3} + \sum_k a_k F(1 + 2k) x^{2k},
+ *
+ * convergent for any x, where a_k are the Taylor coefficients of A(v)
+ * in v^2. It is used until the cancellation of the terms spoils the
+ * accuracy, that happens at x about 3 for the double precision.
+ *
+ * The residues at the right poles s = 4m - 5/3 (the Taylor expansion of
+ * the spectral filter) and s = 3 + 2k (the smooth part of the large v
+ * asymptotic of A(v)) give the asymptotic expansion for large x. The
+ * expansion misses the oscillating terms from the stationary points
+ * u = \kappa x / 2 of \cos(2\pi u^2) \cos(2\pi \kappa x u), which
+ * decay as x^{-26/3}, so their amplitude is included to the error
+ * estimate.
+ *
+ * The Mellin transforms and the expansion coefficients are provided by
+ * sf::mono and af::annular, see moment_series for the general case.
+ */
+template<class T>
+class mono_annular_series {
+public:
+	using value_type = T;
+
+	static constexpr std::size_t max_terms = 256;
+
+private:
+	static constexpr std::size_t spectral_terms = 4;
+	static constexpr std::size_t aperture_terms = 4;
+
+	value_type obscuration_;
+	value_type origin_;
+	value_type front_;
+	value_type oscillating_;
+	std::array<value_type, spectral_terms> spectral_;
+	std::array<value_type, aperture_terms> aperture_;
+
+public:
+	explicit mono_annular_series(value_type obscuration):
+		obscuration_{obscuration} {
+
+		using namespace std;
+
+		constexpr auto PI = xt::numeric_constants<value_type>::PI;
+
+		const sf::mono<value_type> spectral_filter;
+		const af::annular<value_type> aperture_filter{obscuration};
+		const auto norm = pow(1 - obscuration_ * obscuration_, 2);
+
+		origin_ = spectral_filter.mean() * aperture_filter.mellin(static_cast<value_type>(-5.0/3.0));
+		front_ = -tgamma(static_cast<value_type>(-5.0/6.0)) / (4 * pow(2 * PI, static_cast<value_type>(-5.0/6.0)));
+
+		for (std::size_t m = 1; m <= spectral_terms; ++m) {
+			const auto s = static_cast<value_type>(4 * m) - static_cast<value_type>(5.0/3.0);
+
+			spectral_[m - 1] = spectral_filter.taylor(2 * m) * aperture_filter.mellin(s);
+		}
+
+		for (std::size_t k = 0; k < aperture_terms; ++k) {
+			const auto s = static_cast<value_type>(3 + 2 * k);
+
+			aperture_[k] = aperture_filter.tail(k) * spectral_filter.mellin(-(s + static_cast<value_type>(5.0/3.0)) / 2) / 2;
+		}
+
+		/* Amplitudes of the oscillating parts B v^{-3} \cos(2\pi \kappa v) of the aperture filter */
+		const auto oscillating = [] (value_type amplitude, value_type kappa) {
+			return amplitude * pow(kappa / 2, static_cast<value_type>(-17.0/3.0)) / (4 * sqrt(static_cast<value_type>(2)));
+		};
+		const auto b = 4 / pow(PI, 4);
+
+		oscillating_ = oscillating(b, 1);
+		if (obscuration_ != static_cast<value_type>(0)) {
+			oscillating_ += oscillating(b * obscuration_, obscuration_);
+			oscillating_ += oscillating(2 * b * sqrt(obscuration_), (1 + obscuration_) / 2);
+			oscillating_ += oscillating(2 * b * sqrt(obscuration_), (1 - obscuration_) / 2);
+		}
+		oscillating_ /= norm;
+	}
+
+	const value_type& obscuration() const noexcept { return obscuration_; }
+
+	/* Convergent series, empty when the cancellation exceeds the tolerance */
+	std::optional<analytic_node<value_type>> small(value_type x, value_type tolerance) const noexcept {
+		using namespace std;
+
+		constexpr auto PI = xt::numeric_constants<value_type>::PI;
+		constexpr auto epsilon = std::numeric_limits<value_type>::epsilon();
+
+		const auto eps2 = obscuration_ * obscuration_;
+		const auto norm = pow(1 - eps2, 2);
+		const auto x2 = x * x;
+
+		value_type ret = origin_ * pow(x, static_cast<value_type>(5.0/3.0));
+		value_type max_term = abs(ret);
+		/* Circular aperture term with the cosine factor excluded */
+		value_type q = front_;
+
+		for (std::size_t k = 0; k < max_terms; ++k) {
+			const auto w = static_cast<value_type>(k) - static_cast<value_type>(5.0/6.0);
+
+			value_type annular = 1;
+			if (obscuration_ != static_cast<value_type>(0)) {
+				/* Weighted mean of \epsilon^{2i} over the Cauchy product of the jinc series */
+				value_type num = 0;
+				value_type den = 0;
+				value_type t = 1;
+				value_type te = 1;
+
+				for (std::size_t i = 0; i <= k; ++i) {
+					num += te;
+					den += t;
+
+					const auto r = static_cast<value_type>((k - i) * (k - i + 1)) / static_cast<value_type>((i + 1) * (i + 2));
+
+					t *= r;
+					te *= r * eps2;
+
+					if (den > std::sqrt(std::numeric_limits<value_type>::max())) {
+						t /= den;
+						te /= den;
+						num /= den;
+						den = 1;
+					}
+				}
+
+				annular = (1 + pow(obscuration_, 2 * k + 4) - 2 * eps2 * num / den) / norm;
+			}
+
+			const auto term = q * cos(PI * w / 2) * annular;
+
+			ret += term;
+			max_term = max(max_term, abs(term));
+
+			const auto error = epsilon * (k + 1) * max_term;
+
+			if (!isfinite(ret) || error > tolerance * abs(ret))
+				return std::nullopt;
+
+			if (x == static_cast<value_type>(0) || (k > 0 && abs(term) <= epsilon * abs(ret)))
+				return analytic_node<value_type>{ret, error, k + 1};
+
+			q *= -PI * (2 * k + 3) * w / (4 * (k + 1) * (k + 2) * (k + 3)) * x2;
+		}
+
+		return std::nullopt;
+	}
+
+	/* Asymptotic expansion, empty when the error estimate exceeds the tolerance */
+	std::optional<analytic_node<value_type>> large(value_type x, value_type tolerance) const noexcept {
+		using namespace std;
+
+		if (isinf(x))
+			return analytic_node<value_type>{0, 0, 0};
+
+		value_type ret = 0;
+		value_type last = 0;
+
+		for (std::size_t m = 1; m <= spectral_terms; ++m) {
+			last = spectral_[m - 1] * pow(x, static_cast<value_type>(5.0/3.0) - static_cast<value_type>(4 * m));
+			ret += last;
+		}
+
+		value_type error = abs(last);
+
+		for (std::size_t k = 0; k < aperture_terms; ++k) {
+			last = aperture_[k] * pow(x, -static_cast<value_type>(3 + 2 * k));
+			ret += last;
+		}
+
+		error += abs(last) + oscillating_ * pow(x, static_cast<value_type>(-26.0/3.0));
+
+		if (!isfinite(ret) || !isfinite(error) || error > tolerance * abs(ret))
+			return std::nullopt;
+
+		return analytic_node<value_type>{ret, error, spectral_terms + aperture_terms};
+	}
+
+	std::optional<analytic_node<value_type>> operator() (value_type x, value_type tolerance) const noexcept {
+		if (x < 1) {
+			return small(x, tolerance);
+		}
+
+		if (auto ret = large(x, tolerance))
+			return ret;
+
+		return small(x, tolerance);
+	}
+};
+
+/*
+ * Dimensionless weight function for the Kolmogorov spectrum and the
+ * filters exposing their moments
+ *
+ *   I(x) = \int_0^\infty u^{-8/3} E(u^2) A(x u) du
+ *
+ * near the ends of the grid. The spectral filter provides the Taylor
+ * coefficients e_p of E(t) in t^p, the Mellin transform M_E(w) and the
+ * mean E_\infty at large t. The aperture filter provides the Taylor
+ * coefficients a_k of A(v) in v^{2k}, the Mellin transform G(s) and the
+ * coefficients c_n of its smooth large v asymptotic in v^{-3-2n}.
+ *
+ * The residues of the Mellin-Barnes integral give the expansion for
+ * small x (z -> 1, the aperture is negligible)
+ *
+ *   I(x) = E_\infty G(-5/3) x^{5/3} + \sum_k \frac{1}{2} a_k M_E(k - 5/6) x^{2k},
+ *
+ * and for large x (z -> 0, the aperture is much larger than the Fresnel
+ * zone)
+ *
+ *   I(x) = \sum_p e_p G(2p - 5/3) x^{5/3 - 2p} + \sum_n \frac{1}{2} c_n M_E(-(3 + 2n + 5/3) / 2) x^{-3-2n}.
+ *
+ * Only a few terms are used and the last of them is the error estimate,
+ * so the expansions are applied at the extreme nodes only. The
+ * oscillating terms from the stationary points are not included, they
+ * vanish when either of the filters is smooth.
+ */
+template<class T>
+class moment_series {
+public:
+	using value_type = T;
+
+private:
+	static constexpr std::size_t small_terms = 4;
+	static constexpr std::size_t spectral_terms = 3;
+	static constexpr std::size_t aperture_terms = 3;
+	static constexpr std::size_t max_power = 16;
+
+	value_type origin_;
+	std::array<value_type, small_terms> small_;
+	std::array<value_type, spectral_terms> spectral_;
+	std::array<value_type, spectral_terms> spectral_power_;
+	std::size_t spectral_size_;
+	std::array<value_type, aperture_terms> aperture_;
+
+public:
+	template<class SF, class AF>
+	moment_series(const SF& spectral_filter, const AF& aperture_filter):
+		origin_{0}, spectral_size_{0} {
+
+		const auto mean = spectral_filter.mean();
+
+		if (mean != static_cast<value_type>(0))
+			origin_ = mean * aperture_filter.mellin(static_cast<value_type>(-5.0/3.0));
+
+		for (std::size_t k = 0; k < small_terms; ++k) {
+			const auto w = static_cast<value_type>(k) - static_cast<value_type>(5.0/6.0);
+
+			small_[k] = aperture_filter.taylor(k) * spectral_filter.mellin(w) / 2;
+		}
+
+		for (std::size_t p = 1; p <= max_power && spectral_size_ < spectral_terms; ++p) {
+			const auto e = spectral_filter.taylor(p);
+
+			if (e == static_cast<value_type>(0))
+				continue;
+
+			const auto s = static_cast<value_type>(2 * p) - static_cast<value_type>(5.0/3.0);
+
+			spectral_[spectral_size_] = e * aperture_filter.mellin(s);
+			spectral_power_[spectral_size_] = -s;
+			++spectral_size_;
+		}
+
+		for (std::size_t n = 0; n < aperture_terms; ++n) {
+			const auto c = aperture_filter.tail(n);
+			const auto s = static_cast<value_type>(3 + 2 * n);
+
+			aperture_[n] = (c == static_cast<value_type>(0) ? c :
+				c * spectral_filter.mellin(-(s + static_cast<value_type>(5.0/3.0)) / 2) / 2);
+		}
+	}
+
+	/* Expansion at small x, empty when the error estimate exceeds the tolerance */
+	std::optional<analytic_node<value_type>> small(value_type x, value_type tolerance) const noexcept {
+		using namespace std;
+
+		if (x == static_cast<value_type>(0))
+			return analytic_node<value_type>{small_[0], 0, 1};
+
+		const auto x2 = x * x;
+
+		value_type ret = origin_ * pow(x, static_cast<value_type>(5.0/3.0));
+		value_type last = 0;
+		value_type power = 1;
+
+		for (std::size_t k = 0; k < small_terms; ++k) {
+			last = small_[k] * power;
+			ret += last;
+			power *= x2;
+		}
+
+		const auto error = abs(last);
+
+		if (!isfinite(ret) || !isfinite(error) || error > tolerance * abs(ret))
+			return std::nullopt;
+
+		return analytic_node<value_type>{ret, error, small_terms};
+	}
+
+	/* Expansion at large x, empty when the error estimate exceeds the tolerance */
+	std::optional<analytic_node<value_type>> large(value_type x, value_type tolerance) const noexcept {
+		using namespace std;
+
+		if (isinf(x))
+			return analytic_node<value_type>{0, 0, 0};
+
+		value_type ret = 0;
+		value_type error = 0;
+
+		for (std::size_t p = 0; p < spectral_size_; ++p) {
+			const auto term = spectral_[p] * pow(x, spectral_power_[p]);
+
+			ret += term;
+			error = abs(term);
+		}
+
+		value_type last = 0;
+		for (std::size_t n = 0; n < aperture_terms; ++n) {
+			const auto term = aperture_[n] * pow(x, -static_cast<value_type>(3 + 2 * n));
+
+			ret += term;
+			if (term != static_cast<value_type>(0))
+				last = abs(term);
+		}
+
+		error += last;
+
+		if (ret == static_cast<value_type>(0) || !isfinite(ret) || !isfinite(error) || error > tolerance * abs(ret))
+			return std::nullopt;
+
+		return analytic_node<value_type>{ret, error, spectral_size_ + aperture_terms};
+	}
+
+	std::optional<analytic_node<value_type>> operator() (value_type x, value_type tolerance) const noexcept {
+		if (x < 1)
+			return small(x, tolerance);
+
+		return large(x, tolerance);
+	}
+};
+
+template<class SF, class AF, class = void>
+struct has_moments: std::false_type {};
+
+template<class SF, class AF>
+struct has_moments<SF, AF, std::void_t<
+	decltype(std::declval<const SF&>().taylor(std::size_t{})),
+	decltype(std::declval<const SF&>().mellin(std::declval<typename SF::value_type>())),
+	decltype(std::declval<const SF&>().mean()),
+	decltype(std::declval<const AF&>().taylor(std::size_t{})),
+	decltype(std::declval<const AF&>().mellin(std::declval<typename AF::value_type>())),
+	decltype(std::declval<const AF&>().tail(std::size_t{}))>>:
+	std::is_same<typename SF::value_type, typename AF::value_type> {};
+
+/* Filters without moments have no analytic evaluation */
+template<class SF, class AF, class Spectrum>
+auto make_analytic_node(const SF& spectral_filter, const AF& aperture_filter, const Spectrum&) {
+	if constexpr (has_moments<SF, AF>::value) {
+		if constexpr (std::is_same_v<Spectrum, spectrum::kolmogorov<typename SF::value_type>>) {
+			return moment_series<typename SF::value_type>{spectral_filter, aperture_filter};
+		} else {
+			return nullptr;
+		}
+	} else {
+		return nullptr;
+	}
+}
+
+template<class T>
+mono_annular_series<T> make_analytic_node(const sf::mono<T>&, const af::circular<T>&, const spectrum::kolmogorov<T>&) {
+	return mono_annular_series<T>{0};
+}
+
+template<class T>
+mono_annular_series<T> make_analytic_node(const sf::mono<T>&, const af::annular<T>& aperture_filter, const spectrum::kolmogorov<T>&) {
+	return mono_annular_series<T>{aperture_filter.obscuration()};
+}
+
+} // detail
+} // weif
+
+#endif // _WEIF_DETAIL_WEIGHT_FUNCTION_SERIES_H
@@ -18,6 +18,7 @@
 #include <xtensor/containers/xtensor.hpp> // IWYU pragma: keep
 
 #include <weif/detail/fftw3_wrap.h>
+#include <weif/progress_token.h>
 #include <weif_export.h>
 
 #if __cpp_lib_memory_resource >= 201603
@@ -51,10 +52,10 @@ private:
 	impulse_type impulse_;
 
 private:
-	static impulse_type make_impulse(function_type&& fun, shape_type shape, const allocator_type& alloc);
+	static impulse_type make_impulse(function_type&& fun, shape_type shape, const allocator_type& alloc, progress_token* progress);
 
-	digital_filter_2d(function_type&& fun, shape_type shape, const allocator_type& alloc):
-		digital_filter_2d(make_impulse(std::forward<function_type>(fun), shape, get_allocator()), alloc) {}
+	digital_filter_2d(function_type&& fun, shape_type shape, const allocator_type& alloc, progress_token* progress):
+		digital_filter_2d(make_impulse(std::forward<function_type>(fun), shape, get_allocator(), progress), alloc) {}
 
 public:
 	/**
@@ -85,15 +86,18 @@ public:
 	 * @param digital_filter_fun Digital filter function
 	 * @param shape Filter dimensions (Nx, Ny)
 	 * @param alloc Allocator instance
+	 * @param progress Optional progress and cancellation token
 	 *
 	 * The digital filter function \f$\Omega(u_x, u_y)\f$ is evaluated on
 	 * an appropriate frequency grid and the filter impulse response is
 	 * calculated using Fast Fourier Transform. The frequency grid spans
 	 * \f$[0, 0.5] \times [0, 0.5]\f$ in dimensionless frequency space.
+	 *
+	 * @throws cancelled If cancellation is requested through the progress token
 	 */
 	template<class DF>
-	digital_filter_2d(DF&& digital_filter_fun, shape_type shape, const allocator_type& alloc = allocator_type()):
-		digital_filter_2d(function_type(std::forward<DF>(digital_filter_fun)), shape, alloc) {}
+	digital_filter_2d(DF&& digital_filter_fun, shape_type shape, const allocator_type& alloc = allocator_type(), progress_token* progress = nullptr):
+		digital_filter_2d(function_type(std::forward<DF>(digital_filter_fun)), shape, alloc, progress) {}
 
 	/// @return Associated allocator
 	const allocator_type& get_allocator() const noexcept { return *this; }
@@ -204,7 +208,7 @@ public:
 
 template<class T, class Allocator>
 typename digital_filter_2d<T, Allocator>::impulse_type
-digital_filter_2d<T, Allocator>::make_impulse(function_type&& fun, shape_type shape, const allocator_type& alloc) {
+digital_filter_2d<T, Allocator>::make_impulse(function_type&& fun, shape_type shape, const allocator_type& alloc, progress_token* progress) {
 	constexpr value_type nyquist = 0.5;
 	const auto& nx = std::get<0>(shape);
 	const auto& ny = std::get<1>(shape);
@@ -213,7 +217,20 @@ digital_filter_2d<T, Allocator>::make_impulse(function_type&& fun, shape_type sh
 	const auto fft_norm = static_cast<value_type>(1) /
 		static_cast<value_type>(4 * (nx - 1) * (ny - 1));
 
-	impulse_type ret{xt::make_lambda_xfunction(std::forward<function_type>(fun), xt::expand_dims(ux, 1), uy)};
+	/* Every filter node and the final Fourier transform */
+	if (progress) {
+		progress->expect(nx * ny + 1);
+	}
+
+	impulse_type ret{xt::make_lambda_xfunction([&fun, progress] (value_type ux, value_type uy) -> value_type {
+		const auto value = fun(ux, uy);
+
+		if (progress) {
+			progress->advance();
+		}
+
+		return value;
+	}, xt::expand_dims(ux, 1), uy)};
 
 	detail::fft_plan_r2r<T> plan{std::array{static_cast<int>(nx), static_cast<int>(ny)},
 		ret.data(), ret.data(), std::array{FFTW_REDFT00, FFTW_REDFT00}, FFTW_ESTIMATE};
@@ -222,6 +239,10 @@ digital_filter_2d<T, Allocator>::make_impulse(function_type&& fun, shape_type sh
 
 	ret *= fft_norm;
 
+	if (progress) {
+		progress->advance();
+	}
+
 	return ret;
 }
 
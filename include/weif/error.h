@@ -1,7 +1,7 @@
 /*
  * SPDX-License-Identifier: GPL-3.0-or-later
  *
- * Copyright (C) 2022-2023  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
  */
 
 #ifndef _WEIF_ERROR_H
@@ -90,6 +90,64 @@ struct WEIF_EXPORT mismatched_grids:
 	mismatched_grids() noexcept;
 };
 
+/**
+ * @brief Exception thrown when a long-running operation is cancelled
+ *
+ * Thrown from heavy constructors when cancellation is requested
+ * through the progress_token passed to them.
+ *
+ * @see progress_token
+ */
+struct WEIF_EXPORT cancelled:
+	public error {
+
+	/**
+	 * @brief Construct with default message
+	 */
+	cancelled() noexcept;
+};
+
+/**
+ * @brief Exception thrown for altitude outside of precomputed table
+ *
+ * @see weight_function_grid_2d_table
+ */
+struct WEIF_EXPORT altitude_out_of_range:
+	public error {
+
+	/**
+	 * @brief Construct with altitude and table range details
+	 * @tparam T Numeric type of the altitudes
+	 * @param altitude Requested altitude
+	 * @param min Lower altitude of the table
+	 * @param max Upper altitude of the table
+	 */
+	template<class T>
+	altitude_out_of_range(T altitude, T min, T max):
+		error(reinterpret_cast<std::ostringstream&>(std::ostringstream() << "Altitude "
+			<< altitude << " is out of table range ["
+			<< min << ", "
+			<< max << "]").str()) {}
+};
+
+/**
+ * @brief Exception thrown for tensor of unexpected shape
+ *
+ * @see profile_restoration_2d
+ */
+struct WEIF_EXPORT mismatched_shape:
+	public error {
+
+	/**
+	 * @brief Construct with actual and expected shape details
+	 * @param nx Actual first dimension
+	 * @param ny Actual second dimension
+	 * @param expected_nx Expected first dimension
+	 * @param expected_ny Expected second dimension
+	 */
+	mismatched_shape(std::size_t nx, std::size_t ny, std::size_t expected_nx, std::size_t expected_ny);
+};
+
 } // weif
 
 #endif // _WEIF_ERROR_H
@@ -0,0 +1,298 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#ifndef _WEIF_FORWARD_MODEL_H
+#define _WEIF_FORWARD_MODEL_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <boost/math/quadrature/gauss.hpp>
+
+#include <xtensor/containers/xtensor.hpp> // IWYU pragma: keep
+#include <xtensor/views/xview.hpp>
+
+#include <weif/detail/linalg.h>
+#include <weif/progress_token.h>
+#include <weif_export.h>
+
+
+namespace weif {
+namespace prior {
+
+/**
+ * @brief Layered prior with log-uniform layer intensities
+ *
+ * @tparam T Numeric type for calculations
+ *
+ * Every altitude bin independently holds a layer with the given
+ * probability, the integrated intensity of the layer is distributed
+ * log-uniformly between the lower and the upper bounds.
+ */
+template<class T>
+class log_uniform {
+public:
+	using value_type = T; ///< Numeric type for calculations
+
+private:
+	value_type log_min_;
+	value_type log_max_;
+	value_type probability_;
+
+public:
+	/**
+	 * @brief Construct prior
+	 * @param min Lower bound of layer intensity, positive
+	 * @param max Upper bound of layer intensity
+	 * @param probability Probability of a layer in a bin
+	 */
+	log_uniform(value_type min, value_type max, value_type probability = 1):
+		log_min_{std::log(min)},
+		log_max_{std::log(max)},
+		probability_{probability} {}
+
+	template<class RNG>
+	void operator() (RNG& gen, value_type* profile, std::size_t bins) const {
+		std::uniform_real_distribution<value_type> uniform;
+
+		for (std::size_t i = 0; i < bins; ++i) {
+			const auto present = (uniform(gen) < probability_);
+			const auto log_value = log_min_ + (log_max_ - log_min_) * uniform(gen);
+
+			profile[i] = (present ? std::exp(log_value) : static_cast<value_type>(0));
+		}
+	}
+};
+
+} // prior
+
+/**
+ * @brief Monte-Carlo forward model of scintillation indices
+ *
+ * @tparam T Numeric type for calculations
+ *
+ * Maps random turbulence profiles onto the scintillation indices
+ * predicted by a set of weight functions. The altitude range is split
+ * into bins, the profile holds integrated turbulence intensity
+ * \f$ J_b = \int_{h_b}^{h_{b+1}} C_n^2(h) dh \f$ for every bin, and the
+ * index is
+ * \f[
+ * s_f = \sum_b J_b \bar{W}_{bf}, \quad
+ * \bar{W}_{bf} = \frac{1}{h_{b+1} - h_b} \int_{h_b}^{h_{b+1}} W_f(h) dh,
+ * \f]
+ * that assumes uniform \f$ C_n^2 \f$ within every bin. The bin-averaged
+ * weight matrix is computed once at construction by the Gauss-Legendre
+ * quadrature.
+ *
+ * The profiles are drawn from the prior and mapped in blocks of rows by
+ * the dense matrix product. The blocks are distributed over the threads,
+ * and the random generator of every block is seeded from the seed and the
+ * block number, so the result does not depend on the number of threads.
+ *
+ * @par The library uses consistent units:
+ * - Altitudes: kilometers (km)
+ *
+ * @see prior::log_uniform
+ */
+template<class T>
+class WEIF_EXPORT forward_model {
+public:
+	using value_type = T; ///< Numeric type for calculations
+	using rng_type = std::mt19937_64; ///< Random number generator type
+	using prior_type = std::function<void(rng_type&, value_type*, std::size_t)>; ///< Prior filling profile of given number of bins
+	using result_type = xt::xtensor<value_type, 2>; ///< Result tensor type
+
+	static constexpr std::size_t block_size = 256; ///< Number of profiles in a block
+
+private:
+	static constexpr int quadrature_points = 20;
+
+	xt::xtensor<value_type, 1> edges_;
+	xt::xtensor<value_type, 2> weights_;
+
+public:
+	/**
+	 * @brief Construct forward model
+	 * @param wfs Range of weight functions callable with scalar altitude, i.e. weight_function
+	 * @param e Increasing altitude bin edges expression in kilometers
+	 * @param progress Optional progress and cancellation token
+	 *
+	 * @throws cancelled If cancellation is requested through the progress token
+	 */
+	template<class Range, class E>
+	forward_model(const Range& wfs, const xt::xexpression<E>& e, progress_token* progress = nullptr):
+		edges_{e.derived_cast()},
+		weights_{std::array{edges_.size() - 1, static_cast<std::size_t>(std::distance(std::cbegin(wfs), std::cend(wfs)))}} {
+
+		using quadrature = boost::math::quadrature::gauss<value_type, quadrature_points>;
+
+		if (progress) {
+			progress->expect(functions());
+		}
+
+		std::size_t f = 0;
+		for (const auto& wf: wfs) {
+			for (std::size_t b = 0; b < bins(); ++b) {
+				const auto width = edges_(b + 1) - edges_(b);
+
+				weights_(b, f) = quadrature::integrate([&wf] (value_type h) { return static_cast<value_type>(wf(h)); }, edges_(b), edges_(b + 1)) / width;
+			}
+
+			++f;
+
+			if (progress) {
+				progress->advance();
+			}
+		}
+	}
+
+	/// @return Number of altitude bins
+	std::size_t bins() const noexcept { return weights_.shape()[0]; }
+
+	/// @return Number of weight functions
+	std::size_t functions() const noexcept { return weights_.shape()[1]; }
+
+	/// @return Altitude bin edges in kilometers
+	const auto& edges() const noexcept { return edges_; }
+
+	/// @return Bin-averaged weight matrix of shape (bins, functions)
+	const auto& weights() const noexcept { return weights_; }
+
+	/**
+	 * @brief Scintillation indices for given profiles
+	 * @param e Profiles of shape (M, bins)
+	 * @return 2D tensor of shape (M, functions)
+	 */
+	template<class E>
+	result_type operator() (const xt::xexpression<E>& e) const {
+		return detail::multiply(xt::xtensor<value_type, 2>(e.derived_cast()), weights_);
+	}
+
+	/**
+	 * @brief Draw random profiles and pass them with the indices block by block
+	 * @param prior Prior filling profile of given number of bins, i.e. prior::log_uniform
+	 * @param count Number of profiles
+	 * @param sink Callable accepting (first row, profiles, indices) for every block
+	 * @param seed Random seed
+	 * @param threads Number of threads, zero stands for the hardware concurrency
+	 *
+	 * The sink is called sequentially for the blocks in the increasing
+	 * order of rows, so it may write the results to a stream. An exception
+	 * thrown by the prior or the sink stops the generation and is rethrown.
+	 */
+	template<class F>
+	void generate_blocks(const prior_type& prior, std::size_t count, F&& sink, std::uint64_t seed = 0, std::size_t threads = 0) const {
+		const auto blocks = (count + block_size - 1) / block_size;
+
+		if (threads == 0)
+			threads = std::max(std::thread::hardware_concurrency(), 1u);
+		threads = std::max(std::min(threads, blocks), std::size_t{1});
+
+		std::atomic<std::size_t> next{0};
+		std::mutex mutex;
+		std::condition_variable emitted_cv;
+		std::size_t emitted = 0;
+		bool failed = false;
+		std::exception_ptr exception;
+
+		const auto worker = [&] () {
+			for (auto block = next++; block < blocks; block = next++) {
+				const auto first = block * block_size;
+				const auto rows = std::min(block_size, count - first);
+
+				try {
+					std::seed_seq seq{static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32),
+						static_cast<std::uint32_t>(block), static_cast<std::uint32_t>(block >> 32)};
+					rng_type gen{seq};
+
+					xt::xtensor<value_type, 2> profiles{std::array{rows, bins()}};
+					for (std::size_t i = 0; i < rows; ++i) {
+						prior(gen, profiles.data() + i * bins(), bins());
+					}
+
+					const auto indices = detail::multiply(profiles, weights_);
+
+					std::unique_lock<std::mutex> lock(mutex);
+					emitted_cv.wait(lock, [&] () { return emitted == block || failed; });
+
+					if (failed)
+						return;
+
+					sink(first, profiles, indices);
+					++emitted;
+					emitted_cv.notify_all();
+				} catch (...) {
+					std::lock_guard<std::mutex> lock(mutex);
+
+					if (!failed) {
+						failed = true;
+						exception = std::current_exception();
+					}
+
+					emitted_cv.notify_all();
+
+					return;
+				}
+			}
+		};
+
+		std::vector<std::thread> pool;
+		pool.reserve(threads - 1);
+		for (std::size_t t = 1; t < threads; ++t) {
+			pool.emplace_back(worker);
+		}
+
+		worker();
+
+		for (auto& thread: pool) {
+			thread.join();
+		}
+
+		if (exception)
+			std::rethrow_exception(exception);
+	}
+
+	/**
+	 * @brief Draw random profiles and compute the indices
+	 * @param prior Prior filling profile of given number of bins, i.e. prior::log_uniform
+	 * @param count Number of profiles
+	 * @param seed Random seed
+	 * @param threads Number of threads, zero stands for the hardware concurrency
+	 * @return Pair of profiles of shape (count, bins) and indices of shape (count, functions)
+	 */
+	std::pair<result_type, result_type> generate(const prior_type& prior, std::size_t count, std::uint64_t seed = 0, std::size_t threads = 0) const {
+		std::pair<result_type, result_type> ret{result_type{std::array{count, bins()}}, result_type{std::array{count, functions()}}};
+
+		generate_blocks(prior, count, [&ret] (std::size_t first, const auto& profiles, const auto& indices) {
+			const auto rows = profiles.shape()[0];
+
+			xt::view(ret.first, xt::range(first, first + rows), xt::all()) = profiles;
+			xt::view(ret.second, xt::range(first, first + rows), xt::all()) = indices;
+		}, seed, threads);
+
+		return ret;
+	}
+};
+
+extern template class forward_model<float>;
+extern template class forward_model<double>;
+extern template class forward_model<long double>;
+
+} // weif
+
+#endif // _WEIF_FORWARD_MODEL_H
@@ -0,0 +1,241 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#ifndef _WEIF_LAZY_WEIGHT_FUNCTION_H
+#define _WEIF_LAZY_WEIGHT_FUNCTION_H
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+
+#include <xtensor/core/xexpression.hpp> // IWYU pragma: keep
+#include <xtensor/core/xmath.hpp>
+
+#include <weif/detail/weight_function_base.h>
+#include <weif/math.h>
+#include <weif/uniform_grid.h>
+#include <weif_export.h>
+
+
+namespace weif {
+
+/**
+ * @brief Scintillation weight function with on-demand node evaluation
+ *
+ * @tparam T Numeric type used for calculations
+ *
+ * Computes the same quantity as weight_function, but the grid nodes are
+ * not precomputed at construction. Each node is integrated on the first
+ * access to an adjacent interval, so the cost is paid only for the
+ * altitude range actually used, for instance 0-2 km for ground layer
+ * studies.
+ *
+ * Since the global cubic spline of weight_function requires all the
+ * nodes, the interpolation here is the local cubic Hermite one with
+ * central difference slopes (Catmull-Rom). It uses four neighbouring
+ * nodes and has \f$O(h^3)\f$ accuracy, so the grid should be somewhat
+ * denser than for weight_function to reach the same precision.
+ *
+ * Computed nodes are published through a per-node atomic state with
+ * release and acquire ordering, readers never take a lock. The first
+ * accessor claims the node and stores it, concurrent first accesses
+ * compute their own value without waiting, which is harmless. Copies of
+ * the object share the node table.
+ *
+ * @par The library uses consistent units:
+ * - Altitudes: kilometers (km)
+ * - Wavelengths: nanometers (nm)
+ * - Geometric scales: millimeters (mm)
+ *
+ * @see weight_function
+ */
+template<class T>
+class WEIF_EXPORT lazy_weight_function {
+public:
+	using value_type = T; ///< Numeric type for calculations
+
+private:
+	using function_type = std::function<value_type(value_type)>;
+
+	/* The values are plain, since std::atomic<long double> is not lock-free */
+	enum node_state: std::uint8_t {
+		empty,
+		computing,
+		ready
+	};
+
+	struct table {
+		function_type fun;
+		std::unique_ptr<value_type[]> nodes;
+		std::unique_ptr<std::atomic<std::uint8_t>[]> states;
+		std::atomic<std::size_t> computed{0};
+
+		table(function_type&& fun, std::size_t size):
+			fun{std::move(fun)},
+			nodes{new value_type[size]},
+			states{new std::atomic<std::uint8_t>[size]} {
+
+			for (std::size_t i = 0; i < size; ++i) {
+				states[i].store(empty, std::memory_order_relaxed);
+			}
+		}
+	};
+
+	value_type lambda_;
+	value_type aperture_scale_;
+	uniform_grid<value_type> grid_;
+	std::shared_ptr<table> table_;
+
+	lazy_weight_function(value_type lambda, value_type aperture_scale, const uniform_grid<value_type>& grid, function_type&& fun):
+		lambda_{lambda},
+		aperture_scale_{aperture_scale},
+		grid_{grid},
+		table_{std::make_shared<table>(std::move(fun), grid.size())} {}
+
+	value_type node(std::size_t i) const {
+		auto& state = table_->states[i];
+		const value_type z = grid_.origin() + grid_.delta() * static_cast<value_type>(i);
+
+		std::uint8_t expected = state.load(std::memory_order_acquire);
+		if (expected == ready) {
+			return table_->nodes[i];
+		}
+
+		/* Another thread is computing the node, do not wait for it */
+		if (expected != empty || !state.compare_exchange_strong(expected, computing, std::memory_order_acquire)) {
+			return table_->fun(z);
+		}
+
+		try {
+			table_->nodes[i] = table_->fun(z);
+		} catch (...) {
+			state.store(empty, std::memory_order_release);
+			throw;
+		}
+
+		state.store(ready, std::memory_order_release);
+		table_->computed.fetch_add(1, std::memory_order_relaxed);
+
+		return table_->nodes[i];
+	}
+
+	/* Slope in index units, zero at the ends as for the clamped spline of weight_function */
+	value_type slope(std::size_t i) const {
+		if (i == 0 || i + 1 == grid_.size()) {
+			return static_cast<value_type>(0);
+		}
+
+		return (node(i + 1) - node(i - 1)) / 2;
+	}
+
+	/* Node index scale coordinate for given altitude */
+	value_type index(value_type altitude) const noexcept {
+		const value_type fresnel_radius = std::sqrt(lambda() * altitude);
+
+		return (static_cast<value_type>(1) / (static_cast<value_type>(1) + aperture_scale() / fresnel_radius) - grid_.origin()) / grid_.delta();
+	}
+
+	value_type interpolate(value_type x) const {
+		const auto idx = std::min(static_cast<std::size_t>(x), grid_.size() - 2);
+		const auto t = x - static_cast<value_type>(idx);
+		const auto t2 = t * t;
+		const auto t3 = t2 * t;
+
+		const auto h00 = 2 * t3 - 3 * t2 + 1;
+		const auto h10 = t3 - 2 * t2 + t;
+		const auto h01 = -2 * t3 + 3 * t2;
+		const auto h11 = t3 - t2;
+
+		return h00 * node(idx) + h10 * slope(idx) + h01 * node(idx + 1) + h11 * slope(idx + 1);
+	}
+
+public:
+	template<class SF, class AF>
+	lazy_weight_function(SF&& spectral_filter, value_type lambda, AF&& aperture_filter, value_type aperture_scale, const uniform_grid<value_type>& grid):
+		lazy_weight_function(lambda, aperture_scale, grid,
+			detail::dimensionless_weight_function_node<value_type>(std::forward<SF>(spectral_filter), std::forward<AF>(aperture_filter))) {}
+
+	/**
+	 * @brief Construct weight function
+	 * @param spectral_filter Spectral filter function
+	 * @param lambda Wavelength in nanometers
+	 * @param aperture_filter Aperture filter function
+	 * @param aperture_scale Aperture scale in millimeters
+	 * @param size Number of grid nodes
+	 *
+	 * No numerical integration is performed here, the nodes are
+	 * computed on demand when operator()() or precompute() are invoked.
+	 * The filters are copied into the object.
+	 *
+	 * @see operator()()
+	 */
+	template<class SF, class AF>
+	lazy_weight_function(SF&& spectral_filter, value_type lambda, AF&& aperture_filter, value_type aperture_scale, std::size_t size):
+		lazy_weight_function(std::forward<SF>(spectral_filter), lambda, std::forward<AF>(aperture_filter), aperture_scale,
+			uniform_grid{static_cast<value_type>(0), static_cast<value_type>(1) / (size-1), size}) {}
+
+	const auto& lambda() const noexcept { return lambda_; /* nm */ }
+	const auto& aperture_scale() const noexcept { return aperture_scale_; /* mm */ }
+
+	/// @return Total number of grid nodes
+	std::size_t size() const noexcept { return grid_.size(); }
+
+	/// @return Number of nodes computed so far
+	std::size_t computed() const noexcept { return table_->computed.load(std::memory_order_relaxed); }
+
+	/**
+	 * @brief Compute all nodes required for the altitude range in advance
+	 * @param altitude_min Lower altitude in kilometers
+	 * @param altitude_max Upper altitude in kilometers
+	 */
+	void precompute(value_type altitude_min, value_type altitude_max) const {
+		const auto first = static_cast<std::size_t>(std::max(index(altitude_min) - 1, static_cast<value_type>(0)));
+		const auto last = std::min(static_cast<std::size_t>(std::min(index(altitude_max), static_cast<value_type>(grid_.size() - 1))) + 2, grid_.size() - 1);
+
+		for (std::size_t i = first; i <= last; ++i) {
+			node(i);
+		}
+	}
+
+	/**
+	 * @brief Evaluate scintillation weight function at specific altitude
+	 * @param altitude Atmospheric altitude in kilometers
+	 * @return Weight value representing thin layer contribution to scintillation
+	 */
+	value_type operator() (value_type altitude) const {
+		using namespace std;
+
+		constexpr const auto PI = xt::numeric_constants<value_type>::PI;
+		/* 1e13 = pow(1e3, 5.0/6.0) * pow(1e9, 7.0/6.0) */
+		constexpr const value_type c = weif::math::Kolmogorov_Cn2_scale<value_type> * (32 * 1e13) * PI * PI * PI;
+
+		return c * pow(altitude, static_cast<value_type>(5.0/6.0)) / pow(lambda(), static_cast<value_type>(7.0/6.0)) * interpolate(index(altitude));
+	}
+
+	/**
+	 * @brief Evaluate scintillation weight function for tensor input
+	 * @param e Altitude values expression in kilometers
+	 * @return Tensor of scintillation weight function values
+	 */
+	template<class E>
+	auto operator() (const xt::xexpression<E>& e) const {
+		return xt::make_lambda_xfunction([this] (const auto& x) {
+			return this->operator()(x);
+		}, e.derived_cast());
+	}
+};
+
+extern template class lazy_weight_function<float>;
+extern template class lazy_weight_function<double>;
+extern template class lazy_weight_function<long double>;
+
+} // weif
+
+#endif // _WEIF_LAZY_WEIGHT_FUNCTION_H
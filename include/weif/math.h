@@ -8,6 +8,8 @@
 #define _WEIF_MATH_H
 
 #include <cmath>
+#include <complex>
+#include <limits>
 
 #include <boost/math/special_functions/bessel.hpp>
 #include <boost/math/special_functions/sinc.hpp>
@@ -70,6 +72,91 @@ T jinc_pi(const T x) noexcept {
 }
 
 
+/**
+ * @brief Computes the logarithm of the Gamma function for complex argument
+ * @ingroup math_functions
+ *
+ * @tparam T Numeric type
+ * @param z Complex argument, not a non-positive integer
+ * @return Value of \f$\ln\Gamma(z)\f$
+ *
+ * Uses the Lanczos approximation with \f$g = 7\f$ and nine coefficients,
+ * which is accurate to about 15 significant digits. Arguments with
+ * \f$\mathrm{Re}\, z < 1/2\f$ are shifted by the recurrence relation.
+ * For types more precise than double, the argument is shifted by the
+ * recurrence relation to \f$|z| \ge 16\f$ instead, and the Stirling
+ * series with ten terms is used, its truncation error is below
+ * \f$10^{-24}\f$.
+ * The imaginary part is defined modulo \f$2\pi\f$, so the result is not
+ * necessarily the principal branch of \f$\ln\Gamma(z)\f$, though
+ * \f$\exp\f$ of it is always \f$\Gamma(z)\f$.
+ */
+template<class T>
+std::complex<T> lgamma(std::complex<T> z) noexcept {
+	using namespace std;
+
+	constexpr T coef[] = {
+		static_cast<T>(0.99999999999980993227684700473478L),
+		static_cast<T>(676.520368121885098567009190444019L),
+		static_cast<T>(-1259.13921672240287047156078755283L),
+		static_cast<T>(771.3234287776530788486528258894L),
+		static_cast<T>(-176.61502916214059906584551354L),
+		static_cast<T>(12.507343278686904814458936853L),
+		static_cast<T>(-0.13857109526572011689554707L),
+		static_cast<T>(9.984369578019570859563e-6L),
+		static_cast<T>(1.50563273514931155834e-7L)
+	};
+	constexpr T g = 7;
+	constexpr T half_log_two_pi = static_cast<T>(0.91893853320467274178032973640561764L);
+
+	complex<T> shift{0};
+
+	if constexpr (std::numeric_limits<T>::digits > std::numeric_limits<double>::digits) {
+		/* $B_{2k} / (2k (2k - 1))$ */
+		constexpr T stirling[] = {
+			static_cast<T>(1) / 12,
+			static_cast<T>(-1) / 360,
+			static_cast<T>(1) / 1260,
+			static_cast<T>(-1) / 1680,
+			static_cast<T>(1) / 1188,
+			static_cast<T>(-691) / 360360,
+			static_cast<T>(1) / 156,
+			static_cast<T>(-3617) / 122400,
+			static_cast<T>(43867) / 244188,
+			static_cast<T>(-174611) / 125400
+		};
+
+		for (; z.real() < static_cast<T>(0.5) || abs(z) < static_cast<T>(16); z += static_cast<T>(1)) {
+			shift -= log(z);
+		}
+
+		const auto w = static_cast<T>(1) / (z * z);
+
+		complex<T> series{0};
+		for (std::size_t i = std::size(stirling); i > 0; --i) {
+			series = series * w + stirling[i - 1];
+		}
+
+		return shift + half_log_two_pi + (z - static_cast<T>(0.5)) * log(z) - z + series / z;
+	}
+
+	for (; z.real() < static_cast<T>(0.5); z += static_cast<T>(1)) {
+		shift -= log(z);
+	}
+
+	z -= static_cast<T>(1);
+
+	complex<T> x{coef[0]};
+	for (std::size_t i = 1; i < std::size(coef); ++i) {
+		x += coef[i] / (z + static_cast<T>(i));
+	}
+
+	const auto t = z + g + static_cast<T>(0.5);
+
+	return shift + half_log_two_pi + (z + static_cast<T>(0.5)) * log(t) - t + log(x);
+}
+
+
 namespace detail {
 
 	struct jinc_pi_fun {
@@ -0,0 +1,485 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#ifndef _WEIF_PHASE_SCREEN_SIMULATOR_H
+#define _WEIF_PHASE_SCREEN_SIMULATOR_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <exception>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <boost/math/constants/constants.hpp>
+
+#include <xtensor/containers/xtensor.hpp> // IWYU pragma: keep
+#include <xtensor/views/xview.hpp>
+
+#include <weif/detail/fftw3_wrap.h>
+#include <weif/error.h>
+#include <weif/math.h>
+#include <weif/progress_token.h>
+#include <weif/spectral_response.h>
+#include <weif/uniform_grid.h>
+#include <weif_export.h>
+
+
+namespace weif {
+
+/**
+ * @brief Wave-optics Monte-Carlo simulator of scintillation
+ *
+ * @tparam T Numeric type for calculations
+ *
+ * Simulates the propagation of the plane wave through thin turbulent
+ * layers and measures the scintillation index of the star light in the
+ * aperture. It provides an independent cross-check of weight_function
+ * and, via pupil_intensity() and covariance_map_2d, of
+ * weight_function_grid_2d.
+ *
+ * Every layer at altitude \f$ h_l \f$ with the integrated intensity
+ * \f$ J_l = \int C_n^2 dh \f$ is represented by the random phase screen of
+ * the optical path difference with the von Karman power spectrum
+ * \f[
+ * W(f) = C J_l \left(f^2 + L_0^{-2}\right)^{-11/6},
+ * \f]
+ * where \f$ C \f$ is math::Kolmogorov_Cn2_scale, \f$ f \f$ is the
+ * spatial frequency and \f$ L_0 \f$ is the outer scale, infinite outer
+ * scale stands for the Kolmogorov spectrum. The screens are synthesized
+ * by the FFT on the periodic \f$ N \times N \f$ grid, no subharmonics
+ * are added, so the grid has to be much larger than the Fresnel radius
+ * \f$ \sqrt{\lambda h} \f$ and the aperture. The field is propagated from
+ * the top layer down to the ground by the Fresnel angular spectrum method,
+ * the flux is the pupil intensity convolved with the aperture, and the
+ * polychromatic flux is the sum of the fluxes at the wavelengths of the
+ * spectral response.
+ *
+ * The realizations and the wavelengths are distributed over the threads.
+ * The screens of every realization are drawn from the random generator
+ * seeded by the seed and the realization number, so the result does not
+ * depend on the number of threads. The transform plans are shared between
+ * the threads.
+ *
+ * @par The library uses consistent units:
+ * - Altitudes: kilometers (km)
+ * - Wavelengths: nanometers (nm)
+ * - Geometric scales and grid steps: millimeters (mm)
+ * - Turbulence intensities: \f$ m^{1/3} \f$
+ *
+ * @see weight_function
+ * @see covariance_map_2d
+ */
+template<class T>
+class WEIF_EXPORT phase_screen_simulator {
+public:
+	using value_type = T; ///< Numeric type for calculations
+	using complex_type = std::complex<T>;
+	using rng_type = std::mt19937_64; ///< Random number generator type
+
+	/// Measured scintillation index
+	struct result {
+		value_type index;         ///< Scintillation index
+		value_type error;         ///< Standard error of the index estimated over realizations
+		std::size_t realizations; ///< Number of realizations
+	};
+
+private:
+	using layers_type = std::vector<std::pair<value_type, value_type>>;
+
+	std::size_t size_;
+	value_type grid_step_;
+	value_type outer_scale_;
+	xt::xtensor<value_type, 1> lambdas_;
+	xt::xtensor<value_type, 1> weights_;
+	detail::fft_plan_c2c<T> forward_;
+	detail::fft_plan_c2c<T> backward_;
+	std::vector<value_type> frequency2_;
+	std::vector<value_type> amplitude_;
+	std::vector<complex_type> aperture_;
+
+	std::size_t nodes() const noexcept { return size_ * size_; }
+
+	/* Signed index of the wrapped grid node */
+	value_type wrapped(std::size_t i) const noexcept {
+		return static_cast<value_type>(i) - (2 * i < size_ ? static_cast<value_type>(0) : static_cast<value_type>(size_));
+	}
+
+	/* Layers in SI units ordered from the top */
+	template<class E1, class E2>
+	static layers_type make_layers(const xt::xexpression<E1>& a, const xt::xexpression<E2>& j) {
+		const auto& altitudes = a.derived_cast();
+		const auto& intensities = j.derived_cast();
+
+		if (altitudes.size() != intensities.size())
+			throw mismatched_shape{intensities.size(), 1, altitudes.size(), 1};
+
+		layers_type ret;
+		ret.reserve(altitudes.size());
+		for (std::size_t l = 0; l < altitudes.size(); ++l) {
+			ret.emplace_back(static_cast<value_type>(altitudes(l)) * static_cast<value_type>(1e3), static_cast<value_type>(intensities(l)));
+		}
+
+		std::sort(ret.begin(), ret.end(), [] (const auto& x, const auto& y) { return x.first > y.first; });
+
+		return ret;
+	}
+
+	/* Pupil intensity of the realization at the wavelength in SI units */
+	void simulate(const layers_type& layers, rng_type& gen, value_type lambda,
+		std::vector<complex_type>& field, std::vector<complex_type>& screen) const {
+
+		using namespace boost::math::double_constants;
+
+		std::normal_distribution<value_type> normal;
+
+		const auto k = static_cast<value_type>(two_pi) / lambda;
+		const auto norm = static_cast<value_type>(1) / static_cast<value_type>(nodes());
+
+		std::fill(field.begin(), field.end(), complex_type{1});
+
+		for (std::size_t l = 0; l < layers.size(); ++l) {
+			const auto [altitude, intensity] = layers[l];
+			const auto scale = std::sqrt(intensity);
+
+			for (std::size_t i = 0; i < nodes(); ++i) {
+				const auto re = normal(gen);
+				const auto im = normal(gen);
+
+				screen[i] = complex_type{re, im} * (scale * amplitude_[i]);
+			}
+
+			backward_(screen.data(), screen.data());
+
+			for (std::size_t i = 0; i < nodes(); ++i) {
+				field[i] *= std::polar(static_cast<value_type>(1), k * screen[i].real());
+			}
+
+			const auto distance = altitude - (l + 1 < layers.size() ? layers[l + 1].first : static_cast<value_type>(0));
+
+			if (distance > static_cast<value_type>(0)) {
+				const auto chirp = -static_cast<value_type>(pi) * lambda * distance;
+
+				forward_(field.data(), field.data());
+
+				for (std::size_t i = 0; i < nodes(); ++i) {
+					field[i] *= std::polar(norm, chirp * frequency2_[i]);
+				}
+
+				backward_(field.data(), field.data());
+			}
+		}
+	}
+
+	/*
+	 * Calls complete(realization, intensity, buffer) once for every
+	 * realization with the polychromatic pupil intensity and the scratch
+	 * transform buffer of the thread, possibly from several threads
+	 */
+	template<class F>
+	void run(const layers_type& layers, std::size_t realizations, std::uint64_t seed, std::size_t threads,
+		progress_token* progress, F&& complete) const {
+
+		struct pending_type {
+			std::vector<value_type> intensity;
+			std::size_t count = 0;
+		};
+
+		const auto wavelengths = lambdas_.size();
+		const auto tasks = realizations * wavelengths;
+
+		if (threads == 0)
+			threads = std::max(std::thread::hardware_concurrency(), 1u);
+		threads = std::max(std::min(threads, tasks), std::size_t{1});
+
+		if (progress) {
+			progress->expect(tasks);
+		}
+
+		std::atomic<std::size_t> next{0};
+		std::atomic<bool> failed{false};
+		std::mutex mutex;
+		std::map<std::size_t, pending_type> pending;
+		std::exception_ptr exception;
+
+		const auto worker = [&] () {
+			std::vector<complex_type> field(nodes());
+			std::vector<complex_type> screen(nodes());
+
+			try {
+				for (auto task = next++; task < tasks && !failed; task = next++) {
+					const auto r = task / wavelengths;
+					const auto w = task % wavelengths;
+
+					std::seed_seq seq{static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32),
+						static_cast<std::uint32_t>(r), static_cast<std::uint32_t>(r >> 32)};
+					rng_type gen{seq};
+
+					simulate(layers, gen, lambdas_(w) * static_cast<value_type>(1e-9), field, screen);
+
+					std::vector<value_type> intensity;
+					{
+						std::lock_guard<std::mutex> lock(mutex);
+
+						auto& p = pending[r];
+						if (p.intensity.empty()) {
+							p.intensity.assign(nodes(), static_cast<value_type>(0));
+						}
+
+						for (std::size_t i = 0; i < nodes(); ++i) {
+							p.intensity[i] += weights_(w) * std::norm(field[i]);
+						}
+
+						if (++p.count == wavelengths) {
+							intensity = std::move(p.intensity);
+							pending.erase(r);
+						}
+					}
+
+					if (!intensity.empty()) {
+						complete(r, intensity, field);
+					}
+
+					if (progress) {
+						progress->advance();
+					}
+				}
+			} catch (...) {
+				std::lock_guard<std::mutex> lock(mutex);
+
+				if (!failed) {
+					failed = true;
+					exception = std::current_exception();
+				}
+			}
+		};
+
+		std::vector<std::thread> pool;
+		pool.reserve(threads - 1);
+		for (std::size_t t = 1; t < threads; ++t) {
+			pool.emplace_back(worker);
+		}
+
+		worker();
+
+		for (auto& thread: pool) {
+			thread.join();
+		}
+
+		if (exception)
+			std::rethrow_exception(exception);
+	}
+
+public:
+	/**
+	 * @brief Construct polychromatic simulator
+	 * @param size Grid size N, a product of small primes is preferred
+	 * @param grid_step Grid step in millimeters
+	 * @param aperture Callable accepting (x, y) in millimeters relative to the aperture center and returning the aperture transmission
+	 * @param response Spectral response
+	 * @param outer_scale Outer scale of turbulence in millimeters, infinity stands for the Kolmogorov spectrum
+	 */
+	template<class F>
+	phase_screen_simulator(std::size_t size, value_type grid_step, F&& aperture, const spectral_response<value_type>& response,
+		value_type outer_scale = std::numeric_limits<value_type>::infinity()):
+		size_{size},
+		grid_step_{grid_step},
+		outer_scale_{outer_scale},
+		lambdas_{response.grid().values()},
+		weights_{response.normalized().data()},
+		forward_{std::array{static_cast<int>(size), static_cast<int>(size)}, nullptr, nullptr, FFTW_FORWARD, FFTW_ESTIMATE},
+		backward_{std::array{static_cast<int>(size), static_cast<int>(size)}, nullptr, nullptr, FFTW_BACKWARD, FFTW_ESTIMATE},
+		frequency2_(nodes()),
+		amplitude_(nodes()),
+		aperture_(nodes()) {
+
+		const auto step = grid_step_ * static_cast<value_type>(1e-3);
+		const auto df = static_cast<value_type>(1) / (static_cast<value_type>(size_) * step);
+		const auto kappa2 = static_cast<value_type>(1) / (outer_scale_ * outer_scale_ * static_cast<value_type>(1e-6));
+		const auto coef = std::sqrt(math::Kolmogorov_Cn2_scale<value_type>) * df;
+
+		for (std::size_t i = 0; i < size_; ++i) {
+			for (std::size_t j = 0; j < size_; ++j) {
+				const auto n = i * size_ + j;
+				const auto fx = wrapped(i) * df;
+				const auto fy = wrapped(j) * df;
+
+				frequency2_[n] = fx * fx + fy * fy;
+				amplitude_[n] = (n == 0 ? static_cast<value_type>(0) : coef * std::pow(frequency2_[n] + kappa2, static_cast<value_type>(-11) / 12));
+				aperture_[n] = static_cast<value_type>(aperture(wrapped(i) * grid_step_, wrapped(j) * grid_step_));
+			}
+		}
+
+		const auto norm = static_cast<value_type>(1) / static_cast<value_type>(nodes());
+
+		forward_(aperture_.data(), aperture_.data());
+
+		for (auto& x: aperture_) {
+			x *= norm;
+		}
+	}
+
+	/**
+	 * @brief Construct monochromatic simulator
+	 * @param size Grid size N, a product of small primes is preferred
+	 * @param grid_step Grid step in millimeters
+	 * @param aperture Callable accepting (x, y) in millimeters relative to the aperture center and returning the aperture transmission
+	 * @param lambda Wavelength in nanometers
+	 * @param outer_scale Outer scale of turbulence in millimeters, infinity stands for the Kolmogorov spectrum
+	 */
+	template<class F>
+	phase_screen_simulator(std::size_t size, value_type grid_step, F&& aperture, value_type lambda,
+		value_type outer_scale = std::numeric_limits<value_type>::infinity()):
+		phase_screen_simulator(size, grid_step, std::forward<F>(aperture),
+			spectral_response<value_type>{uniform_grid<value_type>{lambda, static_cast<value_type>(1), 1}, xt::ones<value_type>({1})}, outer_scale) {}
+
+	/// @return Grid size N
+	std::size_t size() const noexcept { return size_; }
+
+	/// @return Grid step in millimeters
+	value_type grid_step() const noexcept { return grid_step_; }
+
+	/// @return Outer scale in millimeters
+	value_type outer_scale() const noexcept { return outer_scale_; }
+
+	/// @return Wavelengths in nanometers
+	const auto& lambdas() const noexcept { return lambdas_; }
+
+	/// @return Normalized spectral weights
+	const auto& weights() const noexcept { return weights_; }
+
+	/**
+	 * @brief Measure scintillation index in the aperture
+	 * @param altitudes Layer altitudes expression in kilometers
+	 * @param intensities Layer intensities expression in m^{1/3}
+	 * @param realizations Number of independent realizations
+	 * @param seed Random seed
+	 * @param threads Number of threads, zero stands for the hardware concurrency
+	 * @param progress Optional progress and cancellation token, advanced for every realization and wavelength
+	 * @return Scintillation index and its standard error
+	 *
+	 * The index is the normalized variance of the flux over all aperture
+	 * positions in the grid and all realizations.
+	 *
+	 * @throws mismatched_shape If the numbers of altitudes and intensities differ
+	 * @throws cancelled If cancellation is requested through the progress token
+	 */
+	template<class E1, class E2>
+	result operator() (const xt::xexpression<E1>& altitudes, const xt::xexpression<E2>& intensities, std::size_t realizations,
+		std::uint64_t seed = 0, std::size_t threads = 0, progress_token* progress = nullptr) const {
+
+		const auto layers = make_layers(altitudes, intensities);
+		const auto n = static_cast<value_type>(nodes());
+
+		/* The flux mean and the sum of squared deviations are computed
+		 * for every realization by two passes, and combined afterwards in
+		 * the order of realizations, so the result neither suffers from
+		 * the cancellation in the raw moments nor depends on the threads. */
+		std::vector<value_type> means(realizations);
+		std::vector<value_type> deviations(realizations);
+		std::vector<value_type> indices(realizations);
+
+		run(layers, realizations, seed, threads, progress, [&] (std::size_t r, const std::vector<value_type>& intensity, std::vector<complex_type>& buffer) {
+			std::copy(intensity.begin(), intensity.end(), buffer.begin());
+
+			forward_(buffer.data(), buffer.data());
+			for (std::size_t i = 0; i < nodes(); ++i) {
+				buffer[i] *= aperture_[i];
+			}
+			backward_(buffer.data(), buffer.data());
+
+			value_type s = 0;
+			for (std::size_t i = 0; i < nodes(); ++i) {
+				s += buffer[i].real();
+			}
+
+			const auto mean = s / n;
+
+			value_type s2 = 0;
+			for (std::size_t i = 0; i < nodes(); ++i) {
+				const auto deviation = buffer[i].real() - mean;
+
+				s2 += deviation * deviation;
+			}
+
+			means[r] = mean;
+			deviations[r] = s2;
+			indices[r] = s2 / n / (mean * mean);
+		});
+
+		const auto count = static_cast<value_type>(realizations);
+		const auto mean = std::accumulate(means.begin(), means.end(), static_cast<value_type>(0)) / count;
+
+		/* Parallel variance combination of equally sized samples */
+		value_type s2 = 0;
+		for (std::size_t r = 0; r < realizations; ++r) {
+			s2 += deviations[r] + n * (means[r] - mean) * (means[r] - mean);
+		}
+
+		const auto index = s2 / (n * count) / (mean * mean);
+
+		value_type error = 0;
+		if (realizations > 1) {
+			const auto average = std::accumulate(indices.begin(), indices.end(), static_cast<value_type>(0)) / count;
+
+			for (const auto x: indices) {
+				error += (x - average) * (x - average);
+			}
+
+			error = std::sqrt(error / (count - static_cast<value_type>(1)) / count);
+		}
+
+		return result{index, error, realizations};
+	}
+
+	/**
+	 * @brief Simulate pupil intensity
+	 * @param altitudes Layer altitudes expression in kilometers
+	 * @param intensities Layer intensities expression in m^{1/3}
+	 * @param realizations Number of independent realizations
+	 * @param seed Random seed
+	 * @param threads Number of threads, zero stands for the hardware concurrency
+	 * @param progress Optional progress and cancellation token, advanced for every realization and wavelength
+	 * @return 3D tensor of shape (realizations, N, N) holding polychromatic intensities normalized to the unit incident intensity
+	 *
+	 * The frames may be passed to covariance_map_2d::push_frames(), the
+	 * grid step playing the role of the pixel pitch.
+	 *
+	 * @throws mismatched_shape If the numbers of altitudes and intensities differ
+	 * @throws cancelled If cancellation is requested through the progress token
+	 */
+	template<class E1, class E2>
+	xt::xtensor<value_type, 3> pupil_intensity(const xt::xexpression<E1>& altitudes, const xt::xexpression<E2>& intensities, std::size_t realizations,
+		std::uint64_t seed = 0, std::size_t threads = 0, progress_token* progress = nullptr) const {
+
+		const auto layers = make_layers(altitudes, intensities);
+
+		xt::xtensor<value_type, 3> ret{std::array{realizations, size_, size_}};
+
+		run(layers, realizations, seed, threads, progress, [&] (std::size_t r, const std::vector<value_type>& intensity, std::vector<complex_type>&) {
+			std::copy(intensity.begin(), intensity.end(), ret.data() + r * nodes());
+		});
+
+		return ret;
+	}
+};
+
+extern template class phase_screen_simulator<float>;
+extern template class phase_screen_simulator<double>;
+extern template class phase_screen_simulator<long double>;
+
+} // weif
+
+#endif // _WEIF_PHASE_SCREEN_SIMULATOR_H
@@ -0,0 +1,284 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#ifndef _WEIF_PHOTOMETRIC_MOMENTS_H
+#define _WEIF_PHOTOMETRIC_MOMENTS_H
+
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <utility>
+
+#include <weif/detail/spsc_ring_buffer.h>
+#include <weif_export.h>
+
+
+namespace weif {
+
+/**
+ * @brief Running moments of photon counts in several apertures
+ *
+ * @tparam T Numeric type for calculations
+ * @tparam Channels Number of apertures
+ *
+ * Accumulates the means and the covariances of photon counts measured
+ * simultaneously in Channels apertures and turns them into the normalized
+ * scintillation indices
+ * \f[
+ * s_{ij} = \frac{\mathrm{cov}(n_i, n_j) - \delta_{ij} b_i}{\langle n_i \rangle \langle n_j \rangle},
+ * \f]
+ * which are compared with the weight functions for the same pairs of
+ * apertures, i.e. af::cross_annular weight functions in
+ * example/mass_weight_function.cpp. The indices are packed in the order
+ * of (i, j) pairs with \f$ j \le i \f$: (0, 0), (1, 0), (1, 1), (2, 0), ...
+ *
+ * Every sample is corrected for the non-paralyzable dead time of the
+ * counter, \f$ n = N / (1 - N \tau_d / \tau) \f$, where \f$ N \f$ is the
+ * registered count, \f$ \tau \f$ is the exposure of the sample, and
+ * \f$ \tau_d \f$ is the dead time. The photon noise bias of the variance
+ * is removed by subtracting \f$ b_i = \langle N_i / (1 - N_i \tau_d / \tau)^2 \rangle \f$,
+ * that is the Poisson variance reduced by the dead time and propagated
+ * through the correction.
+ *
+ * The sums are accumulated relative to the first sample of the window to
+ * avoid the cancellation. The per-sample update is a fixed-size loop over
+ * the channels and the packed pairs.
+ */
+template<class T, std::size_t Channels = 4>
+class WEIF_EXPORT photometric_moments {
+public:
+	using value_type = T; ///< Numeric type for calculations
+	static constexpr std::size_t channels = Channels; ///< Number of apertures
+	static constexpr std::size_t indices_size = Channels * (Channels + 1) / 2; ///< Number of indices
+	using sample_type = std::array<value_type, Channels>; ///< Photon counts of single sample
+	using indices_type = std::array<value_type, indices_size>; ///< Packed scintillation indices
+
+private:
+	value_type dead_time_ratio_;
+	std::size_t count_ = 0;
+	sample_type shift_{};
+	sample_type sum_{};
+	sample_type bias_{};
+	indices_type products_{};
+
+public:
+	/**
+	 * @brief Construct empty accumulator
+	 * @param exposure Exposure of single sample
+	 * @param dead_time Dead time of the counter in the same units as exposure
+	 */
+	explicit photometric_moments(value_type exposure = 1, value_type dead_time = 0) noexcept:
+		dead_time_ratio_{dead_time / exposure} {}
+
+	/// @return Number of accumulated samples
+	std::size_t count() const noexcept { return count_; }
+
+	/// Discard accumulated samples
+	void reset() noexcept {
+		count_ = 0;
+		sum_.fill(static_cast<value_type>(0));
+		bias_.fill(static_cast<value_type>(0));
+		products_.fill(static_cast<value_type>(0));
+	}
+
+	/**
+	 * @brief Accumulate single sample
+	 * @param counts Registered photon counts, below the counter saturation
+	 */
+	void add(const sample_type& counts) noexcept {
+		sample_type x, d;
+
+		for (std::size_t c = 0; c < Channels; ++c) {
+			const auto correction = static_cast<value_type>(1) / (static_cast<value_type>(1) - counts[c] * dead_time_ratio_);
+
+			x[c] = counts[c] * correction;
+			bias_[c] += x[c] * correction;
+		}
+
+		if (count_ == 0) {
+			shift_ = x;
+		}
+
+		for (std::size_t c = 0; c < Channels; ++c) {
+			d[c] = x[c] - shift_[c];
+			sum_[c] += d[c];
+		}
+
+		for (std::size_t i = 0, k = 0; i < Channels; ++i) {
+			for (std::size_t j = 0; j <= i; ++j, ++k) {
+				products_[k] += d[i] * d[j];
+			}
+		}
+
+		++count_;
+	}
+
+	/**
+	 * @brief Accumulate range of samples
+	 * @param first Iterator to the first sample
+	 * @param last Iterator past the last sample
+	 */
+	template<class It>
+	void add(It first, It last) noexcept {
+		for (; first != last; ++first) {
+			add(*first);
+		}
+	}
+
+	/// @return Means of dead time corrected counts
+	sample_type means() const noexcept {
+		sample_type ret;
+
+		for (std::size_t c = 0; c < Channels; ++c) {
+			ret[c] = shift_[c] + sum_[c] / static_cast<value_type>(count_);
+		}
+
+		return ret;
+	}
+
+	/**
+	 * @brief Normalized scintillation indices
+	 * @return Packed indices for pairs (i, j), j <= i, NaN for less than two samples
+	 */
+	indices_type indices() const noexcept {
+		indices_type ret;
+
+		if (count_ < 2) {
+			ret.fill(std::numeric_limits<value_type>::quiet_NaN());
+
+			return ret;
+		}
+
+		const auto m = static_cast<value_type>(count_);
+		const auto mean = means();
+
+		for (std::size_t i = 0, k = 0; i < Channels; ++i) {
+			for (std::size_t j = 0; j <= i; ++j, ++k) {
+				auto covariance = (products_[k] - sum_[i] * sum_[j] / m) / (m - static_cast<value_type>(1));
+
+				if (i == j) {
+					covariance -= bias_[i] / m;
+				}
+
+				ret[k] = covariance / (mean[i] * mean[j]);
+			}
+		}
+
+		return ret;
+	}
+};
+
+/**
+ * @brief Streaming pipeline from photon counts to scintillation indices
+ *
+ * @tparam T Numeric type for calculations
+ * @tparam Channels Number of apertures
+ *
+ * The acquisition thread pushes samples into the bounded lock-free
+ * single-producer single-consumer queue, the processing thread drains
+ * the queue into photometric_moments and emits the indices for every
+ * complete exposure window of the given number of samples.
+ *
+ * @code
+ * photometric_pipeline<double> pipeline{1000, 1e-3, 20e-9};
+ * // acquisition thread
+ * pipeline.push({n0, n1, n2, n3});
+ * // processing thread
+ * pipeline.process([] (const auto& indices) { ... });
+ * @endcode
+ *
+ * @see photometric_moments
+ */
+template<class T, std::size_t Channels = 4>
+class WEIF_EXPORT photometric_pipeline {
+public:
+	using value_type = T; ///< Numeric type for calculations
+	using moments_type = photometric_moments<T, Channels>; ///< Accumulator type
+	using sample_type = typename moments_type::sample_type; ///< Photon counts of single sample
+	using indices_type = typename moments_type::indices_type; ///< Packed scintillation indices
+
+private:
+	detail::spsc_ring_buffer<sample_type> queue_;
+	moments_type moments_;
+	std::size_t window_;
+	/* The head of the queue has closed the window already emitted to the callback which threw */
+	bool emitted_ = false;
+
+public:
+	/**
+	 * @brief Construct pipeline
+	 * @param window Number of samples in exposure window
+	 * @param exposure Exposure of single sample
+	 * @param dead_time Dead time of the counter in the same units as exposure
+	 * @param capacity Minimal queue capacity in samples
+	 */
+	photometric_pipeline(std::size_t window, value_type exposure, value_type dead_time, std::size_t capacity = 65536):
+		queue_{capacity},
+		moments_{exposure, dead_time},
+		window_{window} {}
+
+	/// @return Number of samples in exposure window
+	std::size_t window() const noexcept { return window_; }
+
+	/// @return Accumulator of incomplete window
+	const moments_type& moments() const noexcept { return moments_; }
+
+	/**
+	 * @brief Enqueue sample, must be called from single producer thread
+	 * @param sample Registered photon counts
+	 * @return False if the queue is full and the sample is dropped
+	 */
+	bool push(const sample_type& sample) noexcept {
+		return queue_.try_push(sample);
+	}
+
+	/**
+	 * @brief Drain the queue, must be called from single consumer thread
+	 * @param f Callable accepting const indices_type& for every complete window
+	 * @return Number of emitted windows
+	 *
+	 * When f throws, the exception is propagated and the window passed to
+	 * f is considered emitted, the next call continues with the following
+	 * window.
+	 */
+	template<class F>
+	std::size_t process(F&& f) {
+		std::size_t ret = 0;
+
+		queue_.consume([&] (const sample_type& sample) {
+			/* The sample has been accumulated before f threw, but is still queued */
+			if (std::exchange(emitted_, false)) {
+				return;
+			}
+
+			moments_.add(sample);
+
+			if (moments_.count() == window_) {
+				const auto indices = moments_.indices();
+
+				moments_.reset();
+				emitted_ = true;
+				f(indices);
+				emitted_ = false;
+				++ret;
+			}
+		});
+
+		return ret;
+	}
+};
+
+extern template class photometric_moments<float>;
+extern template class photometric_moments<double>;
+extern template class photometric_moments<long double>;
+
+extern template class photometric_pipeline<float>;
+extern template class photometric_pipeline<double>;
+extern template class photometric_pipeline<long double>;
+
+} // weif
+
+#endif // _WEIF_PHOTOMETRIC_MOMENTS_H
@@ -0,0 +1,312 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#ifndef _WEIF_PROFILE_RESTORATION_2D_H
+#define _WEIF_PROFILE_RESTORATION_2D_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <memory>
+
+#include <xtensor/containers/xtensor.hpp> // IWYU pragma: keep
+#include <xtensor/core/xmath.hpp>
+#include <xtensor/generators/xbuilder.hpp>
+#include <xtensor/misc/xmanipulation.hpp>
+#include <xtensor/views/xview.hpp>
+
+#include <weif/detail/linalg.h>
+#include <weif/error.h>
+#include <weif/progress_token.h>
+#include <weif/weight_function_grid_2d.h>
+#include <weif_export.h>
+
+
+namespace weif {
+
+/**
+ * @brief Turbulence profile restoration from spatial covariance maps
+ *
+ * @tparam T Numeric type for calculations
+ *
+ * Restores the non-negative turbulence intensities \f$ x_l \f$ of the
+ * layers at the fixed altitudes \f$ h_l \f$ from the measured spatial
+ * covariance map \f$ C_{jk} \f$ on the uniform grid of apertures by
+ * solving the non-negative least-squares problem
+ * \f[
+ * \min_{x \ge 0} \sum_{jk} w_{jk} \left( C_{jk} - \sum_l x_l W_{jk}(h_l) \right)^2,
+ * \f]
+ * where \f$ W_{jk} \f$ is weight_function_grid_2d and \f$ w_{jk} \ge 0 \f$
+ * are the optional weights of the lags. The map has the same shape
+ * (Nx, Ny) as the weight function and holds non-negative lags only.
+ *
+ * By default all the stored lags have unit weight. Every stored lag
+ * \f$ (j, k) \f$ stands for the lags \f$ (\pm j, \pm k) \f$ of the full
+ * symmetric map, so lag_multiplicity() gives the weights that fit the full
+ * map. Zero weights exclude the lags from the fit, i.e. the zero lag
+ * dominated by the photon noise.
+ *
+ * The kernel stack and the normal equations are computed once at
+ * construction, so the cost of the restoration of every subsequent map
+ * is a single projection onto the kernels, \f$ O(N_x N_y L) \f$, and a
+ * few \f$ O(L^2) \f$ sweeps of the projected coordinate descent. The
+ * descent is warm-started from the previously restored profile, that is
+ * efficient for a stream of maps measured at frame rate.
+ *
+ * The restoration updates the internal state, so a single instance must
+ * not be shared between threads without synchronization.
+ *
+ * @par The library uses consistent units:
+ * - Altitudes: kilometers (km)
+ * - Wavelengths: nanometers (nm)
+ * - Geometric scales and grid steps: millimeters (mm)
+ *
+ * @see weight_function_grid_2d
+ */
+template<class T>
+class WEIF_EXPORT profile_restoration_2d {
+public:
+	using value_type = T; ///< Numeric type for calculations
+	using shape_type = std::array<std::size_t, 2>;
+	using profile_type = xt::xtensor<value_type, 1>; ///< Profile tensor type
+
+private:
+	shape_type shape_;
+	xt::xtensor<value_type, 1> altitudes_;
+	/* square roots of the weights */
+	xt::xtensor<value_type, 1> mask_;
+	xt::xtensor<value_type, 2> kernel_;
+	xt::xtensor<value_type, 2> normal_;
+	profile_type profile_;
+	std::size_t iterations_ = 0;
+
+	std::size_t lags() const noexcept { return std::get<0>(shape_) * std::get<1>(shape_); }
+
+	template<class WF, class E>
+	profile_restoration_2d(const WF& wf, const E& altitudes, xt::xtensor<value_type, 1>&& mask, progress_token* progress):
+		shape_{wf.shape()},
+		altitudes_{altitudes},
+		mask_{std::move(mask)},
+		kernel_{std::array{lags(), altitudes_.size()}},
+		profile_{xt::zeros<value_type>({altitudes_.size()})} {
+
+		if (progress) {
+			progress->expect(altitudes_.size());
+		}
+
+		for (std::size_t l = 0; l < altitudes_.size(); ++l) {
+			xt::view(kernel_, xt::all(), l) = xt::flatten(wf(altitudes_(l))) * mask_;
+
+			if (progress) {
+				progress->advance();
+			}
+		}
+
+		normal_ = detail::multiply_tn(kernel_, kernel_);
+	}
+
+public:
+	/**
+	 * @brief Construct restoration for given layer altitudes
+	 * @param wf Weight function for uniform grid of apertures
+	 * @param altitudes Layer altitudes expression in kilometers
+	 * @param progress Optional progress and cancellation token
+	 *
+	 * @throws cancelled If cancellation is requested through the progress token
+	 */
+	template<class Allocator, class E>
+	profile_restoration_2d(const weight_function_grid_2d<value_type, Allocator>& wf, const xt::xexpression<E>& altitudes,
+		progress_token* progress = nullptr):
+		profile_restoration_2d(wf, altitudes.derived_cast(), xt::ones<value_type>({std::get<0>(wf.shape()) * std::get<1>(wf.shape())}), progress) {}
+
+	/**
+	 * @brief Construct weighted restoration for given layer altitudes
+	 * @param wf Weight function for uniform grid of apertures
+	 * @param altitudes Layer altitudes expression in kilometers
+	 * @param weights Non-negative weights of the lags of shape (Nx, Ny)
+	 * @param progress Optional progress and cancellation token
+	 *
+	 * @throws mismatched_shape If the weights shape differs from the weight function shape
+	 * @throws error If any weight is negative
+	 * @throws cancelled If cancellation is requested through the progress token
+	 *
+	 * @see lag_multiplicity()
+	 */
+	template<class Allocator, class E, class W>
+	profile_restoration_2d(const weight_function_grid_2d<value_type, Allocator>& wf, const xt::xexpression<E>& altitudes,
+		const xt::xexpression<W>& weights, progress_token* progress = nullptr):
+		profile_restoration_2d(wf, altitudes.derived_cast(), make_mask(weights.derived_cast(), wf.shape()), progress) {}
+
+	/**
+	 * @brief Multiplicity of the stored lags in the full symmetric map
+	 * @param shape Grid dimensions (Nx, Ny)
+	 * @return Tensor of shape (Nx, Ny) holding \f$ n_j n_k \f$, where \f$ n_0 = 1 \f$ and \f$ n_j = 2 \f$ otherwise
+	 */
+	static xt::xtensor<value_type, 2> lag_multiplicity(const shape_type& shape) {
+		xt::xtensor<value_type, 2> ret = static_cast<value_type>(4) * xt::ones<value_type>(shape);
+
+		xt::view(ret, 0, xt::all()) /= static_cast<value_type>(2);
+		xt::view(ret, xt::all(), 0) /= static_cast<value_type>(2);
+
+		return ret;
+	}
+
+	/// @return Grid dimensions (Nx, Ny)
+	const auto& shape() const noexcept { return shape_; }
+
+	/// @return Layer altitudes in kilometers
+	const auto& altitudes() const noexcept { return altitudes_; }
+
+	/// @return Kernel stack of shape (Nx * Ny, L) scaled by the square roots of the weights
+	const auto& kernel() const noexcept { return kernel_; }
+
+	/// @return Normal equations matrix of shape (L, L)
+	const auto& normal_matrix() const noexcept { return normal_; }
+
+	/// @return Last restored profile
+	const auto& profile() const noexcept { return profile_; }
+
+	/// @return Number of coordinate descent sweeps done for the last map
+	std::size_t iterations() const noexcept { return iterations_; }
+
+	/// Reset the warm start to zero profile
+	void reset() noexcept {
+		profile_.fill(static_cast<value_type>(0));
+	}
+
+	/**
+	 * @brief Restore profile from covariance map
+	 * @param e Covariance map of shape (Nx, Ny)
+	 * @param tolerance Relative change of the profile to stop the descent
+	 * @param max_iterations Maximum number of coordinate descent sweeps
+	 * @return Reference to restored profile of L layer intensities
+	 *
+	 * The descent starts from the previously restored profile.
+	 *
+	 * @throws mismatched_shape If the map shape differs from the weight function shape
+	 */
+	template<class E>
+	const profile_type& restore(const xt::xexpression<E>& e,
+		value_type tolerance = std::sqrt(std::numeric_limits<value_type>::epsilon()), std::size_t max_iterations = 1000) {
+
+		const auto& map = e.derived_cast();
+
+		if (map.dimension() != 2 || map.shape()[0] != std::get<0>(shape_) || map.shape()[1] != std::get<1>(shape_))
+			throw mismatched_shape{map.shape()[0], (map.dimension() > 1 ? map.shape()[1] : std::size_t{1}), std::get<0>(shape_), std::get<1>(shape_)};
+
+		const xt::xtensor<value_type, 2> masked = xt::reshape_view(xt::eval(xt::flatten(map) * mask_), std::array{lags(), std::size_t{1}});
+		const auto rhs = detail::multiply_tn(kernel_, masked);
+
+		descent(rhs, tolerance, max_iterations);
+
+		return profile_;
+	}
+
+	/**
+	 * @brief Restore profiles from the stream of covariance maps
+	 * @param e Covariance maps of shape (M, Nx, Ny)
+	 * @param tolerance Relative change of the profile to stop the descent
+	 * @param max_iterations Maximum number of coordinate descent sweeps per map
+	 * @return 2D tensor of shape (M, L) holding restored profiles
+	 *
+	 * Every map is warm-started from the profile of the previous one.
+	 *
+	 * @throws mismatched_shape If the map shape differs from the weight function shape
+	 */
+	template<class E>
+	xt::xtensor<value_type, 2> restore_stream(const xt::xexpression<E>& e,
+		value_type tolerance = std::sqrt(std::numeric_limits<value_type>::epsilon()), std::size_t max_iterations = 1000) {
+
+		const auto& maps = e.derived_cast();
+		xt::xtensor<value_type, 2> ret{std::array{maps.shape()[0], altitudes_.size()}};
+
+		for (std::size_t i = 0; i < maps.shape()[0]; ++i) {
+			xt::view(ret, i, xt::all()) = restore(xt::view(maps, i, xt::all(), xt::all()), tolerance, max_iterations);
+		}
+
+		return ret;
+	}
+
+	/**
+	 * @brief Covariance map model for the profile
+	 * @param e Profile of L layer intensities
+	 * @return 2D tensor of shape (Nx, Ny) scaled by the square roots of the weights
+	 */
+	template<class E>
+	xt::xtensor<value_type, 2> model(const xt::xexpression<E>& e) const {
+		const xt::xtensor<value_type, 2> x = xt::reshape_view(xt::eval(e.derived_cast()), std::array{altitudes_.size(), std::size_t{1}});
+
+		return xt::reshape_view(detail::multiply(kernel_, x), shape_);
+	}
+
+private:
+	template<class W>
+	static xt::xtensor<value_type, 1> make_mask(const W& weights, const shape_type& shape) {
+		if (weights.dimension() != 2 || weights.shape()[0] != std::get<0>(shape) || weights.shape()[1] != std::get<1>(shape))
+			throw mismatched_shape{weights.shape()[0], (weights.dimension() > 1 ? weights.shape()[1] : std::size_t{1}), std::get<0>(shape), std::get<1>(shape)};
+
+		const xt::xtensor<value_type, 2> w = weights;
+
+		if (xt::any(w < static_cast<value_type>(0)))
+			throw error("Negative lag weight in profile restoration");
+
+		return xt::sqrt(xt::flatten(w));
+	}
+
+	/* Projected coordinate descent for min x^T G x / 2 - b^T x, x >= 0 */
+	void descent(const xt::xtensor<value_type, 2>& rhs, value_type tolerance, std::size_t max_iterations) noexcept {
+		using namespace std;
+
+		const auto n = altitudes_.size();
+
+		/* gradient G x - b */
+		xt::xtensor<value_type, 1> gradient{std::array{n}};
+		for (std::size_t i = 0; i < n; ++i) {
+			value_type s = -rhs(i, 0);
+			for (std::size_t j = 0; j < n; ++j) {
+				s += normal_(i, j) * profile_(j);
+			}
+
+			gradient(i) = s;
+		}
+
+		for (iterations_ = 0; iterations_ < max_iterations; ) {
+			++iterations_;
+
+			value_type max_delta = 0;
+			value_type max_value = 0;
+
+			for (std::size_t l = 0; l < n; ++l) {
+				const auto diagonal = normal_(l, l);
+				const auto value = (diagonal > static_cast<value_type>(0) ? max(profile_(l) - gradient(l) / diagonal, static_cast<value_type>(0)) : static_cast<value_type>(0));
+				const auto delta = value - profile_(l);
+
+				if (delta != static_cast<value_type>(0)) {
+					for (std::size_t i = 0; i < n; ++i) {
+						gradient(i) += delta * normal_(i, l);
+					}
+
+					profile_(l) = value;
+				}
+
+				max_delta = max(max_delta, abs(delta));
+				max_value = max(max_value, value);
+			}
+
+			if (max_delta <= tolerance * max_value)
+				break;
+		}
+	}
+};
+
+extern template class profile_restoration_2d<float>;
+extern template class profile_restoration_2d<double>;
+extern template class profile_restoration_2d<long double>;
+
+} // weif
+
+#endif // _WEIF_PROFILE_RESTORATION_2D_H
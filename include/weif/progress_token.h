@@ -0,0 +1,89 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#ifndef _WEIF_PROGRESS_TOKEN_H
+#define _WEIF_PROGRESS_TOKEN_H
+
+#include <atomic>
+#include <cstdlib>
+
+#include <weif/error.h>
+#include <weif_export.h>
+
+
+namespace weif {
+
+/**
+ * @brief Progress reporting and cooperative cancellation token
+ *
+ * The token is optionally passed by pointer to heavy constructors such
+ * as weight_function, weight_function_2d, af::angle_averaged, sf::poly
+ * and digital_filter_2d. The constructors announce the number of work
+ * items (usually grid nodes) they are going to process and advance the
+ * counter as the items are completed. Another thread may poll
+ * completed() and total() to display progress, or call cancel() to
+ * abort the construction. In the latter case the constructor throws
+ * weif::cancelled at the next check.
+ *
+ * A single token may be shared by many constructions, for instance to
+ * track a bank of weight functions as a whole.
+ *
+ * All operations use relaxed atomics and are cheap enough to be called
+ * once per integrand evaluation.
+ */
+class WEIF_EXPORT progress_token {
+private:
+	std::atomic<std::size_t> completed_{0};
+	std::atomic<std::size_t> total_{0};
+	std::atomic<bool> cancelled_{false};
+
+public:
+	progress_token() = default;
+	progress_token(const progress_token&) = delete;
+	progress_token& operator=(const progress_token&) = delete;
+
+	/// @brief Request cancellation
+	void cancel() noexcept { cancelled_.store(true, std::memory_order_relaxed); }
+
+	/// @return True if cancellation has been requested
+	bool cancelled() const noexcept { return cancelled_.load(std::memory_order_relaxed); }
+
+	/// @return Number of completed work items
+	std::size_t completed() const noexcept { return completed_.load(std::memory_order_relaxed); }
+
+	/// @return Number of announced work items
+	std::size_t total() const noexcept { return total_.load(std::memory_order_relaxed); }
+
+	/**
+	 * @brief Announce more work items
+	 * @param n Number of work items
+	 */
+	void expect(std::size_t n) noexcept { total_.fetch_add(n, std::memory_order_relaxed); }
+
+	/**
+	 * @brief Throw if cancellation has been requested
+	 * @throws cancelled
+	 */
+	void check() const {
+		if (cancelled())
+			throw weif::cancelled{};
+	}
+
+	/**
+	 * @brief Mark work items as completed
+	 * @param n Number of work items
+	 * @throws cancelled If cancellation has been requested
+	 */
+	void advance(std::size_t n = 1) {
+		check();
+
+		completed_.fetch_add(n, std::memory_order_relaxed);
+	}
+};
+
+} // weif
+
+#endif // _WEIF_PROGRESS_TOKEN_H
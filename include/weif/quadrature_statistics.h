@@ -0,0 +1,182 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#ifndef _WEIF_QUADRATURE_STATISTICS_H
+#define _WEIF_QUADRATURE_STATISTICS_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <mutex>
+#include <numeric>
+#include <type_traits>
+#include <vector>
+
+#include <weif_export.h>
+
+
+namespace weif {
+
+/**
+ * @brief Per-node statistics of numerical integration
+ *
+ * @tparam T Numeric type used for calculations
+ *
+ * An opt-in collector which is passed to heavy constructors like
+ * weight_function or af::angle_averaged. For every precomputed grid
+ * node it records the number of integrand calls, the number of
+ * refinement levels, the error estimate and the L1 norm reported by
+ * the quadrature routine, and the wall time spent for the node.
+ *
+ * The nodes evaluated from the series expansions instead of the
+ * quadrature are marked as analytic. They have no integrand calls and
+ * report the number of series terms instead.
+ *
+ * The collector is shared between the caller and the constructed object,
+ * so the statistics are available from both after the construction.
+ *
+ * @code
+ * auto stats = std::make_shared<quadrature_statistics<double>>();
+ * weight_function<double> wf{sf, lambda, af, aperture_scale, 1025, stats};
+ * for (const auto& r: wf.statistics()->records()) { ... }
+ * @endcode
+ */
+template<class T>
+class WEIF_EXPORT quadrature_statistics {
+public:
+	using value_type = T; ///< Numeric type used for calculations
+	using duration_type = std::chrono::duration<double>; ///< Wall time type, seconds
+
+	/// @brief Statistics for a single grid node
+	struct record {
+		value_type node;         ///< Grid node, the dimensionless variable \f$z\f$
+		std::size_t evaluations; ///< Number of integrand calls, zero for analytic nodes
+		std::size_t levels;      ///< Number of refinement levels
+		value_type error;        ///< Estimated absolute error
+		value_type l1_norm;      ///< Estimated L1 norm of the integrand, or the absolute value for analytic nodes
+		duration_type time;      ///< Wall time spent for the node
+		bool analytic;           ///< Node is evaluated from the series instead of the quadrature
+		std::size_t terms;       ///< Number of series terms for analytic nodes
+	};
+
+private:
+	mutable std::mutex mutex_;
+	std::vector<record> records_;
+
+public:
+	quadrature_statistics() = default;
+
+	/// @brief Append statistics for a node
+	void push(const record& r) {
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		records_.push_back(r);
+	}
+
+	/// @brief Remove all collected records
+	void clear() noexcept {
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		records_.clear();
+	}
+
+	/// @return Snapshot of the collected records in the order of node evaluation
+	std::vector<record> records() const {
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		return records_;
+	}
+
+	/// @return Number of collected records
+	std::size_t size() const noexcept {
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		return records_.size();
+	}
+
+	/// @return Total number of integrand calls of the quadrature nodes
+	std::size_t total_evaluations() const noexcept {
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		return std::accumulate(records_.cbegin(), records_.cend(), std::size_t{0}, [] (std::size_t acc, const record& r) {
+			return acc + r.evaluations;
+		});
+	}
+
+	/// @return Number of nodes evaluated from the series
+	std::size_t analytic_size() const noexcept {
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		return static_cast<std::size_t>(std::count_if(records_.cbegin(), records_.cend(), [] (const record& r) {
+			return r.analytic;
+		}));
+	}
+
+	/// @return Total wall time
+	duration_type total_time() const noexcept {
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		return std::accumulate(records_.cbegin(), records_.cend(), duration_type::zero(), [] (duration_type acc, const record& r) {
+			return acc + r.time;
+		});
+	}
+
+	/// @return The largest error estimate among all nodes
+	value_type max_error() const noexcept {
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		return std::accumulate(records_.cbegin(), records_.cend(), static_cast<value_type>(0), [] (value_type acc, const record& r) {
+			return std::max(acc, r.error);
+		});
+	}
+};
+
+namespace detail {
+
+/*
+ * Integrate f() and record the node statistics when the collector is
+ * given. Both single argument and (x, complement) two argument forms
+ * of the integrand supported by boost::math::quadrature are accepted.
+ */
+template<class T, class Integrator, class F>
+T integrate_node(const Integrator& integrator, const F& f, T tolerance, T node, quadrature_statistics<T>* statistics) {
+	if (!statistics) {
+		return integrator.integrate(f, tolerance);
+	}
+
+	std::size_t evaluations = 0;
+	std::size_t levels = 0;
+	T error = 0;
+	T l1_norm = 0;
+
+	const auto t1 = std::chrono::steady_clock::now();
+
+	const T ret = [&] () {
+		if constexpr (std::is_invocable_v<const F&, T>) {
+			return integrator.integrate([&f, &evaluations] (T x) {
+				++evaluations;
+				return f(x);
+			}, tolerance, &error, &l1_norm, &levels);
+		} else {
+			return integrator.integrate([&f, &evaluations] (T x, T xc) {
+				++evaluations;
+				return f(x, xc);
+			}, tolerance, &error, &l1_norm, &levels);
+		}
+	} ();
+
+	const auto t2 = std::chrono::steady_clock::now();
+
+	statistics->push({node, evaluations, levels, error, l1_norm,
+		std::chrono::duration_cast<typename quadrature_statistics<T>::duration_type>(t2 - t1), false, 0});
+
+	return ret;
+}
+
+} // detail
+} // weif
+
+#endif // _WEIF_QUADRATURE_STATISTICS_H
@@ -8,6 +8,9 @@
 #define _WEIF_SF_GAUSS_H
 
 #include <cmath>
+#include <cstddef>
+
+#include <boost/math/special_functions/hypergeometric_1F1.hpp>
 
 #include <xtensor/core/xmath.hpp>
 #include <xtensor/utils/xutils.hpp>
@@ -81,6 +84,75 @@ public:
 		return e * pow(sin(pix), 2);
 	}
 
+	/**
+	 * @brief Taylor coefficient of Gaussian spectral filter
+	 *
+	 * Evaluates the coefficient of \f$ x^n \f$ in the expansion of
+	 * \f$ E(x) \f$ near zero.
+	 *
+	 * @param n Power of \f$ x \f$
+	 * @return Taylor coefficient
+	 */
+	value_type taylor(std::size_t n) const noexcept {
+		constexpr auto PI = xt::numeric_constants<value_type>::PI;
+		constexpr auto C = static_cast<value_type>(1) / xt::numeric_constants<value_type>::LN2 / 8;
+		const auto b = C * std::pow(fwhm() * PI, 2);
+
+		if (n == 0 || n % 2 != 0)
+			return static_cast<value_type>(0);
+
+		/* Cauchy product of the series for \sin^2(\pi x) and \exp(-b x^2) */
+		value_type ret = 0;
+		value_type envelope = 1;
+		for (std::size_t j = 0; j + 2 <= n; j += 2) {
+			const auto m = n - j;
+
+			value_type sine = -static_cast<value_type>(0.5);
+			for (std::size_t i = 1; i <= m; ++i) {
+				sine *= 2 * PI / static_cast<value_type>(i);
+			}
+
+			ret += (m % 4 == 0 ? sine : -sine) * envelope;
+			envelope *= -b / static_cast<value_type>(j / 2 + 1);
+		}
+
+		return ret;
+	}
+
+	/**
+	 * @brief Mellin transform of Gaussian spectral filter
+	 *
+	 * Evaluates the analytic continuation of
+	 * \f[
+	 * \int_0^{\infty} x^{w - 1} E(x) dx = \frac{\Gamma(w / 2)}{4 b^{w/2}} \left(1 - {}_1F_1\left(\frac{w}{2}; \frac{1}{2}; -\frac{\pi^2}{b}\right)\right),
+	 * \f]
+	 * where \f$ b = \frac{\pi^2 \Lambda^2}{8 \ln 2} \f$, that converges for \f$ w > -2 \f$.
+	 *
+	 * @param w Mellin transform argument
+	 * @return Mellin transform value
+	 */
+	value_type mellin(value_type w) const {
+		using namespace std;
+		using boost::math::hypergeometric_1F1;
+
+		constexpr auto PI = xt::numeric_constants<value_type>::PI;
+		constexpr auto C = static_cast<value_type>(1) / xt::numeric_constants<value_type>::LN2 / 8;
+		const auto b = C * pow(fwhm() * PI, 2);
+
+		if (b == static_cast<value_type>(0))
+			return -tgamma(w) * cos(PI * w / 2) / (2 * pow(2 * PI, w));
+
+		return tgamma(w / 2) / (4 * pow(b, w / 2)) * (1 - hypergeometric_1F1(w / 2, static_cast<value_type>(0.5), -PI * PI / b));
+	}
+
+	/**
+	 * @brief Mean value of Gaussian spectral filter at large argument
+	 * @return \f$ 1/2 \f$ for zero width and zero otherwise
+	 */
+	value_type mean() const noexcept {
+		return (fwhm() == static_cast<value_type>(0) ? static_cast<value_type>(0.5) : static_cast<value_type>(0));
+	}
+
 	/**
 	 * @brief Evaluate regularized Gaussian spectral filter
 	 *
@@ -8,6 +8,7 @@
 #define _WEIF_SF_MONO_H
 
 #include <cmath>
+#include <cstddef>
 #include <type_traits>
 
 #include <xtensor/core/xmath.hpp>
@@ -69,6 +70,57 @@ public:
 		return pow(PI * sinc_pi(PI * x), 2);
 	}
 
+	/**
+	 * @brief Taylor coefficient of monochromatic spectral filter
+	 *
+	 * Evaluates the coefficient of \f$ x^n \f$ in the expansion
+	 * \f$ E(x) = -\frac{1}{2} \sum_{m \ge 1} \frac{(-1)^m (2\pi)^{2m}}{(2m)!} x^{2m} \f$.
+	 *
+	 * @param n Power of \f$ x \f$
+	 * @return Taylor coefficient
+	 */
+	value_type taylor(std::size_t n) const noexcept {
+		constexpr auto PI = xt::numeric_constants<value_type>::PI;
+
+		if (n == 0 || n % 2 != 0)
+			return static_cast<value_type>(0);
+
+		value_type ret = -static_cast<value_type>(0.5);
+		for (std::size_t i = 1; i <= n; ++i) {
+			ret *= 2 * PI / static_cast<value_type>(i);
+		}
+
+		return (n % 4 == 0 ? ret : -ret);
+	}
+
+	/**
+	 * @brief Mellin transform of monochromatic spectral filter
+	 *
+	 * Evaluates the analytic continuation of
+	 * \f[
+	 * \int_0^{\infty} x^{w - 1} E(x) dx = -\frac{\Gamma(w) \cos(\pi w / 2)}{2 (2\pi)^w},
+	 * \f]
+	 * that converges for \f$ -2 < w < 0 \f$.
+	 *
+	 * @param w Mellin transform argument
+	 * @return Mellin transform value
+	 */
+	value_type mellin(value_type w) const noexcept {
+		using namespace std;
+
+		constexpr auto PI = xt::numeric_constants<value_type>::PI;
+
+		return -tgamma(w) * cos(PI * w / 2) / (2 * pow(2 * PI, w));
+	}
+
+	/**
+	 * @brief Mean value of monochromatic spectral filter at large argument
+	 * @return \f$ 1/2 \f$
+	 */
+	value_type mean() const noexcept {
+		return static_cast<value_type>(0.5);
+	}
+
         /**
          * @brief Call operator for monochromatic spectral filter with tensor input
          *
@@ -23,6 +23,7 @@
 
 #include <weif/detail/cubic_spline.h>
 #include <weif/detail/fftw3_wrap.h> // IWYU pragma: keep
+#include <weif/progress_token.h>
 #include <weif/uniform_grid.h>
 #include <weif/spectral_response.h>
 #include <weif_export.h>
@@ -65,33 +66,33 @@ private:
 	value_type carrier_; ///< Carrier wavelength
 	value_type equiv_lambda_; ///< Equivalent wavelength
 
-	value_type eval_equiv_lambda() const;
+	value_type eval_equiv_lambda(progress_token* progress) const;
 
 	template<class E>
-	xt::xtensor<std::complex<value_type>, 1> make_fft(const xt::xexpression<E>& e);
+	static xt::xtensor<std::complex<value_type>, 1> make_fft(const xt::xexpression<E>& e, progress_token* progress);
 
 	template<class E1, class E2>
-	poly(const uniform_grid<value_type>& grid, const xt::xexpression<E1>& real, const xt::xexpression<E2>& imag, value_type carrier):
+	poly(const uniform_grid<value_type>& grid, const xt::xexpression<E1>& real, const xt::xexpression<E2>& imag, value_type carrier, progress_token* progress):
 		grid_{grid},
 		real_{real.derived_cast(), typename detail::first_order_boundary<value_type>{0, 0}},
 		imag_{imag.derived_cast(), typename detail::second_order_boundary<value_type>{0, 0}},
 		carrier_{carrier},
-		equiv_lambda_{eval_equiv_lambda()} {}
+		equiv_lambda_{eval_equiv_lambda(progress)} {}
 
 	template<class E>
-	poly(value_type delta, const xt::xexpression<E>& e, value_type carrier):
+	poly(value_type delta, const xt::xexpression<E>& e, value_type carrier, progress_token* progress):
 		poly({static_cast<value_type>(0), delta, e.derived_cast().size()},
 			xt::real(e.derived_cast()),
 			xt::imag(e.derived_cast()),
-			carrier) {}
+			carrier, progress) {}
 
-	poly(const spectral_response<value_type>& response, std::size_t carrier_idx, std::size_t padded_size):
+	poly(const spectral_response<value_type>& response, std::size_t carrier_idx, std::size_t padded_size, progress_token* progress):
 		poly(static_cast<value_type>(1) / response.grid().delta() / padded_size,
 			make_fft(xt::view(
 				xt::tile(xt::pad(response.data() / response.grid().values(),
 					std::vector<std::size_t>{{0, (padded_size > response.grid().size() ? padded_size - response.grid().size() : 0)}}), {2}),
-				xt::range(carrier_idx, carrier_idx + padded_size))),
-			response.grid().values()[carrier_idx]) {}
+				xt::range(carrier_idx, carrier_idx + padded_size)), progress),
+			response.grid().values()[carrier_idx], progress) {}
 
 public:
 	/**
@@ -99,17 +100,21 @@ public:
 	 * @param response Input spectral response
 	 * @param size Interpolation grid size
 	 * @param carrier Carrier wavelength
+	 * @param progress Optional progress and cancellation token
+	 * @throws cancelled If cancellation is requested through the progress token
 	 */
-	poly(const spectral_response<value_type>& response, std::size_t size, value_type carrier):
-		poly(response, response.grid().to_index(carrier), std::max(response.grid().size(), size)) {}
+	poly(const spectral_response<value_type>& response, std::size_t size, value_type carrier, progress_token* progress = nullptr):
+		poly(response, response.grid().to_index(carrier), std::max(response.grid().size(), size), progress) {}
 
 	/**
 	 * @brief Construct from spectral response
 	 * @param response Input spectral response
 	 * @param size Interpolation grid size
+	 * @param progress Optional progress and cancellation token
+	 * @throws cancelled If cancellation is requested through the progress token
 	 */
-	poly(const spectral_response<value_type>& response, std::size_t size):
-		poly(response, size, response.effective_lambda()) {}
+	poly(const spectral_response<value_type>& response, std::size_t size, progress_token* progress = nullptr):
+		poly(response, size, response.effective_lambda(), progress) {}
 
 	/// @brief Returns frequency grid for the spectral response Fourier transform
 	/// @return Frequency grid for the spectral response Fourier transform
@@ -245,9 +250,15 @@ public:
 
 template<class T>
 template<class E>
-xt::xtensor<std::complex<typename poly<T>::value_type>, 1> poly<T>::make_fft(const xt::xexpression<E>& e) {
+xt::xtensor<std::complex<typename poly<T>::value_type>, 1> poly<T>::make_fft(const xt::xexpression<E>& e, progress_token* progress) {
 	const auto size = e.derived_cast().size();
 
+	/* Fourier transform and equivalent wavelength integration */
+	if (progress) {
+		progress->expect(2);
+		progress->check();
+	}
+
 	xt::xtensor<std::complex<value_type>, 1> ret{std::array{size / 2 + 1}};
 	auto in_adapter = xt::adapt(reinterpret_cast<value_type*>(ret.data()), size, xt::no_ownership(), std::array{size});
 	in_adapter.assign(e);
@@ -258,6 +269,10 @@ xt::xtensor<std::complex<typename poly<T>::value_type>, 1> poly<T>::make_fft(con
 	/* Boundary condition at +inf */
 	ret(ret.size()-1) = std::complex<value_type>{0, 0};
 
+	if (progress) {
+		progress->advance();
+	}
+
 	return ret;
 }
 
@@ -284,12 +299,16 @@ poly<T> poly<T>::normalized() const {
 }
 
 template<class T>
-typename poly<T>::value_type poly<T>::eval_equiv_lambda() const {
+typename poly<T>::value_type poly<T>::eval_equiv_lambda(progress_token* progress) const {
 	using namespace std;
 
 	boost::math::quadrature::exp_sinh<value_type> integrator;
 
-	const auto i = integrator.integrate([this] (value_type x) {
+	const auto i = integrator.integrate([this, progress] (value_type x) {
+		if (progress) {
+			progress->check();
+		}
+
 		if (x == static_cast<value_type>(0.0) || x == std::numeric_limits<value_type>::infinity())
 			return static_cast<value_type>(0.0);
 
@@ -300,6 +319,10 @@ typename poly<T>::value_type poly<T>::eval_equiv_lambda() const {
 		return pow(x, -static_cast<value_type>(11.0/6.0)) * this->operator()(x);
 	});
 
+	if (progress) {
+		progress->advance();
+	}
+
 	return static_cast<value_type>(3.28) * pow(i, -static_cast<value_type>(6.0/7.0));
 }
 
@@ -307,7 +330,11 @@ typename poly<T>::value_type poly<T>::eval_equiv_lambda() const {
 template<class T>
 poly(const spectral_response<T>& response, std::size_t size, T carrier) -> poly<T>;
 template<class T>
+poly(const spectral_response<T>& response, std::size_t size, T carrier, progress_token* progress) -> poly<T>;
+template<class T>
 poly(const spectral_response<T>& response, std::size_t size) -> poly<T>;
+template<class T>
+poly(const spectral_response<T>& response, std::size_t size, progress_token* progress) -> poly<T>;
 
 
 extern template class poly<float>;
@@ -0,0 +1,89 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#ifndef _WEIF_SPECTRUM_KOLMOGOROV_H
+#define _WEIF_SPECTRUM_KOLMOGOROV_H
+
+#include <cmath>
+
+#include <weif_export.h>
+
+
+namespace weif {
+namespace spectrum {
+
+/**
+ * @brief Kolmogorov turbulence spectrum policy
+ *
+ * @tparam T Numeric type used for calculations
+ *
+ * The spectrum policy defines the dimensionless power spectrum of the
+ * refractive index fluctuations \f$ \Phi(u, x) \f$, where \f$ u \f$ is
+ * the spatial frequency in the units of the inverse Fresnel radius
+ * \f$ 1 / \sqrt{\lambda z} \f$ and \f$ x = D / \sqrt{\lambda z} \f$ is
+ * the aperture scale in the units of the Fresnel radius. The policy is
+ * normalized such that the Kolmogorov spectrum is
+ * \f[
+ * \Phi(u, x) = u^{-11/3}.
+ * \f]
+ * It does not depend on \f$ x \f$, so the weight function is
+ * dimensionless, and it is the default policy for all weight functions.
+ *
+ * The policy is passed to the dimensionless integrals after scaled(),
+ * that turns the geometric scales of the policy into the units of the
+ * aperture scale. The policy tells by scale_invariant() whether the
+ * spectrum depends on \f$ x \f$, since the derivatives of the weight
+ * function with respect to the aperture scale and the wavelength are
+ * only available otherwise.
+ *
+ * @see von_karman
+ */
+template<class T>
+struct WEIF_EXPORT kolmogorov {
+	using value_type = T; ///< Numeric type used for calculations
+
+	/**
+	 * @brief Policy with the scales in the units of the aperture scale
+	 * @param aperture_scale Aperture scale in millimeters
+	 * @return Copy of the policy, since the spectrum has no scales
+	 */
+	constexpr kolmogorov scaled(value_type aperture_scale) const noexcept {
+		return *this;
+	}
+
+	/**
+	 * @brief Check that the spectrum does not depend on the aperture scale
+	 * @return true, since \f$ \Phi(u, x) \f$ does not depend on \f$ x \f$
+	 */
+	constexpr bool scale_invariant() const noexcept {
+		return true;
+	}
+
+	/**
+	 * @brief Evaluate dimensionless spectrum
+	 * @param u2 Squared dimensionless spatial frequency \f$ u^2 \f$
+	 * @param x Aperture scale in the units of the Fresnel radius
+	 * @return \f$ u^{-11/3} \f$
+	 */
+	value_type operator() (value_type u2, value_type x) const noexcept {
+		return std::pow(u2, -static_cast<value_type>(11.0/6.0));
+	}
+
+	/**
+	 * @brief Evaluate regularized dimensionless spectrum
+	 * @param u2 Squared dimensionless spatial frequency \f$ u^2 \f$
+	 * @param x Aperture scale in the units of the Fresnel radius
+	 * @return \f$ u^4 \Phi(u, x) = u^{1/3} \f$
+	 */
+	value_type regular(value_type u2, value_type x) const noexcept {
+		return std::pow(u2, static_cast<value_type>(1.0/6.0));
+	}
+};
+
+} // spectrum
+} // weif
+
+#endif // _WEIF_SPECTRUM_KOLMOGOROV_H
@@ -0,0 +1,143 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#ifndef _WEIF_SPECTRUM_VON_KARMAN_H
+#define _WEIF_SPECTRUM_VON_KARMAN_H
+
+#include <cmath>
+#include <limits>
+
+#include <xtensor/core/xmath.hpp>
+
+#include <weif_export.h>
+
+
+namespace weif {
+namespace spectrum {
+
+/**
+ * @brief Von Karman turbulence spectrum policy with the inner scale
+ *
+ * @tparam T Numeric type used for calculations
+ *
+ * The spectrum of the spatial frequency \f$ f \f$ is
+ * \f[
+ * \Phi(f) \propto \left(f^2 + L_0^{-2}\right)^{-11/6} \exp\left(-\left(\frac{2 \pi f l_0}{5.92}\right)^2\right),
+ * \f]
+ * where \f$ L_0 \f$ is the outer scale and \f$ l_0 \f$ is the inner
+ * scale, the latter follows the Tatarskii cut-off
+ * \f$ \kappa_m = 5.92 / l_0 \f$. Infinite outer scale and zero inner
+ * scale stand for the Kolmogorov spectrum.
+ *
+ * In dimensionless units of kolmogorov the spectrum is
+ * \f[
+ * \Phi(u, x) = \left(u^2 + \frac{1}{x^2 L^2}\right)^{-11/6} \exp\left(-\left(\frac{2 \pi u x l}{5.92}\right)^2\right),
+ * \f]
+ * where \f$ L = L_0 / D \f$ and \f$ l = l_0 / D \f$ are the scales in the
+ * units of the aperture scale \f$ D \f$ returned by scaled(). So the
+ * dimensionless weight function is defined by the filters and the two
+ * ratios, and it is shared by all the wavelengths, the aperture scales
+ * and the outer scales of the same ratios.
+ *
+ * @see kolmogorov
+ * @see weight_function_cache
+ */
+template<class T>
+class WEIF_EXPORT von_karman {
+public:
+	using value_type = T; ///< Numeric type used for calculations
+
+private:
+	value_type outer_scale_;
+	value_type inner_scale_;
+
+public:
+	/**
+	 * @brief Construct spectrum policy
+	 * @param outer_scale Outer scale in millimeters
+	 * @param inner_scale Inner scale in millimeters
+	 */
+	explicit von_karman(value_type outer_scale = std::numeric_limits<value_type>::infinity(), value_type inner_scale = 0) noexcept:
+		outer_scale_{outer_scale},
+		inner_scale_{inner_scale} {}
+
+	/// @return Outer scale
+	const auto& outer_scale() const noexcept { return outer_scale_; }
+
+	/// @return Inner scale
+	const auto& inner_scale() const noexcept { return inner_scale_; }
+
+	/**
+	 * @brief Policy with the scales in the units of the aperture scale
+	 * @param aperture_scale Aperture scale in millimeters
+	 * @return Policy with \f$ L_0 / D \f$ and \f$ l_0 / D \f$ scales
+	 */
+	von_karman scaled(value_type aperture_scale) const noexcept {
+		return von_karman{outer_scale_ / aperture_scale, inner_scale_ / aperture_scale};
+	}
+
+	/**
+	 * @brief Check that the spectrum does not depend on the aperture scale
+	 * @return true for infinite outer scale and zero inner scale, i.e. for the Kolmogorov spectrum
+	 */
+	bool scale_invariant() const noexcept {
+		return outer_scale_ == std::numeric_limits<value_type>::infinity() && inner_scale_ == static_cast<value_type>(0);
+	}
+
+	/**
+	 * @brief Evaluate dimensionless spectrum
+	 * @param u2 Squared dimensionless spatial frequency \f$ u^2 \f$
+	 * @param x Aperture scale in the units of the Fresnel radius
+	 * @return \f$ \Phi(u, x) \f$
+	 */
+	value_type operator() (value_type u2, value_type x) const noexcept {
+		using namespace std;
+
+		return pow(u2 + outer(x), -static_cast<value_type>(11.0/6.0)) * inner(u2, x);
+	}
+
+	/**
+	 * @brief Evaluate regularized dimensionless spectrum
+	 * @param u2 Squared dimensionless spatial frequency \f$ u^2 \f$
+	 * @param x Aperture scale in the units of the Fresnel radius
+	 * @return \f$ u^4 \Phi(u, x) \f$
+	 */
+	value_type regular(value_type u2, value_type x) const noexcept {
+		using namespace std;
+
+		return u2 * u2 * pow(u2 + outer(x), -static_cast<value_type>(11.0/6.0)) * inner(u2, x);
+	}
+
+private:
+	/* Squared outer scale frequency in the units of the inverse Fresnel radius */
+	value_type outer(value_type x) const noexcept {
+		if (outer_scale_ == std::numeric_limits<value_type>::infinity())
+			return static_cast<value_type>(0);
+
+		const auto s = x * outer_scale_;
+
+		return static_cast<value_type>(1) / (s * s);
+	}
+
+	value_type inner(value_type u2, value_type x) const noexcept {
+		using namespace std;
+
+		constexpr const auto PI = xt::numeric_constants<value_type>::PI;
+		constexpr const auto scale = static_cast<value_type>(2 * PI / 5.92);
+
+		if (inner_scale_ == static_cast<value_type>(0))
+			return static_cast<value_type>(1);
+
+		const auto s = scale * x * inner_scale_;
+
+		return exp(-u2 * s * s);
+	}
+};
+
+} // spectrum
+} // weif
+
+#endif // _WEIF_SPECTRUM_VON_KARMAN_H
@@ -18,6 +18,9 @@
 #include <xtensor/core/xmath.hpp>
 
 #include <weif/detail/weight_function_base.h>
+#include <weif/progress_token.h>
+#include <weif/quadrature_statistics.h>
+#include <weif/spectrum/kolmogorov.h>
 #include <weif_export.h>
 
 
@@ -33,6 +36,22 @@ namespace weif {
  * W(z) = 9.69 \cdot 10^{-3} \cdot 32 \pi^3 z^{5/6} \lambda^{-7/6} \int_0^{\infty} du u^{-8/3} S(u) A\left(\frac{D}{\sqrt{\lambda z}} u\right),
  * \f]
  * where \f$ S(u) \f$ is a spectral filter, \f$ \lambda \f$ is its equivalent wavelength, and \f$ A(u) \f$ is an aperture filter.
+ * The Kolmogorov power law is replaced by the spectrum policy when it is
+ * given, i.e. spectrum::von_karman.
+ *
+ * For sf::mono together with af::circular or af::annular and the
+ * Kolmogorov spectrum the dimensionless integral is evaluated from its
+ * Mellin-Barnes series for small and asymptotic expansion for large
+ * aperture scales, and the quadrature is used only in between where
+ * neither of them reaches the tolerance.
+ *
+ * For other filters exposing their small and large argument moments,
+ * i.e. taylor(), mellin(), and mean() of sf::mono and sf::gauss, and
+ * taylor(), mellin(), and tail() of af::circular, af::annular, and
+ * af::gauss, the leading asymptotics with a few correction terms are
+ * used at the extreme nodes \f$ z \to 0 \f$ and \f$ z \to 1 \f$,
+ * where the aperture is either much larger than the Fresnel zone or
+ * negligible.
  *
  * @par The library uses consistent units:
  * - Altitudes: kilometers (km)
@@ -41,6 +60,7 @@ namespace weif {
  *
  * @see sf::poly::equiv_lambda()
  * @see weif::math::Kolmogorov_Cn2_scale
+ * @see spectrum::kolmogorov
  */
 template<class T>
 class WEIF_EXPORT weight_function:
@@ -52,10 +72,60 @@ private:
 	using function_type = std::function<value_type(value_type, value_type)>;
 
 public:
-	template<class SF, class AF>
-	weight_function(SF&& spectral_filter, value_type lambda, AF&& aperture_filter, value_type aperture_scale, const uniform_grid<value_type>& grid):
+	template<class SF, class AF, class Spectrum>
+	weight_function(SF&& spectral_filter, value_type lambda, AF&& aperture_filter, value_type aperture_scale, const Spectrum& spectrum,
+		const uniform_grid<value_type>& grid, const std::shared_ptr<quadrature_statistics<value_type>>& statistics = nullptr, progress_token* progress = nullptr):
 		detail::weight_function_base<T>(lambda, aperture_scale, grid,
-			detail::dimensionless_weight_function(std::forward<SF>(spectral_filter), std::forward<AF>(aperture_filter), grid.values())) {}
+			detail::dimensionless_weight_function(std::forward<SF>(spectral_filter), std::forward<AF>(aperture_filter), grid.values(), statistics.get(), progress,
+				detail::scaled_spectrum(spectrum, aperture_scale)),
+			statistics, spectrum.scale_invariant()) {}
+
+	template<class SF, class AF>
+	weight_function(SF&& spectral_filter, value_type lambda, AF&& aperture_filter, value_type aperture_scale, const uniform_grid<value_type>& grid,
+		const std::shared_ptr<quadrature_statistics<value_type>>& statistics = nullptr, progress_token* progress = nullptr):
+		weight_function(std::forward<SF>(spectral_filter), lambda, std::forward<AF>(aperture_filter), aperture_scale,
+			spectrum::kolmogorov<value_type>{}, grid, statistics, progress) {}
+
+	/**
+	 * @brief Construct weight function for given turbulence spectrum
+	 * @param spectral_filter Spectral filter function
+	 * @param lambda Wavelength in nanometers
+	 * @param aperture_filter Aperture filter function
+	 * @param aperture_scale Aperture scale in millimeters
+	 * @param spectrum Turbulence spectrum policy, i.e. spectrum::von_karman
+	 * @param size Number of grid points for precomputation
+	 * @param statistics Optional collector of per-node quadrature statistics
+	 * @param progress Optional progress and cancellation token
+	 *
+	 * The Kolmogorov power law \f$ u^{-11/3} \f$ in the integral is
+	 * replaced by the spectrum policy. The derivatives are not available
+	 * unless the spectrum is scale invariant.
+	 *
+	 * @throws error If the aperture scale is zero and the spectrum is not scale invariant
+	 * @throws cancelled If cancellation is requested through the progress token
+	 *
+	 * @see weight_function_cache
+	 */
+	template<class SF, class AF, class Spectrum>
+	weight_function(SF&& spectral_filter, value_type lambda, AF&& aperture_filter, value_type aperture_scale, const Spectrum& spectrum, std::size_t size,
+		const std::shared_ptr<quadrature_statistics<value_type>>& statistics = nullptr, progress_token* progress = nullptr):
+		weight_function(std::forward<SF>(spectral_filter), lambda, std::forward<AF>(aperture_filter), aperture_scale, spectrum,
+			uniform_grid{static_cast<value_type>(0), static_cast<value_type>(1) / (size-1), size}, statistics, progress) {}
+
+	/**
+	 * @brief Construct weight function from precomputed dimensionless values
+	 * @param lambda Wavelength in nanometers
+	 * @param aperture_scale Aperture scale in millimeters
+	 * @param grid Grid of the dimensionless values
+	 * @param values Dimensionless weight function at the grid nodes
+	 * @param scale_invariant Whether the values depend on the aperture scale only through \f$ D / \sqrt{\lambda z} \f$, see spectrum::von_karman::scale_invariant()
+	 *
+	 * @see weight_function_cache
+	 */
+	template<class E>
+	weight_function(value_type lambda, value_type aperture_scale, const uniform_grid<value_type>& grid, const xt::xexpression<E>& values,
+		bool scale_invariant = true):
+		detail::weight_function_base<T>(lambda, aperture_scale, grid, values, nullptr, scale_invariant) {}
 
 	/**
 	 * @brief Construct weight function
@@ -64,17 +134,30 @@ public:
 	 * @param aperture_filter Aperture filter function
 	 * @param aperture_scale Aperture scale in millimeters
 	 * @param size Number of grid points for precomputation
+	 * @param statistics Optional collector of per-node quadrature statistics
+	 * @param progress Optional progress and cancellation token
 	 *
 	 * The weight function is precomputed on a grid of `size` nodes using
 	 * numerical integration technique and subsequent interpolation is used
 	 * when the weight_function::operator()() is invoked.
 	 *
+	 * @throws cancelled If cancellation is requested through the progress token
+	 *
 	 * @see operator()()
 	 */
 	template<class SF, class AF>
-	weight_function(SF&& spectral_filter, value_type lambda, AF&& aperture_filter, value_type aperture_scale, std::size_t size):
+	weight_function(SF&& spectral_filter, value_type lambda, AF&& aperture_filter, value_type aperture_scale, std::size_t size,
+		const std::shared_ptr<quadrature_statistics<value_type>>& statistics = nullptr, progress_token* progress = nullptr):
 		weight_function(std::forward<SF>(spectral_filter), lambda, std::forward<AF>(aperture_filter), aperture_scale,
-			uniform_grid{static_cast<value_type>(0), static_cast<value_type>(1) / (size-1), size}) {}
+			uniform_grid{static_cast<value_type>(0), static_cast<value_type>(1) / (size-1), size}, statistics, progress) {}
+
+	/**
+	 * @brief Returns per-node quadrature statistics
+	 * @return Statistics collector passed to the constructor, or nullptr when the statistics were not requested
+	 */
+	const std::shared_ptr<const quadrature_statistics<value_type>>& statistics() const noexcept {
+		return detail::weight_function_base<T>::statistics();
+	}
 
 	/**
 	 * @brief Evaluate scintillation weight function at specific altitude
@@ -99,6 +182,56 @@ public:
 			return this->operator()(x);
 		}, e.derived_cast());
 	}
+
+	/**
+	 * @brief Evaluate derivative of weight function with respect to the aperture scale
+	 * @param altitude Atmospheric altitude in kilometers
+	 * @return \f$ \partial W / \partial D \f$ per millimeter
+	 *
+	 * The derivative is obtained from the cubic spline of the
+	 * precomputed dimensionless weight function, so it costs no
+	 * additional integration. The derivative with respect to the
+	 * magnification \f$ m \f$ of the aperture scale is
+	 * \f$ (D / m) \partial W / \partial D \f$.
+	 *
+	 * The spline gives the derivative with respect to
+	 * \f$ D / \sqrt{\lambda z} \f$ only, so the derivative is
+	 * available for the Kolmogorov spectrum only. The outer and the inner
+	 * scales of spectrum::von_karman enter the table as \f$ L_0 / D \f$
+	 * and \f$ l_0 / D \f$, whose contribution is not tabulated.
+	 *
+	 * @throws error If the weight function is computed for a spectrum with the outer or the inner scale
+	 */
+	inline value_type aperture_scale_derivative(value_type altitude) const {
+		constexpr const auto PI = xt::numeric_constants<value_type>::PI;
+		constexpr const value_type c = 2 * PI;
+
+		return c * detail::weight_function_base<T>::aperture_scale_derivative(altitude);
+	}
+
+	/**
+	 * @brief Evaluate derivative of weight function with respect to the wavelength
+	 * @param altitude Atmospheric altitude in kilometers
+	 * @return \f$ \partial W / \partial \lambda \f$ per nanometer
+	 *
+	 * The wavelength is varied at the fixed shape of the spectral filter,
+	 * i.e. this is the derivative with respect to the equivalent
+	 * wavelength of sf::poly. The derivative is obtained from the cubic
+	 * spline of the precomputed dimensionless weight function.
+	 *
+	 * Like aperture_scale_derivative(), the derivative is available for
+	 * the Kolmogorov spectrum only, since the scales of
+	 * spectrum::von_karman are measured in the units of \f$ D \f$ and
+	 * not of the Fresnel radius \f$ \sqrt{\lambda z} \f$.
+	 *
+	 * @throws error If the weight function is computed for a spectrum with the outer or the inner scale
+	 */
+	inline value_type lambda_derivative(value_type altitude) const {
+		constexpr const auto PI = xt::numeric_constants<value_type>::PI;
+		constexpr const value_type c = 2 * PI;
+
+		return c * detail::weight_function_base<T>::lambda_derivative(altitude);
+	}
 };
 
 extern template class weight_function<float>;
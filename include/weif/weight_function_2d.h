@@ -9,6 +9,7 @@
 
 #include <cmath>
 #include <limits>
+#include <memory>
 #include <utility>
 
 #include <boost/math/quadrature/exp_sinh.hpp>
@@ -17,6 +18,9 @@
 #include <xtensor/core/xmath.hpp>
 
 #include <weif/detail/weight_function_base.h>
+#include <weif/progress_token.h>
+#include <weif/quadrature_statistics.h>
+#include <weif/spectrum/kolmogorov.h>
 #include <weif_export.h>
 
 
@@ -51,10 +55,39 @@ private:
 	using function_type = std::function<value_type(value_type, value_type, value_type)>;
 
 public:
-	template<class SF, class AF>
-	weight_function_2d(SF&& spectral_filter, value_type lambda, AF&& aperture_filter, value_type aperture_scale, const uniform_grid<value_type>& grid):
+	template<class SF, class AF, class Spectrum>
+	weight_function_2d(SF&& spectral_filter, value_type lambda, AF&& aperture_filter, value_type aperture_scale, const Spectrum& spectrum,
+		const uniform_grid<value_type>& grid, const std::shared_ptr<quadrature_statistics<value_type>>& statistics = nullptr, progress_token* progress = nullptr):
 		detail::weight_function_base<T>(lambda, aperture_scale, grid,
-			detail::dimensionless_weight_function_2d(std::forward<SF>(spectral_filter), std::forward<AF>(aperture_filter), grid.values())) {}
+			detail::dimensionless_weight_function_2d(std::forward<SF>(spectral_filter), std::forward<AF>(aperture_filter), grid.values(), statistics.get(), progress,
+				detail::scaled_spectrum(spectrum, aperture_scale)),
+			statistics, spectrum.scale_invariant()) {}
+
+	template<class SF, class AF>
+	weight_function_2d(SF&& spectral_filter, value_type lambda, AF&& aperture_filter, value_type aperture_scale, const uniform_grid<value_type>& grid,
+		const std::shared_ptr<quadrature_statistics<value_type>>& statistics = nullptr, progress_token* progress = nullptr):
+		weight_function_2d(std::forward<SF>(spectral_filter), lambda, std::forward<AF>(aperture_filter), aperture_scale,
+			spectrum::kolmogorov<value_type>{}, grid, statistics, progress) {}
+
+	/**
+	 * @brief Construct 2D weight function for given turbulence spectrum
+	 * @param spectral_filter Spectral filter function
+	 * @param lambda Wavelength in nanometers
+	 * @param aperture_filter 2D aperture filter function
+	 * @param aperture_scale Aperture scale in millimeters
+	 * @param spectrum Turbulence spectrum policy, i.e. spectrum::von_karman
+	 * @param size Number of grid points for precomputation
+	 * @param statistics Optional collector of per-node quadrature statistics
+	 * @param progress Optional progress and cancellation token
+	 *
+	 * @throws error If the aperture scale is zero and the spectrum is not scale invariant
+	 * @throws cancelled If cancellation is requested through the progress token
+	 */
+	template<class SF, class AF, class Spectrum>
+	weight_function_2d(SF&& spectral_filter, value_type lambda, AF&& aperture_filter, value_type aperture_scale, const Spectrum& spectrum, std::size_t size,
+		const std::shared_ptr<quadrature_statistics<value_type>>& statistics = nullptr, progress_token* progress = nullptr):
+		weight_function_2d(std::forward<SF>(spectral_filter), lambda, std::forward<AF>(aperture_filter), aperture_scale, spectrum,
+			uniform_grid{static_cast<value_type>(0), static_cast<value_type>(1) / (size-1), size}, statistics, progress) {}
 
 	/**
 	 * @brief Construct 2D weight function
@@ -63,17 +96,30 @@ public:
 	 * @param aperture_filter 2D aperture filter function
 	 * @param aperture_scale Aperture scale in millimeters
 	 * @param size Number of grid points for precomputation
+	 * @param statistics Optional collector of per-node quadrature statistics
+	 * @param progress Optional progress and cancellation token
 	 *
 	 * The weight function is precomputed on a grid of `size` nodes using
 	 * numerical integration technique and subsequent interpolation is used
 	 * when the weight_function_2d::operator()() is invoked.
 	 *
+	 * @throws cancelled If cancellation is requested through the progress token
+	 *
 	 * @see operator()()
 	 */
 	template<class SF, class AF>
-	weight_function_2d(SF&& spectral_filter, value_type lambda, AF&& aperture_filter, value_type aperture_scale, std::size_t size):
+	weight_function_2d(SF&& spectral_filter, value_type lambda, AF&& aperture_filter, value_type aperture_scale, std::size_t size,
+		const std::shared_ptr<quadrature_statistics<value_type>>& statistics = nullptr, progress_token* progress = nullptr):
 		weight_function_2d(std::forward<SF>(spectral_filter), lambda, std::forward<AF>(aperture_filter), aperture_scale,
-			uniform_grid{static_cast<value_type>(0), static_cast<value_type>(1) / (size-1), size}) {}
+			uniform_grid{static_cast<value_type>(0), static_cast<value_type>(1) / (size-1), size}, statistics, progress) {}
+
+	/**
+	 * @brief Returns per-node quadrature statistics
+	 * @return Statistics collector passed to the constructor, or nullptr when the statistics were not requested
+	 */
+	const std::shared_ptr<const quadrature_statistics<value_type>>& statistics() const noexcept {
+		return detail::weight_function_base<T>::statistics();
+	}
 
 	/**
 	 * @brief Evaluate scintillation weight function at specific altitude
@@ -95,6 +141,32 @@ public:
 			return this->operator()(x);
 		}, e.derived_cast());
 	}
+
+	/**
+	 * @brief Evaluate derivative of weight function with respect to the aperture scale
+	 * @param altitude Atmospheric altitude in kilometers
+	 * @return \f$ \partial W / \partial D \f$ per millimeter
+	 *
+	 * @throws error If the weight function is computed for a spectrum with the outer or the inner scale
+	 *
+	 * @see weight_function::aperture_scale_derivative()
+	 */
+	inline value_type aperture_scale_derivative(value_type altitude) const {
+		return detail::weight_function_base<T>::aperture_scale_derivative(altitude);
+	}
+
+	/**
+	 * @brief Evaluate derivative of weight function with respect to the wavelength
+	 * @param altitude Atmospheric altitude in kilometers
+	 * @return \f$ \partial W / \partial \lambda \f$ per nanometer
+	 *
+	 * @throws error If the weight function is computed for a spectrum with the outer or the inner scale
+	 *
+	 * @see weight_function::lambda_derivative()
+	 */
+	inline value_type lambda_derivative(value_type altitude) const {
+		return detail::weight_function_base<T>::lambda_derivative(altitude);
+	}
 };
 
 extern template class weight_function_2d<float>;
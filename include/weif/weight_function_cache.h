@@ -0,0 +1,161 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#ifndef _WEIF_WEIGHT_FUNCTION_CACHE_H
+#define _WEIF_WEIGHT_FUNCTION_CACHE_H
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include <xtensor/containers/xtensor.hpp> // IWYU pragma: keep
+
+#include <weif/detail/weight_function_base.h>
+#include <weif/progress_token.h>
+#include <weif/spectrum/von_karman.h>
+#include <weif/uniform_grid.h>
+#include <weif/weight_function.h>
+#include <weif_export.h>
+
+
+namespace weif {
+
+/**
+ * @brief Cache of weight functions for sweeps over turbulence spectrum scales
+ *
+ * @tparam T Numeric type for calculations
+ *
+ * For the spectrum::von_karman policy the weight function is no longer
+ * dimensionless, but its dimensionless table depends only on the filters
+ * and the outer and the inner scales in the units of the aperture scale,
+ * \f$ L_0 / D \f$ and \f$ l_0 / D \f$. The cache keeps the tables keyed by
+ * these ratios, so the sweeps over the wavelength, the aperture scale and
+ * the outer scale compute every distinct table only once, and all other
+ * weight functions are built by the cubic spline interpolation only.
+ *
+ * The cache may be shared between threads. Concurrent requests of the
+ * same missing table may compute it more than once, but the first
+ * computed table is kept.
+ *
+ * @code
+ * weight_function_cache<double> cache{sf::mono<double>{}, af::circular<double>{}, 1025};
+ * for (auto outer_scale: {10e3, 20e3, 40e3}) {
+ *     const auto wf = cache(lambda, aperture_scale, spectrum::von_karman<double>{outer_scale});
+ *     ...
+ * }
+ * @endcode
+ *
+ * @see spectrum::von_karman
+ * @see weight_function
+ */
+template<class T>
+class WEIF_EXPORT weight_function_cache {
+public:
+	using value_type = T; ///< Numeric type for calculations
+	using spectrum_type = spectrum::von_karman<T>; ///< Turbulence spectrum policy type
+	using table_type = xt::xtensor<value_type, 1>; ///< Dimensionless table type
+
+private:
+	using key_type = std::pair<value_type, value_type>;
+	using function_type = std::function<table_type(const spectrum_type&, progress_token*)>;
+
+	uniform_grid<value_type> grid_;
+	function_type fun_;
+	mutable std::mutex mutex_;
+	mutable std::map<key_type, std::shared_ptr<const table_type>> tables_;
+
+public:
+	/**
+	 * @brief Construct empty cache
+	 * @param spectral_filter Spectral filter function
+	 * @param aperture_filter Aperture filter function
+	 * @param grid Grid of the dimensionless tables
+	 */
+	template<class SF, class AF>
+	weight_function_cache(SF&& spectral_filter, AF&& aperture_filter, const uniform_grid<value_type>& grid):
+		grid_{grid},
+		fun_{[spectral_filter = std::forward<SF>(spectral_filter), aperture_filter = std::forward<AF>(aperture_filter), grid]
+			(const spectrum_type& spectrum, progress_token* progress) -> table_type {
+			return detail::dimensionless_weight_function(spectral_filter, aperture_filter, grid.values(), nullptr, progress, spectrum);
+		}} {}
+
+	/**
+	 * @brief Construct empty cache
+	 * @param spectral_filter Spectral filter function
+	 * @param aperture_filter Aperture filter function
+	 * @param size Number of grid points of the dimensionless tables
+	 */
+	template<class SF, class AF>
+	weight_function_cache(SF&& spectral_filter, AF&& aperture_filter, std::size_t size):
+		weight_function_cache(std::forward<SF>(spectral_filter), std::forward<AF>(aperture_filter),
+			uniform_grid{static_cast<value_type>(0), static_cast<value_type>(1) / (size-1), size}) {}
+
+	/// @return Number of cached tables
+	std::size_t size() const {
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		return tables_.size();
+	}
+
+	/// Discard cached tables
+	void clear() {
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		tables_.clear();
+	}
+
+	/**
+	 * @brief Dimensionless table for the spectrum scaled to the aperture scale
+	 * @param spectrum Turbulence spectrum policy, see spectrum::von_karman::scaled()
+	 * @param progress Optional progress and cancellation token, used when the table is computed
+	 * @return Shared dimensionless table
+	 *
+	 * @throws cancelled If cancellation is requested through the progress token
+	 */
+	std::shared_ptr<const table_type> table(const spectrum_type& spectrum, progress_token* progress = nullptr) const {
+		const key_type key{spectrum.outer_scale(), spectrum.inner_scale()};
+
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+
+			if (auto it = tables_.find(key); it != tables_.end())
+				return it->second;
+		}
+
+		auto ret = std::make_shared<const table_type>(fun_(spectrum, progress));
+
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		return tables_.emplace(key, std::move(ret)).first->second;
+	}
+
+	/**
+	 * @brief Weight function for given wavelength, aperture scale and spectrum
+	 * @param lambda Wavelength in nanometers
+	 * @param aperture_scale Aperture scale in millimeters
+	 * @param spectrum Turbulence spectrum policy
+	 * @param progress Optional progress and cancellation token, used when the table is computed
+	 * @return Weight function
+	 *
+	 * @throws error If the aperture scale is zero and the spectrum is not scale invariant
+	 * @throws cancelled If cancellation is requested through the progress token
+	 */
+	weight_function<value_type> operator() (value_type lambda, value_type aperture_scale, const spectrum_type& spectrum,
+		progress_token* progress = nullptr) const {
+
+		return weight_function<value_type>{lambda, aperture_scale, grid_, *table(detail::scaled_spectrum(spectrum, aperture_scale), progress), spectrum.scale_invariant()};
+	}
+};
+
+extern template class weight_function_cache<float>;
+extern template class weight_function_cache<double>;
+extern template class weight_function_cache<long double>;
+
+} // weif
+
+#endif // _WEIF_WEIGHT_FUNCTION_CACHE_H
@@ -0,0 +1,305 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#ifndef _WEIF_WEIGHT_FUNCTION_COVARIANCE_H
+#define _WEIF_WEIGHT_FUNCTION_COVARIANCE_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <complex>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+#include <xtensor/core/xexpression.hpp> // IWYU pragma: keep
+#include <xtensor/core/xmath.hpp>
+#include <xtensor/containers/xtensor.hpp> // IWYU pragma: keep
+
+#include <weif/detail/cubic_spline.h>
+#include <weif/detail/fftw3_wrap.h> // IWYU pragma: keep
+#include <weif/detail/weight_function_base.h>
+#include <weif/math.h>
+#include <weif/spectrum/kolmogorov.h>
+#include <weif_export.h>
+
+
+namespace weif {
+
+/**
+ * @brief Scintillation covariance weight function versus aperture separation
+ *
+ * @tparam T Numeric type used for calculations
+ *
+ * Computes the scintillation covariance weight function for two identical
+ * apertures separated by distance \f$ r \f$ for axially symmetric power spectra:
+ * \f[
+ * W(z, r) = 9.69 \cdot 10^{-3} \cdot 32 \pi^3 z^{5/6} \lambda^{-7/6} \int_0^{\infty} du u^{-8/3} S(u) A\left(\frac{D}{\sqrt{\lambda z}} u\right) J_0\left(2\pi \frac{r}{\sqrt{\lambda z}} u\right),
+ * \f]
+ * where \f$ S(u) \f$ is a spectral filter, \f$ \lambda \f$ is its equivalent wavelength, and \f$ A(u) \f$ is an aperture filter.
+ * \f$ W(z, 0) \f$ is equal to weight_function, including the non-Kolmogorov spectra given by the spectrum policy.
+ *
+ * The Hankel transform is computed at once for the whole set of
+ * separations by means of the FFTLog algorithm: the radial integrand is
+ * sampled at logarithmically spaced frequencies and the transform becomes
+ * a convolution evaluated with two real FFTs of the zero padded sample.
+ * The cost per altitude is \f$ O(N \log N) \f$ for \f$ N \f$ frequency
+ * nodes, the result for arbitrary separations is interpolated between
+ * the logarithmically spaced output nodes.
+ *
+ * Reference: Hamilton (2000) "Uncorrelated modes of the non-linear power spectrum", https://doi.org/10.1046/j.1365-8711.2000.03071.x
+ *
+ * @par The library uses consistent units:
+ * - Altitudes: kilometers (km)
+ * - Wavelengths: nanometers (nm)
+ * - Geometric scales and separations: millimeters (mm)
+ *
+ * @see weight_function
+ */
+template<class T>
+class WEIF_EXPORT weight_function_covariance {
+public:
+	using value_type = T; ///< Numeric type for calculations
+	using complex_type = std::complex<T>;
+	using result_type = xt::xtensor<value_type, 1>; ///< Result tensor type
+
+private:
+	using function_type = std::function<value_type(value_type, value_type)>;
+
+	/* Power-law bias of the sampled integrand, the Mellin transform of
+	 * $x^{q-1} J_0(x)$ exists for $0 < q < 3/2$, while the kernel
+	 * aliasing is balanced at $q = 1/4$ for both ends of the range. */
+	static constexpr value_type bias = static_cast<value_type>(0.25);
+
+	value_type lambda_;
+	value_type aperture_scale_;
+	/* The integrand argument is in the units of this scale, 1 mm for the point aperture */
+	value_type spectrum_scale_;
+	value_type log_delta_;
+	value_type log_wavenumber_origin_;
+	xt::xtensor<value_type, 1> frequency_;
+	xt::xtensor<value_type, 1> frequency_bias_;
+	xt::xtensor<value_type, 1> wavenumber_bias_;
+	xt::xtensor<complex_type, 1> kernel_;
+	detail::fft_plan_r2c<T> forward_;
+	detail::fft_plan_c2r<T> backward_;
+	function_type fun_;
+
+	weight_function_covariance(value_type lambda, value_type aperture_scale, std::size_t size,
+		value_type frequency_min, value_type frequency_max, function_type&& fun):
+		lambda_{lambda},
+		aperture_scale_{aperture_scale},
+		spectrum_scale_{detail::altitude_scale(aperture_scale, static_cast<value_type>(1))},
+		log_delta_{std::log(frequency_max / frequency_min) / static_cast<value_type>(size - 1)},
+		log_wavenumber_origin_{-std::log(frequency_max)},
+		frequency_{std::array{size}},
+		frequency_bias_{std::array{size}},
+		wavenumber_bias_{std::array{size}},
+		kernel_{std::array{size + 1}},
+		forward_{std::array{static_cast<int>(2 * size)}, nullptr, nullptr, FFTW_ESTIMATE},
+		backward_{std::array{static_cast<int>(2 * size)}, nullptr, nullptr, FFTW_ESTIMATE},
+		fun_{std::forward<function_type>(fun)} {
+
+		using namespace std;
+
+		constexpr const auto PI = xt::numeric_constants<value_type>::PI;
+		constexpr const auto LN2 = xt::numeric_constants<value_type>::LN2;
+
+		const auto log_frequency_min = log(frequency_min);
+
+		for (std::size_t i = 0; i < size; ++i) {
+			const auto s = log_frequency_min + log_delta_ * static_cast<value_type>(i);
+			const auto t = log_wavenumber_origin_ + log_delta_ * static_cast<value_type>(i);
+
+			frequency_(i) = exp(s);
+			frequency_bias_(i) = exp((static_cast<value_type>(1) - bias) * s);
+			wavenumber_bias_(i) = exp(-bias * t);
+		}
+
+		/* Mellin transform of $J_0$ at $p = q - i\omega$:
+		 * $2^{p-1} \Gamma(p/2) / \Gamma(1 - p/2)$, shifted to the origins
+		 * of the frequency and wavenumber grids, and normalized for the
+		 * unnormalized backward FFT of length 2N. */
+		const auto period = static_cast<value_type>(2 * size) * log_delta_;
+		const auto shift = log_frequency_min + log_wavenumber_origin_;
+
+		for (std::size_t j = 0; j <= size; ++j) {
+			const auto omega = 2 * PI * static_cast<value_type>(j) / period;
+			const complex_type p{bias, -omega};
+			const complex_type h = p / static_cast<value_type>(2);
+
+			kernel_(j) = exp((p - static_cast<value_type>(1)) * LN2 + math::lgamma(h) - math::lgamma(static_cast<value_type>(1) - h)
+				+ complex_type{0, omega * shift}) / static_cast<value_type>(2 * size);
+		}
+
+		/* Real-valued backward transform ignores imaginary part at Nyquist frequency */
+		kernel_(size) = kernel_(size).real();
+	}
+
+	/* Dimensionless transform $\int_0^{\infty} du u^{-8/3} S(u) A(r x u) J_0(k u)$
+	 * at the wavenumber nodes, $x$ is the spectrum scale in the units of the
+	 * Fresnel radius and $r$ is the aperture scale in the units of the
+	 * spectrum scale */
+	result_type transform(value_type x) const {
+		const auto size = frequency_.size();
+
+		xt::xtensor<complex_type, 1> buf{std::array{size + 1}};
+		auto* data = reinterpret_cast<value_type*>(buf.data());
+
+		for (std::size_t i = 0; i < size; ++i) {
+			data[i] = fun_(frequency_(i), x) * frequency_bias_(i);
+		}
+		std::fill(data + size, data + 2 * (size + 1), static_cast<value_type>(0));
+
+		forward_(data, buf.data());
+		buf = xt::conj(buf) * kernel_;
+		backward_(buf.data(), data);
+
+		result_type res{std::array{size}};
+		for (std::size_t i = 0; i < size; ++i) {
+			res(i) = data[i] * wavenumber_bias_(i);
+		}
+
+		return res;
+	}
+
+public:
+	/**
+	 * @brief Construct covariance weight function for given turbulence spectrum
+	 * @param spectral_filter Spectral filter function
+	 * @param lambda Wavelength in nanometers
+	 * @param aperture_filter Aperture filter function
+	 * @param aperture_scale Aperture scale in millimeters
+	 * @param spectrum Turbulence spectrum policy, i.e. spectrum::von_karman
+	 * @param size Number of logarithmically spaced frequency nodes
+	 * @param frequency_min Lower dimensionless frequency of the sampled range
+	 * @param frequency_max Upper dimensionless frequency of the sampled range
+	 *
+	 * The FFT plans and the transform kernel are prepared here, the radial
+	 * integrand is sampled when operator()() is invoked. The sampled range
+	 * has to be wide enough for the integrand to vanish at both ends, the
+	 * default one gives relative precision about \f$10^{-6}\f$ for the
+	 * circular aperture. Monochromatic filter with point aperture does not
+	 * decay fast enough and requires denser sampling.
+	 *
+	 * The radial integrand is the same as the one of weight_function, so
+	 * \f$ u^{-11/3} \f$ is replaced by the spectrum policy.
+	 *
+	 * @see operator()()
+	 */
+	template<class SF, class AF, class Spectrum, std::enable_if_t<!std::is_arithmetic_v<Spectrum>, bool> = true>
+	weight_function_covariance(SF&& spectral_filter, value_type lambda, AF&& aperture_filter, value_type aperture_scale, const Spectrum& spectrum,
+		std::size_t size = 4096, value_type frequency_min = static_cast<value_type>(1e-6), value_type frequency_max = static_cast<value_type>(1e6)):
+		weight_function_covariance(lambda, aperture_scale, size, frequency_min, frequency_max,
+			detail::make_spectrum_integrand<value_type>(std::forward<SF>(spectral_filter), std::forward<AF>(aperture_filter),
+				spectrum.scaled(detail::altitude_scale(aperture_scale, static_cast<value_type>(1))),
+				aperture_scale / detail::altitude_scale(aperture_scale, static_cast<value_type>(1)))) {}
+
+	/**
+	 * @brief Construct covariance weight function for Kolmogorov spectrum
+	 * @param spectral_filter Spectral filter function
+	 * @param lambda Wavelength in nanometers
+	 * @param aperture_filter Aperture filter function
+	 * @param aperture_scale Aperture scale in millimeters
+	 * @param size Number of logarithmically spaced frequency nodes
+	 * @param frequency_min Lower dimensionless frequency of the sampled range
+	 * @param frequency_max Upper dimensionless frequency of the sampled range
+	 */
+	template<class SF, class AF>
+	weight_function_covariance(SF&& spectral_filter, value_type lambda, AF&& aperture_filter, value_type aperture_scale, std::size_t size = 4096,
+		value_type frequency_min = static_cast<value_type>(1e-6), value_type frequency_max = static_cast<value_type>(1e6)):
+		weight_function_covariance(std::forward<SF>(spectral_filter), lambda, std::forward<AF>(aperture_filter), aperture_scale,
+			spectrum::kolmogorov<value_type>{}, size, frequency_min, frequency_max) {}
+
+	const auto& lambda() const noexcept { return lambda_; /* nm */ }
+	const auto& aperture_scale() const noexcept { return aperture_scale_; /* mm */ }
+
+	/// @return Number of frequency nodes
+	std::size_t size() const noexcept { return frequency_.size(); }
+
+	/**
+	 * @brief Returns separations of the native output nodes
+	 * @param altitude Atmospheric altitude in kilometers
+	 * @return Logarithmically spaced separations in millimeters
+	 */
+	result_type separations(value_type altitude) const {
+		using namespace std;
+
+		constexpr const auto PI = xt::numeric_constants<value_type>::PI;
+
+		const value_type fresnel_radius = sqrt(this->lambda() * altitude);
+
+		return xt::exp(log_wavenumber_origin_ + log_delta_ * xt::arange<value_type>(static_cast<value_type>(size())))
+			* fresnel_radius / (2 * PI);
+	}
+
+	/**
+	 * @brief Evaluate covariance weight function at the native output nodes
+	 * @param altitude Atmospheric altitude in kilometers
+	 * @return Weight values at separations returned by separations()
+	 */
+	result_type operator() (value_type altitude) const {
+		using namespace std;
+
+		if (altitude == static_cast<value_type>(0)) {
+			return xt::zeros<value_type>({size()});
+		}
+
+		constexpr const auto PI = xt::numeric_constants<value_type>::PI;
+		/* 1e13 = pow(1e3, 5.0/6.0) * pow(1e9, 7.0/6.0) */
+		constexpr const value_type c = weif::math::Kolmogorov_Cn2_scale<value_type> * (32 * 1e13) * PI * PI * PI;
+
+		const value_type fresnel_radius = sqrt(this->lambda() * altitude);
+
+		return transform(spectrum_scale_ / fresnel_radius)
+			* (c * pow(altitude, static_cast<value_type>(5.0/6.0)) / pow(this->lambda(), static_cast<value_type>(7.0/6.0)));
+	}
+
+	/**
+	 * @brief Evaluate covariance weight function at given separations
+	 * @param altitude Atmospheric altitude in kilometers
+	 * @param e Separation values expression in millimeters
+	 * @return Tensor of covariance weight function values with same shape as input
+	 *
+	 * The transform is computed once for all separations, values between
+	 * the native output nodes are found by cubic spline interpolation in
+	 * logarithm of separation.
+	 */
+	template<class E>
+	auto operator() (value_type altitude, const xt::xexpression<E>& e) const {
+		using namespace std;
+
+		constexpr const auto PI = xt::numeric_constants<value_type>::PI;
+
+		const value_type fresnel_radius = sqrt(this->lambda() * altitude);
+		const value_type scale = 2 * PI / fresnel_radius;
+		const value_type last = static_cast<value_type>(size() - 1);
+
+		return xt::eval(xt::make_lambda_xfunction([
+			spline = detail::cubic_spline<value_type>{this->operator()(altitude), detail::first_order_boundary<value_type>{0, 0}},
+			origin = log_wavenumber_origin_,
+			delta = log_delta_,
+			scale,
+			last
+		] (value_type r) {
+			const auto x = (std::log(std::abs(r) * scale) - origin) / delta;
+
+			if (!(x < last)) {
+				return spline.values()(static_cast<std::size_t>(last));
+			}
+
+			return spline(std::max(x, static_cast<value_type>(0)));
+		}, e.derived_cast()));
+	}
+};
+
+extern template class weight_function_covariance<float>;
+extern template class weight_function_covariance<double>;
+extern template class weight_function_covariance<long double>;
+
+} // weif
+
+#endif // _WEIF_WEIGHT_FUNCTION_COVARIANCE_H
@@ -1,7 +1,7 @@
 /*
  * SPDX-License-Identifier: GPL-3.0-or-later
  *
- * Copyright (C) 2022-2023  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
  */
 
 #ifndef _WEIF_WEIGHT_FUNCTION_GRID_2D_H
@@ -11,13 +11,18 @@
 #include <cmath>
 #include <functional>
 #include <limits>
+#include <memory>
+#include <mutex>
 #include <utility>
 
 #include <xtensor/generators/xbuilder.hpp>
 #include <xtensor/core/xmath.hpp>
 #include <xtensor/containers/xtensor.hpp> // IWYU pragma: keep
+#include <xtensor/views/xview.hpp>
 
 #include <weif/detail/fftw3_wrap.h> // IWYU pragma: keep
+#include <weif/detail/weight_function_base.h>
+#include <weif/spectrum/kolmogorov.h>
 #include <weif_export.h>
 
 #if __cpp_lib_memory_resource >= 201603
@@ -44,12 +49,124 @@ private:
 	shape_type shape_;
 	value_type fft_norm_;
 	fft_plan_r2r<T> plan_;
+	shape_type nufft_shape_;
+
+	/* The oversampled plan is four times larger than plan_ and is only
+	 * needed for the off-lattice baselines, so it is built on first use.
+	 * The once_flag is held by pointer to keep the object movable. */
+	struct nufft_state {
+		fft_plan_r2r<T> plan;
+		std::array<xt::xtensor<value_type, 1>, 2> deconvolution;
+	};
+
+	struct lazy_nufft_state {
+		std::once_flag flag;
+		std::unique_ptr<nufft_state> state;
+	};
+
+	std::unique_ptr<lazy_nufft_state> nufft_;
+
+	/* Gaussian gridding after Greengard & Lee (doi: 10.1137/S003614450343200X):
+	 * the kernel spans 2 * nufft_spread fine nodes, and the truncation
+	 * error is about exp(-pi * nufft_spread * (R - 0.5) / R) for
+	 * oversampling ratio R. The spread is chosen to reach eps^{2/3},
+	 * the tolerance of the quadratures elsewhere in the library, so the
+	 * kernel takes 10, 22, and 26 taps per axis for float, double, and
+	 * long double respectively, instead of 32 taps for the full double
+	 * precision. */
+	static constexpr std::size_t nufft_oversampling = 2;
+	static constexpr std::size_t nufft_spread = static_cast<std::size_t>(
+		2 * (std::numeric_limits<value_type>::digits - 1) * xt::numeric_constants<value_type>::LN2 * static_cast<value_type>(nufft_oversampling) /
+		(3 * xt::numeric_constants<value_type>::PI * (static_cast<value_type>(nufft_oversampling) - static_cast<value_type>(0.5)))) + 1;
+
+	/* Fourier coefficients of the spreading kernel are inverted here,
+	 * including the half weight of the last REDFT00 input element and the
+	 * normalization of the trapezoidal convolution sum. */
+	static xt::xtensor<value_type, 1> make_nufft_deconvolution(std::size_t size) {
+		constexpr const auto PI = xt::numeric_constants<value_type>::PI;
+		constexpr const auto R = static_cast<value_type>(nufft_oversampling);
+
+		const auto k = static_cast<value_type>(size - 1);
+		const auto tau = PI * static_cast<value_type>(nufft_spread) / (4 * k * k * R * (R - static_cast<value_type>(0.5)));
+		const auto modes = xt::arange<value_type>(static_cast<value_type>(size));
+
+		xt::xtensor<value_type, 1> ret = xt::exp(modes * modes * tau) * (std::sqrt(PI / tau) / (2 * R * k));
+		ret(size - 1) /= 2;
+
+		return ret;
+	}
+
+	const nufft_state& nufft() const {
+		std::call_once(nufft_->flag, [this] () {
+			nufft_->state = std::make_unique<nufft_state>(nufft_state{
+				fft_plan_r2r<T>{std::array{static_cast<int>(std::get<0>(nufft_shape_)), static_cast<int>(std::get<1>(nufft_shape_))},
+					nullptr, nullptr, std::array{FFTW_REDFT00, FFTW_REDFT00}, FFTW_ESTIMATE},
+				{make_nufft_deconvolution(std::get<0>(shape_)), make_nufft_deconvolution(std::get<1>(shape_))}});
+		});
+
+		return *nufft_->state;
+	}
 
 protected:
 	function_type fun_;
 
 	void apply_inplace_dct(value_type* data) const noexcept { plan_(data, data); }
+	void apply_inplace_nufft_dct(value_type* data) const { nufft().plan(data, data); }
 	const auto& fft_norm() const noexcept { return fft_norm_; }
+	/* The integrand argument is in the units of this scale, the grid step for the point aperture */
+	value_type spectrum_scale() const noexcept { return altitude_scale(aperture_scale_, grid_step_); }
+	const auto& nufft_shape() const noexcept { return nufft_shape_; }
+	const auto& nufft_deconvolution() const { return nufft().deconvolution; }
+
+	/*
+	 * Interpolates the oversampled grid of even periodic function at
+	 * fractional fine grid coordinates p0, p1.
+	 */
+	template<class E>
+	value_type nufft_interpolate(const xt::xexpression<E>& e, value_type p0, value_type p1) const noexcept {
+		using namespace std;
+
+		constexpr const auto PI = xt::numeric_constants<value_type>::PI;
+		constexpr const auto R = static_cast<value_type>(nufft_oversampling);
+		constexpr const auto width = 2 * nufft_spread;
+		constexpr const auto gauss_scale = PI * (R - static_cast<value_type>(0.5)) / (R * static_cast<value_type>(nufft_spread));
+
+		const auto& fine = e.derived_cast();
+
+		const auto weights = [&] (value_type p, std::size_t size, std::array<value_type, width>& w, std::array<std::size_t, width>& idx) {
+			const auto last = static_cast<long>(size - 1);
+			const auto period = 2 * last;
+			const auto first = static_cast<long>(floor(p)) - static_cast<long>(nufft_spread) + 1;
+
+			for (std::size_t j = 0; j < width; ++j) {
+				const auto m = first + static_cast<long>(j);
+				const auto d = p - static_cast<value_type>(m);
+				const auto i = ((m % period) + period) % period;
+
+				w[j] = exp(-d * d * gauss_scale);
+				idx[j] = static_cast<std::size_t>(i > last ? period - i : i);
+			}
+		};
+
+		std::array<value_type, width> w0, w1;
+		std::array<std::size_t, width> idx0, idx1;
+
+		weights(p0, std::get<0>(nufft_shape()), w0, idx0);
+		weights(p1, std::get<1>(nufft_shape()), w1, idx1);
+
+		value_type ret = 0;
+		for (std::size_t j = 0; j < width; ++j) {
+			value_type acc = 0;
+
+			for (std::size_t l = 0; l < width; ++l) {
+				acc += w1[l] * fine(idx0[j], idx1[l]);
+			}
+
+			ret += w0[j] * acc;
+		}
+
+		return ret;
+	}
 
 public:
 	weight_function_grid_2d_base(value_type lambda, value_type aperture_scale, value_type grid_step, shape_type shape, function_type&& fun):
@@ -61,6 +178,8 @@ public:
 			static_cast<value_type>(4 * (std::get<0>(shape_) - 1) * (std::get<1>(shape_) - 1) * grid_step_ * grid_step_)},
 		plan_{std::array{static_cast<int>(std::get<0>(shape)), static_cast<int>(std::get<1>(shape))},
 			nullptr, nullptr, std::array{FFTW_REDFT00, FFTW_REDFT00}, FFTW_ESTIMATE},
+		nufft_shape_{nufft_oversampling * (std::get<0>(shape) - 1) + 1, nufft_oversampling * (std::get<1>(shape) - 1) + 1},
+		nufft_{std::make_unique<lazy_nufft_state>()},
 		fun_{std::forward<function_type>(fun)} {}
 
 	const auto& lambda() const noexcept { return lambda_; /* nm */ }
@@ -124,8 +243,31 @@ public:
 	 */
 	template<class SF, class AF>
 	weight_function_grid_2d(SF&& spectral_filter, value_type lambda, AF&& aperture_filter, value_type aperture_scale, value_type grid_step, shape_type shape, const allocator_type& alloc = allocator_type()):
+		weight_function_grid_2d(std::forward<SF>(spectral_filter), lambda, std::forward<AF>(aperture_filter), aperture_scale,
+			spectrum::kolmogorov<value_type>{}, grid_step, shape, alloc) {}
+
+	/**
+	 * @brief Construct weight function for given turbulence spectrum
+	 * @param spectral_filter Spectral filter function
+	 * @param lambda Wavelength in nanometers
+	 * @param aperture_filter Aperture filter function
+	 * @param aperture_scale Aperture scale in millimeters
+	 * @param spectrum Turbulence spectrum policy, i.e. spectrum::von_karman
+	 * @param grid_step Grid spacing in millimeters
+	 * @param shape Grid dimensions (Nx, Ny)
+	 * @param alloc Allocator instance
+	 *
+	 * The Kolmogorov power law \f$ u^{-11/3} \f$ in the integral is
+	 * replaced by the spectrum policy. The geometric scales of the spectrum
+	 * are measured in the grid steps for the point aperture.
+	 */
+	template<class SF, class AF, class Spectrum>
+	weight_function_grid_2d(SF&& spectral_filter, value_type lambda, AF&& aperture_filter, value_type aperture_scale, const Spectrum& spectrum,
+		value_type grid_step, shape_type shape, const allocator_type& alloc = allocator_type()):
 		weight_function_grid_2d(lambda, aperture_scale, grid_step, shape,
-			[spectral_filter = std::forward<SF>(spectral_filter), aperture_filter = std::forward<AF>(aperture_filter)] (value_type ux, value_type uy, value_type x) noexcept -> value_type {
+			[spectral_filter = std::forward<SF>(spectral_filter), aperture_filter = std::forward<AF>(aperture_filter),
+				spectrum = spectrum.scaled(detail::altitude_scale(aperture_scale, grid_step)),
+				aperture_ratio = aperture_scale / detail::altitude_scale(aperture_scale, grid_step)] (value_type ux, value_type uy, value_type x) noexcept -> value_type {
 			if (ux == static_cast<value_type>(0) && uy == static_cast<value_type>(0))
 				return static_cast<value_type>(0);
 
@@ -135,10 +277,10 @@ public:
 			const auto u2 = ux * ux + uy * uy;
 
 			if (u2 < static_cast<value_type>(1)) {
-				return std::pow(u2, static_cast<value_type>(1.0/6.0)) * spectral_filter.regular(u2) * aperture_filter(x * ux, x * uy);
+				return spectrum.regular(u2, x) * spectral_filter.regular(u2) * aperture_filter(aperture_ratio * x * ux, aperture_ratio * x * uy);
 			}
 
-			return std::pow(u2, -static_cast<value_type>(11.0/6.0)) * spectral_filter(u2) * aperture_filter(x * ux, x * uy);
+			return spectrum(u2, x) * spectral_filter(u2) * aperture_filter(aperture_ratio * x * ux, aperture_ratio * x * uy);
 		}, alloc) {}
 
 	template<class SF, class AF>
@@ -172,7 +314,7 @@ public:
 		const auto uy = xt::linspace(static_cast<value_type>(0), nyquist, std::get<1>(this->shape()));
 
 		result_type res{xt::make_lambda_xfunction(
-			std::bind(std::cref(detail::weight_function_grid_2d_base<T>::fun_), _1, _2, this->aperture_scale() / fresnel_radius),
+			std::bind(std::cref(detail::weight_function_grid_2d_base<T>::fun_), _1, _2, this->spectrum_scale() / fresnel_radius),
 			xt::expand_dims(ux, 1), uy)};
 
 		this->apply_inplace_dct(res.data());
@@ -181,6 +323,73 @@ public:
 
 		return res;
 	}
+
+	/**
+	 * @brief Evaluate weight function for arbitrary aperture baselines at specific altitude
+	 * @param altitude Atmospheric altitude in kilometers
+	 * @param e Baselines expression of shape (M, 2) holding (dx, dy) offsets in millimeters
+	 * @return 1D tensor of M weight function values
+	 *
+	 * Evaluates the same discretized integral as operator()(value_type)
+	 * at non-integer lattice offsets by means of the type-2 non-uniform
+	 * FFT: the spectrum samples are divided by the Fourier transform of
+	 * a Gaussian kernel, transformed to twice finer lattice by a single
+	 * oversampled DCT, and every baseline is interpolated by the Gaussian
+	 * kernel over a fixed number of the neighbouring fine nodes. The cost
+	 * is \f$ O(N \log N + M) \f$, where \f$ N \f$ is the grid size.
+	 * The interpolation error is about \f$ \epsilon^{2/3} \f$ relative
+	 * to the largest value of the weight function.
+	 *
+	 * The result for baselines on the lattice coincides with the tensor
+	 * returned by operator()(value_type). Baselines should lie within
+	 * the lattice extent \f$ (N_x - 1) \Delta \f$, \f$ (N_y - 1) \Delta \f$,
+	 * since the discretized integral is periodic beyond it.
+	 */
+	template<class E>
+	auto operator() (value_type altitude, const xt::xexpression<E>& e) const {
+		using namespace std;
+		using namespace std::placeholders;
+
+		using baseline_result_type = xt::xtensor<value_type, 1, XTENSOR_DEFAULT_LAYOUT, allocator_type>;
+
+		const auto& baselines = e.derived_cast();
+		const auto count = baselines.shape()[0];
+
+		baseline_result_type ret = xt::zeros<value_type>({count});
+
+		if (altitude == static_cast<value_type>(0)) {
+			return ret;
+		}
+
+		constexpr const auto PI = xt::numeric_constants<value_type>::PI;
+		constexpr const value_type c = 9.69e-3 * 16 * PI * PI * 1e13;
+
+		const value_type fresnel_radius = sqrt(this->lambda() * altitude);
+		const value_type nyquist = fresnel_radius / this->grid_step() / 2;
+		const auto [n0, n1] = this->shape();
+		const auto& [deconvolution0, deconvolution1] = this->nufft_deconvolution();
+
+		const auto ux = xt::linspace(static_cast<value_type>(0), nyquist, n0);
+		const auto uy = xt::linspace(static_cast<value_type>(0), nyquist, n1);
+
+		result_type fine = xt::zeros<value_type>(this->nufft_shape());
+		xt::view(fine, xt::range(0, n0), xt::range(0, n1)) = xt::make_lambda_xfunction(
+			std::bind(std::cref(detail::weight_function_grid_2d_base<T>::fun_), _1, _2, this->spectrum_scale() / fresnel_radius),
+			xt::expand_dims(ux, 1), uy) * xt::expand_dims(deconvolution0, 1) * deconvolution1;
+
+		this->apply_inplace_nufft_dct(fine.data());
+
+		const value_type scale = c * this->fft_norm() / pow(this->lambda(), static_cast<value_type>(1.0/6.0)) * pow(altitude, static_cast<value_type>(11.0/6.0));
+		const value_type oversampling = static_cast<value_type>(std::get<0>(this->nufft_shape()) - 1) / static_cast<value_type>(n0 - 1) / this->grid_step();
+
+		for (std::size_t i = 0; i < count; ++i) {
+			ret(i) = scale * this->nufft_interpolate(fine,
+				abs(static_cast<value_type>(baselines(i, 0))) * oversampling,
+				abs(static_cast<value_type>(baselines(i, 1))) * oversampling);
+		}
+
+		return ret;
+	}
 };
 
 
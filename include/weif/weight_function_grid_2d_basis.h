@@ -0,0 +1,276 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#ifndef _WEIF_WEIGHT_FUNCTION_GRID_2D_BASIS_H
+#define _WEIF_WEIGHT_FUNCTION_GRID_2D_BASIS_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <xtensor/containers/xadapt.hpp>
+#include <xtensor/containers/xtensor.hpp> // IWYU pragma: keep
+#include <xtensor/core/xmath.hpp>
+#include <xtensor/misc/xmanipulation.hpp>
+#include <xtensor/views/xview.hpp>
+
+#include <weif/detail/cubic_spline.h>
+#include <weif/detail/linalg.h>
+#include <weif/detail/weight_function_base.h>
+#include <weif/error.h>
+#include <weif/progress_token.h>
+#include <weif_export.h>
+
+
+namespace weif {
+
+/**
+ * @brief Low-rank altitude basis of the weight function for uniform grid of identical apertures
+ *
+ * @tparam T Numeric type for calculations
+ *
+ * Represents the weight function lattice as a truncated sum
+ * \f[
+ * W_{jk}(h) = h^{5/6} \sum_{i=0}^{r-1} U_i(j, k) V_i(z),
+ * \f]
+ * where \f$ z = 1 / (1 + D / \sqrt{\lambda h}) \f$ is the variable used by
+ * weight_function_grid_2d_table, \f$ U_i \f$ are orthonormal lag modes,
+ * and \f$ V_i(z) \f$ are altitude coefficients interpolated by cubic
+ * splines. The decomposition is the truncated singular value decomposition
+ * (proper orthogonal decomposition) of the matrix of \f$ h^{-5/6} W_{jk} \f$
+ * sampled at altitudes uniform in \f$ z \f$.
+ *
+ * The leading singular triplets are found by the subspace iteration with
+ * a few oversampling vectors followed by the Rayleigh-Ritz procedure, so
+ * only products with the sample matrix are required. The relative
+ * Frobenius norm of the truncated part is reported by truncation_error().
+ *
+ * Measured covariance maps are projected onto the lag modes by
+ * project(), so a profile may be fitted in the \f$ r \f$-dimensional space
+ * of coefficients() instead of the full lattice.
+ *
+ * @par The library uses consistent units:
+ * - Altitudes: kilometers (km)
+ * - Wavelengths: nanometers (nm)
+ * - Geometric scales and grid steps: millimeters (mm)
+ *
+ * @see weight_function_grid_2d
+ * @see weight_function_grid_2d_table
+ */
+template<class T>
+class WEIF_EXPORT weight_function_grid_2d_basis {
+public:
+	using value_type = T; ///< Numeric type for calculations
+	using shape_type = std::array<std::size_t, 2>;
+	using result_type = xt::xtensor<value_type, 2>; ///< Lattice tensor type
+	using coefficients_type = xt::xtensor<value_type, 1>; ///< Basis coefficients tensor type
+
+private:
+	static constexpr std::size_t oversampling = 8;
+	static constexpr std::size_t power_iterations = 4;
+
+	value_type lambda_;
+	value_type aperture_scale_;
+	value_type grid_step_;
+	value_type scale_;
+	value_type z_min_;
+	value_type z_max_;
+	shape_type shape_;
+	std::size_t size_;
+	xt::xtensor<value_type, 2> modes_;
+	xt::xtensor<value_type, 1> singular_values_;
+	std::vector<detail::cubic_spline<value_type>> altitude_modes_;
+	value_type truncation_error_;
+
+	std::size_t lags() const noexcept { return std::get<0>(shape_) * std::get<1>(shape_); }
+
+	value_type z(value_type altitude) const noexcept { return detail::altitude_to_z(altitude, lambda(), scale_); }
+	value_type altitude(value_type z) const noexcept { return detail::z_to_altitude(z, lambda(), scale_); }
+
+public:
+	/**
+	 * @brief Compress weight function for uniform grid of apertures
+	 * @param wf Source weight function, i.e. weight_function_grid_2d or weight_function_grid_2d_table
+	 * @param altitude_min Lower altitude in kilometers, positive
+	 * @param altitude_max Upper altitude in kilometers
+	 * @param size Number of altitude samples
+	 * @param rank Number of retained modes
+	 * @param progress Optional progress and cancellation token
+	 *
+	 * The rank is limited by the number of samples and the number of lags.
+	 *
+	 * @throws cancelled If cancellation is requested through the progress token
+	 */
+	template<class WF>
+	weight_function_grid_2d_basis(const WF& wf, value_type altitude_min, value_type altitude_max, std::size_t size, std::size_t rank,
+		progress_token* progress = nullptr):
+		lambda_{wf.lambda()},
+		aperture_scale_{wf.aperture_scale()},
+		grid_step_{wf.grid_step()},
+		scale_{detail::altitude_scale(wf.aperture_scale(), wf.grid_step())},
+		z_min_{z(altitude_min)},
+		z_max_{z(altitude_max)},
+		shape_{wf.shape()},
+		size_{size} {
+
+		using namespace std;
+
+		if (progress) {
+			progress->expect(size);
+		}
+
+		xt::xtensor<value_type, 2> samples{std::array{size, lags()}};
+		for (std::size_t i = 0; i < size; ++i) {
+			const auto h = altitude(z_min_ + (z_max_ - z_min_) * static_cast<value_type>(i) / static_cast<value_type>(size - 1));
+
+			xt::view(samples, i, xt::all()) = xt::flatten(wf(h)) / pow(h, static_cast<value_type>(5.0/6.0));
+
+			if (progress) {
+				progress->advance();
+			}
+		}
+
+		const auto k = std::min(rank + oversampling, std::min(size, lags()));
+		rank = std::min(rank, k);
+
+		/* Subspace iteration for the range of the samples */
+		std::mt19937 gen;
+		std::normal_distribution<value_type> normal;
+		xt::xtensor<value_type, 2> q{std::array{size, k}};
+		std::generate(q.begin(), q.end(), [&] () { return normal(gen); });
+		detail::orthonormalize(q);
+
+		for (std::size_t i = 0; i < power_iterations; ++i) {
+			auto y = detail::multiply_tn(samples, q);
+			detail::orthonormalize(y);
+			q = detail::multiply(samples, y);
+			detail::orthonormalize(q);
+		}
+
+		/* Rayleigh-Ritz: SVD of the k x lags projection through the eigenproblem of its Gram matrix */
+		const auto y = detail::multiply_tn(samples, q);
+		const auto [eigenvalues, eigenvectors] = detail::symmetric_eigen(detail::multiply_tn(y, y));
+		const auto left = detail::multiply(q, eigenvectors);
+		const auto right = detail::multiply(y, eigenvectors);
+
+		modes_ = xt::zeros<value_type>({rank, lags()});
+		singular_values_ = xt::zeros<value_type>({rank});
+
+		value_type retained = 0;
+		for (std::size_t i = 0; i < rank; ++i) {
+			const auto sigma = sqrt(max(eigenvalues(i), static_cast<value_type>(0)));
+
+			singular_values_(i) = sigma;
+			retained += sigma * sigma;
+
+			if (sigma > static_cast<value_type>(0)) {
+				xt::view(modes_, i, xt::all()) = xt::view(right, xt::all(), i) / sigma;
+			}
+
+			altitude_modes_.emplace_back(xt::eval(xt::view(left, xt::all(), i) * sigma));
+		}
+
+		const value_type total = xt::sum(xt::square(samples))();
+		truncation_error_ = (total > static_cast<value_type>(0) ? sqrt(max(total - retained, static_cast<value_type>(0)) / total) : static_cast<value_type>(0));
+	}
+
+	const auto& lambda() const noexcept { return lambda_; /* nm */ }
+	const auto& aperture_scale() const noexcept { return aperture_scale_; /* mm */ }
+	const auto& grid_step() const noexcept { return grid_step_; /* mm */ }
+	const auto& shape() const noexcept { return shape_; }
+
+	/// @return Number of altitude samples
+	std::size_t size() const noexcept { return size_; }
+
+	/// @return Number of retained modes
+	std::size_t rank() const noexcept { return modes_.shape()[0]; }
+
+	/// @return Lower altitude in kilometers
+	value_type altitude_min() const noexcept { return altitude(z_min_); }
+
+	/// @return Upper altitude in kilometers
+	value_type altitude_max() const noexcept { return altitude(z_max_); }
+
+	/// @return Orthonormal lag modes of shape (rank, Nx * Ny)
+	const auto& modes() const noexcept { return modes_; }
+
+	/// @return Retained singular values in descending order
+	const auto& singular_values() const noexcept { return singular_values_; }
+
+	/// @return Frobenius norm of the truncated part of the samples relative to the norm of the samples
+	const auto& truncation_error() const noexcept { return truncation_error_; }
+
+	/**
+	 * @brief Basis coefficients of the weight function at specific altitude
+	 * @param altitude Atmospheric altitude in kilometers
+	 * @return Tensor of rank coefficients
+	 * @throws altitude_out_of_range If the altitude is outside of the sampled range
+	 */
+	coefficients_type coefficients(value_type altitude) const {
+		using namespace std;
+
+		const auto x = (z(altitude) - z_min_) / (z_max_ - z_min_) * static_cast<value_type>(size_ - 1);
+
+		if (!(x >= static_cast<value_type>(0) && x <= static_cast<value_type>(size_ - 1)))
+			throw altitude_out_of_range{altitude, altitude_min(), altitude_max()};
+
+		const auto clamped = min(x, static_cast<value_type>(size_ - 1) - static_cast<value_type>(size_ - 1) * numeric_limits<value_type>::epsilon());
+		const auto factor = pow(altitude, static_cast<value_type>(5.0/6.0));
+
+		coefficients_type ret{std::array{rank()}};
+		for (std::size_t i = 0; i < rank(); ++i) {
+			ret(i) = altitude_modes_[i](clamped) * factor;
+		}
+
+		return ret;
+	}
+
+	/**
+	 * @brief Reconstruct weight function for uniform aperture grid at specific altitude
+	 * @param altitude Atmospheric altitude in kilometers
+	 * @return 2D tensor of weight function values on spatial grid of shape (Nx, Ny)
+	 * @throws altitude_out_of_range If the altitude is outside of the sampled range
+	 */
+	result_type operator() (value_type altitude) const {
+		return reconstruct(coefficients(altitude));
+	}
+
+	/**
+	 * @brief Project lattice map onto the lag modes
+	 * @param e Map of shape (Nx, Ny), i.e. measured covariance map
+	 * @return Tensor of rank coefficients
+	 */
+	template<class E>
+	coefficients_type project(const xt::xexpression<E>& e) const {
+		const xt::xtensor<value_type, 2> map = xt::reshape_view(xt::eval(e.derived_cast()), std::array{lags(), std::size_t{1}});
+
+		return xt::flatten(detail::multiply(modes_, map));
+	}
+
+	/**
+	 * @brief Reconstruct lattice map from basis coefficients
+	 * @param e Tensor of rank coefficients
+	 * @return 2D tensor of shape (Nx, Ny)
+	 */
+	template<class E>
+	result_type reconstruct(const xt::xexpression<E>& e) const {
+		const xt::xtensor<value_type, 2> c = xt::reshape_view(xt::eval(e.derived_cast()), std::array{std::size_t{1}, rank()});
+
+		return xt::reshape_view(detail::multiply(c, modes_), shape_);
+	}
+};
+
+extern template class weight_function_grid_2d_basis<float>;
+extern template class weight_function_grid_2d_basis<double>;
+extern template class weight_function_grid_2d_basis<long double>;
+
+} // weif
+
+#endif // _WEIF_WEIGHT_FUNCTION_GRID_2D_BASIS_H
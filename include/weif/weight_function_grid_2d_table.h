@@ -0,0 +1,427 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#ifndef _WEIF_WEIGHT_FUNCTION_GRID_2D_TABLE_H
+#define _WEIF_WEIGHT_FUNCTION_GRID_2D_TABLE_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <xtensor/containers/xadapt.hpp>
+#include <xtensor/containers/xtensor.hpp> // IWYU pragma: keep
+#include <xtensor/core/xmath.hpp>
+#include <xtensor/misc/xmanipulation.hpp>
+#include <xtensor/views/xview.hpp>
+
+#include <weif/detail/cubic_spline.h>
+#include <weif/detail/weight_function_base.h>
+#include <weif/error.h>
+#include <weif/progress_token.h>
+#include <weif/weight_function_grid_2d.h>
+#include <weif_export.h>
+
+
+namespace weif {
+namespace detail {
+
+/* The numeric type is tagged by its size and the number of mantissa
+ * digits, since long double differs between the platforms. */
+struct table_file_header {
+	char magic[8];
+	std::uint32_t version;
+	std::uint32_t value_size;
+	std::uint32_t value_digits;
+	std::uint32_t reserved;
+	std::uint64_t shape[2];
+	std::uint64_t size;
+};
+
+/* The table parameters follow the header in the native value type:
+ * lambda, aperture scale, grid step, scale, z_min, z_max and the
+ * estimated error. The data follow at the fixed offset, aligned for
+ * any value type. */
+constexpr std::size_t table_file_parameters_offset = 64;
+constexpr std::size_t table_file_parameters = 7;
+constexpr std::size_t table_file_data_offset = 256;
+constexpr char table_file_magic[8] = {'W', 'E', 'I', 'F', 'G', '2', 'D', 'T'};
+constexpr std::uint32_t table_file_version = 2;
+
+static_assert(sizeof(table_file_header) <= table_file_parameters_offset);
+static_assert(table_file_parameters_offset + table_file_parameters * sizeof(long double) <= table_file_data_offset);
+
+struct mapped_file {
+	std::shared_ptr<const std::byte> data;
+	std::size_t size;
+};
+
+/*
+ * Maps the whole file into memory read-only. Falls back to reading the
+ * file when memory mapping is not available.
+ */
+WEIF_EXPORT mapped_file map_file(const std::string& filename);
+
+} // detail
+
+/**
+ * @brief Precomputed altitude table of the weight function for uniform grid of identical apertures
+ *
+ * @tparam T Numeric type for calculations
+ *
+ * Tabulates weight_function_grid_2d once and answers
+ * operator()() by cubic spline interpolation in altitude, which is much
+ * cheaper than the integrand fill and the 2D DCT performed by
+ * weight_function_grid_2d::operator()() for each altitude.
+ *
+ * Every lag \f$ W_{jk} \f$ has its own spline over the same variable as
+ * used by weight_function:
+ * \f[
+ * z = \frac{1}{1 + D / \sqrt{\lambda h}},
+ * \f]
+ * where the grid step is used for \f$ D \f$ when the aperture scale is
+ * zero. The splines interpolate \f$ h^{-5/6} W_{jk}(h) \f$, which is
+ * bounded and smooth in \f$ z \f$.
+ *
+ * The grid in \f$ z \f$ is uniform and refined adaptively: the table is
+ * checked against the exact values at the midpoints of all intervals for
+ * all lags, and the number of intervals is doubled until the error meets
+ * the tolerance. The midpoints become the nodes of the refined table, so
+ * no evaluation is wasted. The uniform grid keeps the lookup O(1).
+ *
+ * The error reported by estimated_error() is the largest midpoint error
+ * of the table before the last refinement. It is an estimate for the
+ * final table and not a guaranteed bound: the error is sampled only at
+ * one point per interval, though the error of the refined table is
+ * typically an order of magnitude smaller.
+ *
+ * The table can be saved to a file and loaded back. The values are
+ * stored in the native numeric type, and the file can only be loaded
+ * with the same type. The loaded table is memory mapped, so many
+ * processes may share one table without copying.
+ *
+ * @par The library uses consistent units:
+ * - Altitudes: kilometers (km)
+ * - Wavelengths: nanometers (nm)
+ * - Geometric scales and grid steps: millimeters (mm)
+ *
+ * @see weight_function_grid_2d
+ */
+template<class T>
+class WEIF_EXPORT weight_function_grid_2d_table {
+public:
+	using value_type = T; ///< Numeric type for calculations
+	using shape_type = std::array<std::size_t, 2>;
+	using result_type = xt::xtensor<value_type, 2>; ///< Result tensor type
+
+private:
+	value_type lambda_;
+	value_type aperture_scale_;
+	value_type grid_step_;
+	value_type scale_;
+	value_type z_min_;
+	value_type z_max_;
+	value_type estimated_error_;
+	shape_type shape_;
+	std::size_t size_;
+	/* values and second derivatives, both of shape (size, Nx, Ny) */
+	std::shared_ptr<const value_type> storage_;
+
+	std::size_t lags() const noexcept { return std::get<0>(shape_) * std::get<1>(shape_); }
+	const value_type* values() const noexcept { return storage_.get(); }
+	const value_type* double_primes() const noexcept { return storage_.get() + size_ * lags(); }
+
+	value_type z(value_type altitude) const noexcept { return detail::altitude_to_z(altitude, lambda(), scale_); }
+	value_type altitude(value_type z) const noexcept { return detail::z_to_altitude(z, lambda(), scale_); }
+
+	/* Natural cubic splines for every lag over the nodes */
+	static xt::xtensor<value_type, 2> make_double_primes(const xt::xtensor<value_type, 2>& nodes) {
+		xt::xtensor<value_type, 2> ret{nodes.shape()};
+
+		for (std::size_t lag = 0; lag < nodes.shape()[1]; ++lag) {
+			const detail::cubic_spline<value_type> spline{xt::view(nodes, xt::all(), lag)};
+
+			xt::view(ret, xt::all(), lag) = spline.double_primes();
+		}
+
+		return ret;
+	}
+
+	/* Spline expression for all lags, the nodes must outlive the result */
+	template<class E1, class E2>
+	static auto interpolate(const E1& nodes, const E2& d2, std::size_t idx, value_type delta0) {
+		const auto delta1 = static_cast<value_type>(1) - delta0;
+		const auto delta03 = delta0 * delta0 * delta0;
+		const auto delta13 = delta1 * delta1 * delta1;
+
+		return xt::view(d2, idx, xt::all()) * (delta13 - delta1) / static_cast<value_type>(6) +
+			xt::view(d2, idx + 1, xt::all()) * (delta03 - delta0) / static_cast<value_type>(6) +
+			xt::view(nodes, idx, xt::all()) * delta1 +
+			xt::view(nodes, idx + 1, xt::all()) * delta0;
+	}
+
+	weight_function_grid_2d_table(const detail::table_file_header& header, const std::array<value_type, detail::table_file_parameters>& parameters,
+		std::shared_ptr<const value_type> storage):
+		lambda_{parameters[0]},
+		aperture_scale_{parameters[1]},
+		grid_step_{parameters[2]},
+		scale_{parameters[3]},
+		z_min_{parameters[4]},
+		z_max_{parameters[5]},
+		estimated_error_{parameters[6]},
+		shape_{static_cast<std::size_t>(header.shape[0]), static_cast<std::size_t>(header.shape[1])},
+		size_{static_cast<std::size_t>(header.size)},
+		storage_{std::move(storage)} {}
+
+public:
+	/**
+	 * @brief Tabulate existing weight function
+	 * @param wf Weight function for uniform grid of apertures
+	 * @param altitude_min Lower altitude of the table in kilometers, positive
+	 * @param altitude_max Upper altitude of the table in kilometers
+	 * @param tolerance Required interpolation error relative to the largest lag at given altitude
+	 * @param max_size Maximum number of altitude nodes
+	 * @param progress Optional progress and cancellation token
+	 *
+	 * The refinement starts from 17 nodes and stops when the tolerance
+	 * is met or the next refinement would exceed max_size. In the latter
+	 * case estimated_error() exceeds the tolerance, it is infinite when no
+	 * refinement has been done at all.
+	 *
+	 * @throws error If the altitude range is empty or not positive
+	 * @throws cancelled If cancellation is requested through the progress token
+	 */
+	template<class Allocator>
+	weight_function_grid_2d_table(const weight_function_grid_2d<T, Allocator>& wf, value_type altitude_min, value_type altitude_max,
+		value_type tolerance = static_cast<value_type>(1e-6), std::size_t max_size = 4097, progress_token* progress = nullptr):
+		lambda_{wf.lambda()},
+		aperture_scale_{wf.aperture_scale()},
+		grid_step_{wf.grid_step()},
+		scale_{detail::altitude_scale(wf.aperture_scale(), wf.grid_step())},
+		z_min_{z(altitude_min)},
+		z_max_{z(altitude_max)},
+		estimated_error_{std::numeric_limits<value_type>::infinity()},
+		shape_{wf.shape()},
+		size_{17} {
+
+		using namespace std;
+
+		if (!(altitude_min > static_cast<value_type>(0) && altitude_min < altitude_max))
+			throw error("Invalid weight function table altitude range");
+
+		const auto evaluate = [&] (value_type z) -> xt::xtensor<value_type, 1> {
+			const auto h = altitude(z);
+			const auto res = wf(h);
+
+			if (progress) {
+				progress->advance();
+			}
+
+			return xt::flatten(res) / pow(h, static_cast<value_type>(5.0/6.0));
+		};
+
+		if (progress) {
+			progress->expect(size_);
+		}
+
+		xt::xtensor<value_type, 2> nodes{std::array{size_, lags()}};
+		for (std::size_t i = 0; i < size_; ++i) {
+			xt::view(nodes, i, xt::all()) = evaluate(z_min_ + (z_max_ - z_min_) * static_cast<value_type>(i) / static_cast<value_type>(size_ - 1));
+		}
+
+		auto d2 = make_double_primes(nodes);
+
+		while (2 * size_ - 1 <= max_size) {
+			const auto next_size = 2 * size_ - 1;
+
+			if (progress) {
+				progress->expect(size_ - 1);
+			}
+
+			xt::xtensor<value_type, 2> next{std::array{next_size, lags()}};
+			value_type max_error = 0;
+
+			for (std::size_t i = 0; i + 1 < size_; ++i) {
+				const auto exact = evaluate(z_min_ + (z_max_ - z_min_) * static_cast<value_type>(2 * i + 1) / static_cast<value_type>(next_size - 1));
+				const auto norm = xt::amax(xt::abs(exact))();
+
+				if (norm > static_cast<value_type>(0)) {
+					max_error = max(max_error, static_cast<value_type>(xt::amax(xt::abs(interpolate(nodes, d2, i, static_cast<value_type>(0.5)) - exact))() / norm));
+				}
+
+				xt::view(next, 2 * i, xt::all()) = xt::view(nodes, i, xt::all());
+				xt::view(next, 2 * i + 1, xt::all()) = exact;
+			}
+			xt::view(next, next_size - 1, xt::all()) = xt::view(nodes, size_ - 1, xt::all());
+
+			nodes = std::move(next);
+			d2 = make_double_primes(nodes);
+			size_ = next_size;
+			estimated_error_ = max_error;
+
+			if (max_error <= tolerance) {
+				break;
+			}
+		}
+
+		auto storage = std::make_shared<std::vector<value_type>>(2 * size_ * lags());
+		std::copy(nodes.cbegin(), nodes.cend(), storage->begin());
+		std::copy(d2.cbegin(), d2.cend(), storage->begin() + size_ * lags());
+
+		storage_ = std::shared_ptr<const value_type>(storage, storage->data());
+	}
+
+	/**
+	 * @brief Construct weight function and tabulate it
+	 * @param spectral_filter Spectral filter function
+	 * @param lambda Wavelength in nanometers
+	 * @param aperture_filter Aperture filter function
+	 * @param aperture_scale Aperture scale in millimeters
+	 * @param grid_step Grid spacing in millimeters
+	 * @param shape Grid dimensions (Nx, Ny)
+	 * @param altitude_min Lower altitude of the table in kilometers, positive
+	 * @param altitude_max Upper altitude of the table in kilometers
+	 * @param tolerance Required interpolation error relative to the largest lag at given altitude
+	 * @param max_size Maximum number of altitude nodes
+	 * @param progress Optional progress and cancellation token
+	 *
+	 * @throws error If the altitude range is empty or not positive
+	 * @throws cancelled If cancellation is requested through the progress token
+	 */
+	template<class SF, class AF>
+	weight_function_grid_2d_table(SF&& spectral_filter, value_type lambda, AF&& aperture_filter, value_type aperture_scale, value_type grid_step, shape_type shape,
+		value_type altitude_min, value_type altitude_max,
+		value_type tolerance = static_cast<value_type>(1e-6), std::size_t max_size = 4097, progress_token* progress = nullptr):
+		weight_function_grid_2d_table(weight_function_grid_2d<T>(std::forward<SF>(spectral_filter), lambda, std::forward<AF>(aperture_filter), aperture_scale, grid_step, shape),
+			altitude_min, altitude_max, tolerance, max_size, progress) {}
+
+	/**
+	 * @brief Load the table saved by save()
+	 * @param filename Input filename
+	 * @return The table memory mapped from the file
+	 * @throws error If the file can not be read or has unexpected format
+	 */
+	static weight_function_grid_2d_table load(const std::string& filename) {
+		auto file = detail::map_file(filename);
+		detail::table_file_header header;
+
+		if (file.size < detail::table_file_data_offset)
+			throw error("Truncated weight function table " + filename);
+
+		std::memcpy(&header, file.data.get(), sizeof(header));
+
+		if (std::memcmp(header.magic, detail::table_file_magic, sizeof(header.magic)) != 0 || header.version != detail::table_file_version)
+			throw error("Unknown weight function table format " + filename);
+		if (header.value_size != sizeof(value_type) || header.value_digits != std::numeric_limits<value_type>::digits)
+			throw error("Weight function table numeric type mismatch " + filename);
+		if (header.size < 2 || header.shape[0] == 0 || header.shape[1] == 0)
+			throw error("Unknown weight function table format " + filename);
+
+		/* The data length is checked against the file size without overflow */
+		const std::uint64_t max_values = (std::numeric_limits<std::size_t>::max() - detail::table_file_data_offset) / (2 * sizeof(value_type));
+		if (header.shape[0] > max_values || header.shape[1] > max_values / header.shape[0] || header.size > max_values / (header.shape[0] * header.shape[1]))
+			throw error("Truncated weight function table " + filename);
+		if (file.size != detail::table_file_data_offset + 2 * header.size * header.shape[0] * header.shape[1] * sizeof(value_type))
+			throw error("Truncated weight function table " + filename);
+
+		std::array<value_type, detail::table_file_parameters> parameters;
+		std::memcpy(parameters.data(), file.data.get() + detail::table_file_parameters_offset, sizeof(parameters));
+
+		const auto* data = reinterpret_cast<const value_type*>(file.data.get() + detail::table_file_data_offset);
+
+		return weight_function_grid_2d_table(header, parameters, std::shared_ptr<const value_type>(std::move(file.data), data));
+	}
+
+	/**
+	 * @brief Save the table in the binary host-endian format
+	 * @param filename Output filename
+	 * @throws error If the file can not be written
+	 */
+	void save(const std::string& filename) const {
+		detail::table_file_header header{};
+
+		std::memcpy(header.magic, detail::table_file_magic, sizeof(header.magic));
+		header.version = detail::table_file_version;
+		header.value_size = sizeof(value_type);
+		header.value_digits = std::numeric_limits<value_type>::digits;
+		header.shape[0] = std::get<0>(shape_);
+		header.shape[1] = std::get<1>(shape_);
+		header.size = size_;
+
+		const std::array<value_type, detail::table_file_parameters> parameters{
+			lambda_, aperture_scale_, grid_step_, scale_, z_min_, z_max_, estimated_error_};
+
+		std::array<char, detail::table_file_data_offset> buf{};
+		std::memcpy(buf.data(), &header, sizeof(header));
+		std::memcpy(buf.data() + detail::table_file_parameters_offset, parameters.data(), sizeof(parameters));
+
+		std::ofstream stm(filename, std::ios::binary);
+		stm.write(buf.data(), buf.size());
+		stm.write(reinterpret_cast<const char*>(storage_.get()), 2 * size_ * lags() * sizeof(value_type));
+
+		if (!stm)
+			throw error("Can not write weight function table " + filename);
+	}
+
+	const auto& lambda() const noexcept { return lambda_; /* nm */ }
+	const auto& aperture_scale() const noexcept { return aperture_scale_; /* mm */ }
+	const auto& grid_step() const noexcept { return grid_step_; /* mm */ }
+	const auto& shape() const noexcept { return shape_; }
+
+	/// @return Number of altitude nodes
+	std::size_t size() const noexcept { return size_; }
+
+	/// @return Lower altitude of the table in kilometers
+	value_type altitude_min() const noexcept { return altitude(z_min_); }
+
+	/// @return Upper altitude of the table in kilometers
+	value_type altitude_max() const noexcept { return altitude(z_max_); }
+
+	/// @return Estimated interpolation error relative to the largest lag at given altitude, not a guaranteed bound
+	const auto& estimated_error() const noexcept { return estimated_error_; }
+
+	/**
+	 * @brief Interpolate weight function for uniform aperture grid at specific altitude
+	 * @param altitude Atmospheric altitude in kilometers
+	 * @return 2D tensor of weight function values on spatial grid of shape (Nx, Ny)
+	 * @throws altitude_out_of_range If the altitude is outside of the table range
+	 */
+	result_type operator() (value_type altitude) const {
+		using namespace std;
+
+		const auto x = (z(altitude) - z_min_) / (z_max_ - z_min_) * static_cast<value_type>(size_ - 1);
+
+		if (!(x >= static_cast<value_type>(0) && x <= static_cast<value_type>(size_ - 1)))
+			throw altitude_out_of_range{altitude, altitude_min(), altitude_max()};
+
+		const auto idx = min(static_cast<std::size_t>(x), size_ - 2);
+		const auto shape = std::array{size_, lags()};
+		const auto nodes = xt::adapt(values(), size_ * lags(), xt::no_ownership(), shape);
+		const auto d2 = xt::adapt(double_primes(), size_ * lags(), xt::no_ownership(), shape);
+
+		result_type res{shape_};
+		xt::adapt(res.data(), lags(), xt::no_ownership(), std::array{lags()}) =
+			interpolate(nodes, d2, idx, x - static_cast<value_type>(idx)) * pow(altitude, static_cast<value_type>(5.0/6.0));
+
+		return res;
+	}
+};
+
+extern template class weight_function_grid_2d_table<float>;
+extern template class weight_function_grid_2d_table<double>;
+extern template class weight_function_grid_2d_table<long double>;
+
+} // weif
+
+#endif // _WEIF_WEIGHT_FUNCTION_GRID_2D_TABLE_H
@@ -0,0 +1,128 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#ifndef _WEIF_WEIGHT_FUNCTION_SENSITIVITY_H
+#define _WEIF_WEIGHT_FUNCTION_SENSITIVITY_H
+
+#include <cstddef>
+
+#include <weif/progress_token.h>
+#include <weif/uniform_grid.h>
+#include <weif/weight_function.h>
+#include <weif_export.h>
+
+
+namespace weif {
+
+/**
+ * @brief Scintillation weight function together with its parameter derivatives
+ *
+ * @tparam T Numeric type for calculations
+ *
+ * Computes the weight function \f$ W(z) \f$ and its derivatives with
+ * respect to the aperture scale \f$ D \f$, the equivalent wavelength
+ * \f$ \lambda \f$ and the shape parameter \f$ p \f$ of the aperture
+ * filter, i.e. the obscuration of af::annular, for the instrument
+ * calibration by fitting.
+ *
+ * The derivatives with respect to \f$ D \f$ and \f$ \lambda \f$ follow
+ * from the derivative of the cubic spline of the dimensionless weight
+ * function, since it depends on \f$ D / \sqrt{\lambda z} \f$ only.
+ * This holds for the Kolmogorov spectrum only: the scales of
+ * spectrum::von_karman enter the table in the units of \f$ D \f$, so
+ * the weight functions here are always computed for the Kolmogorov
+ * spectrum. The derivative with respect to \f$ p \f$ is the weight function with the
+ * aperture filter replaced by \f$ \partial A / \partial p \f$, that is
+ * given by the derivative() member of the aperture filter. So the
+ * construction costs two precomputations instead of \f$ 2k + 1 \f$
+ * precomputations of the central finite differences for \f$ k \f$
+ * parameters.
+ *
+ * @see weight_function::aperture_scale_derivative()
+ * @see weight_function::lambda_derivative()
+ * @see af::annular::derivative()
+ */
+template<class T>
+class WEIF_EXPORT weight_function_sensitivity {
+public:
+	using value_type = T; ///< Numeric type for calculations
+
+	/// Weight function value and its derivatives at given altitude
+	struct gradient {
+		value_type value;          ///< \f$ W \f$
+		value_type aperture_scale; ///< \f$ \partial W / \partial D \f$ per millimeter
+		value_type lambda;         ///< \f$ \partial W / \partial \lambda \f$ per nanometer
+		value_type parameter;      ///< \f$ \partial W / \partial p \f$
+	};
+
+private:
+	weight_function<value_type> value_;
+	weight_function<value_type> parameter_;
+
+public:
+	/**
+	 * @brief Construct weight function with derivatives
+	 * @param spectral_filter Spectral filter function
+	 * @param lambda Wavelength in nanometers
+	 * @param aperture_filter Aperture filter function providing derivative() with respect to its parameter
+	 * @param aperture_scale Aperture scale in millimeters
+	 * @param grid Grid of the dimensionless weight functions
+	 * @param progress Optional progress and cancellation token
+	 *
+	 * @throws cancelled If cancellation is requested through the progress token
+	 */
+	template<class SF, class AF>
+	weight_function_sensitivity(const SF& spectral_filter, value_type lambda, const AF& aperture_filter, value_type aperture_scale,
+		const uniform_grid<value_type>& grid, progress_token* progress = nullptr):
+		value_{spectral_filter, lambda, aperture_filter, aperture_scale, grid, nullptr, progress},
+		parameter_{spectral_filter, lambda, [aperture_filter] (value_type u) noexcept -> value_type {
+			return aperture_filter.derivative(u);
+		}, aperture_scale, grid, nullptr, progress} {}
+
+	/**
+	 * @brief Construct weight function with derivatives
+	 * @param spectral_filter Spectral filter function
+	 * @param lambda Wavelength in nanometers
+	 * @param aperture_filter Aperture filter function providing derivative() with respect to its parameter
+	 * @param aperture_scale Aperture scale in millimeters
+	 * @param size Number of grid points for precomputation
+	 * @param progress Optional progress and cancellation token
+	 *
+	 * @throws cancelled If cancellation is requested through the progress token
+	 */
+	template<class SF, class AF>
+	weight_function_sensitivity(const SF& spectral_filter, value_type lambda, const AF& aperture_filter, value_type aperture_scale,
+		std::size_t size, progress_token* progress = nullptr):
+		weight_function_sensitivity(spectral_filter, lambda, aperture_filter, aperture_scale,
+			uniform_grid{static_cast<value_type>(0), static_cast<value_type>(1) / (size-1), size}, progress) {}
+
+	/// @return Weight function
+	const auto& value() const noexcept { return value_; }
+
+	/// @return Derivative of weight function with respect to the aperture filter parameter
+	const auto& parameter() const noexcept { return parameter_; }
+
+	/**
+	 * @brief Evaluate weight function and its derivatives at specific altitude
+	 * @param altitude Atmospheric altitude in kilometers
+	 * @return Weight function value and derivatives
+	 */
+	gradient operator() (value_type altitude) const noexcept {
+		return gradient{
+			value_(altitude),
+			value_.aperture_scale_derivative(altitude),
+			value_.lambda_derivative(altitude),
+			parameter_(altitude)};
+	}
+};
+
+extern template class weight_function_sensitivity<float>;
+extern template class weight_function_sensitivity<double>;
+extern template class weight_function_sensitivity<long double>;
+
+} // weif
+
+#endif // _WEIF_WEIGHT_FUNCTION_SENSITIVITY_H
@@ -0,0 +1,16 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#include <weif/airmass_weight_function.h>
+
+
+namespace weif {
+
+template class airmass_weight_function<float>;
+template class airmass_weight_function<double>;
+template class airmass_weight_function<long double>;
+
+} // weif
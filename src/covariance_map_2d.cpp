@@ -0,0 +1,16 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#include <weif/covariance_map_2d.h>
+
+
+namespace weif {
+
+template class covariance_map_2d<float>;
+template class covariance_map_2d<double>;
+template class covariance_map_2d<long double>;
+
+} // weif
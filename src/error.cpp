@@ -15,4 +15,12 @@ error::error(const char* what): std::runtime_error(what) {}
 mismatched_grids::mismatched_grids() noexcept:
 	error("Mismatched grids") {}
 
+cancelled::cancelled() noexcept:
+	error("Operation cancelled") {}
+
+mismatched_shape::mismatched_shape(std::size_t nx, std::size_t ny, std::size_t expected_nx, std::size_t expected_ny):
+	error(reinterpret_cast<std::ostringstream&>(std::ostringstream() << "Mismatched shape ("
+		<< nx << ", " << ny << "), expected ("
+		<< expected_nx << ", " << expected_ny << ")").str()) {}
+
 } // weif
@@ -0,0 +1,20 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#include <weif/detail/fftw3_wrap.h>
+
+
+namespace weif {
+namespace detail {
+
+std::mutex& fftw_planner_mutex() noexcept {
+	static std::mutex mutex;
+
+	return mutex;
+}
+
+} // detail
+} // weif
@@ -0,0 +1,16 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#include <weif/forward_model.h>
+
+
+namespace weif {
+
+template class forward_model<float>;
+template class forward_model<double>;
+template class forward_model<long double>;
+
+} // weif
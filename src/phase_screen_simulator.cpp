@@ -0,0 +1,16 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#include <weif/phase_screen_simulator.h>
+
+
+namespace weif {
+
+template class phase_screen_simulator<float>;
+template class phase_screen_simulator<double>;
+template class phase_screen_simulator<long double>;
+
+} // weif
@@ -0,0 +1,20 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#include <weif/photometric_moments.h>
+
+
+namespace weif {
+
+template class photometric_moments<float>;
+template class photometric_moments<double>;
+template class photometric_moments<long double>;
+
+template class photometric_pipeline<float>;
+template class photometric_pipeline<double>;
+template class photometric_pipeline<long double>;
+
+} // weif
@@ -0,0 +1,16 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#include <weif/profile_restoration_2d.h>
+
+
+namespace weif {
+
+template class profile_restoration_2d<float>;
+template class profile_restoration_2d<double>;
+template class profile_restoration_2d<long double>;
+
+} // weif
@@ -0,0 +1,16 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#include <weif/weight_function_cache.h>
+
+
+namespace weif {
+
+template class weight_function_cache<float>;
+template class weight_function_cache<double>;
+template class weight_function_cache<long double>;
+
+} // weif
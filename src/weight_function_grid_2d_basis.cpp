@@ -0,0 +1,16 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#include <weif/weight_function_grid_2d_basis.h>
+
+
+namespace weif {
+
+template class weight_function_grid_2d_basis<float>;
+template class weight_function_grid_2d_basis<double>;
+template class weight_function_grid_2d_basis<long double>;
+
+} // weif
@@ -0,0 +1,87 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#include <cerrno>
+#include <cstring>
+
+#if __has_include(<sys/mman.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define WEIF_HAVE_MMAP 1
+#endif
+
+#include <weif/weight_function_grid_2d_table.h>
+
+
+namespace weif {
+namespace detail {
+
+#ifdef WEIF_HAVE_MMAP
+
+mapped_file map_file(const std::string& filename) {
+	const auto fail = [&filename] (int err) {
+		return error("Can not map " + filename + ": " + std::strerror(err));
+	};
+
+	const int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		throw fail(errno);
+
+	struct stat st;
+	if (::fstat(fd, &st) < 0) {
+		const auto err = errno;
+		::close(fd);
+
+		throw fail(err);
+	}
+
+	const auto size = static_cast<std::size_t>(st.st_size);
+	if (size == 0) {
+		::close(fd);
+
+		return {nullptr, 0};
+	}
+
+	void* addr = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+	const auto err = errno;
+	::close(fd);
+
+	if (addr == MAP_FAILED)
+		throw fail(err);
+
+	return {std::shared_ptr<const std::byte>(static_cast<const std::byte*>(addr), [size] (const std::byte* p) {
+		::munmap(const_cast<std::byte*>(p), size);
+	}), size};
+}
+
+#else
+
+mapped_file map_file(const std::string& filename) {
+	std::ifstream stm(filename, std::ios::binary | std::ios::ate);
+	if (!stm)
+		throw error("Can not open " + filename);
+
+	const auto size = static_cast<std::size_t>(stm.tellg());
+	std::shared_ptr<std::byte[]> buf{new std::byte[size]};
+
+	stm.seekg(0);
+	if (!stm.read(reinterpret_cast<char*>(buf.get()), size))
+		throw error("Can not read " + filename);
+
+	return {std::shared_ptr<const std::byte>(buf, buf.get()), size};
+}
+
+#endif
+
+} // detail
+
+template class weight_function_grid_2d_table<float>;
+template class weight_function_grid_2d_table<double>;
+template class weight_function_grid_2d_table<long double>;
+
+} // weif
@@ -0,0 +1,16 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#include <weif/weight_function_sensitivity.h>
+
+
+namespace weif {
+
+template class weight_function_sensitivity<float>;
+template class weight_function_sensitivity<double>;
+template class weight_function_sensitivity<long double>;
+
+} // weif
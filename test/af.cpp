@@ -4,6 +4,8 @@
  * Copyright (C) 2012-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
  */
 
+#include <algorithm>
+#include <cmath>
 #include <limits>
 
 #include <cppunit/TestAssert.h>
@@ -16,12 +18,14 @@
 #include <xtensor/io/xio.hpp>
 #include <xtensor/containers/xarray.hpp> // IWYU pragma: keep
 #include <xtensor/containers/xtensor.hpp>
+#include <xtensor/core/xmath.hpp>
 
 #include <weif/af/angle_averaged.h>
 #include <weif/af/circular.h>
 #include <weif/af/gauss.h>
 #include <weif/af/point.h>
 #include <weif/af/square.h>
+#include <weif/af/wind_smoothed.h>
 
 #include "xexpression.h"
 
@@ -34,6 +38,8 @@ CPPUNIT_TEST(test_annular1);
 CPPUNIT_TEST(test_annular2);
 CPPUNIT_TEST(test_annular_vec1);
 CPPUNIT_TEST(test_annular_vec2);
+CPPUNIT_TEST(test_annular_derivative1);
+CPPUNIT_TEST(test_annular_taylor1);
 CPPUNIT_TEST(test_cross_annular1);
 CPPUNIT_TEST(test_cross_annular2);
 CPPUNIT_TEST(test_cross_annular_vec1);
@@ -50,6 +56,9 @@ CPPUNIT_TEST(test_angle_averaged_point1);
 CPPUNIT_TEST(test_angle_averaged_point_vec1);
 CPPUNIT_TEST(test_angle_averaged_circular1);
 CPPUNIT_TEST(test_angle_averaged_circular_vec1);
+CPPUNIT_TEST(test_wind_smoothed1);
+CPPUNIT_TEST(test_wind_smoothed2);
+CPPUNIT_TEST(test_wind_smoothed_vec1);
 CPPUNIT_TEST_SUITE_END();
 
 void test_circular1() {
@@ -196,6 +205,40 @@ void test_annular_vec2() {
 	XT_ASSERT_XEXPRESSION_CLOSE(expected, actual, delta);
 }
 
+void test_annular_derivative1() {
+	using namespace weif::af;
+
+	constexpr auto step = 1e-6;
+	constexpr auto delta = 1e-6;
+	const annular<double> af{0.5};
+	const annular<double> af_lower{0.5 - step};
+	const annular<double> af_upper{0.5 + step};
+
+	for (auto u: {0.3, 1.0, 2.5, 7.0}) {
+		const auto expected = (af_upper(u) - af_lower(u)) / (2 * step);
+
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(expected, af.derivative(u), delta * std::max(std::abs(expected), 1e-3));
+	}
+}
+
+void test_annular_taylor1() {
+	using namespace weif::af;
+
+	constexpr auto delta = 1e-14;
+	const annular<double> af{0.5};
+
+	for (auto u: {0.05, 0.2, 0.5}) {
+		double actual = 0;
+		double power = 1;
+		for (std::size_t n = 0; n < 30; ++n) {
+			actual += af.taylor(n) * power;
+			power *= u * u;
+		}
+
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(af(u), actual, delta);
+	}
+}
+
 void test_cross_annular1() {
 	using namespace weif::af;
 
@@ -543,6 +586,62 @@ void test_angle_averaged_circular_vec1() {
 	XT_ASSERT_XEXPRESSION_CLOSE(expected, actual, epsilon, delta);
 }
 
+void test_wind_smoothed1() {
+	using namespace weif::af;
+
+	constexpr auto delta = 1e-7;
+	const wind_smoothed af{circular<double>{}, 0.5};
+	/* Direction average of the anisotropic filter by the quadrature */
+	const angle_averaged expected{af, 8192};
+
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, af(0.0), delta);
+	for (auto u: {0.1, 0.5, 1.0, 2.0, 5.0, 10.0}) {
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(expected(u), af(u), delta * expected(u));
+	}
+}
+
+void test_wind_smoothed2() {
+	using namespace weif::af;
+
+	constexpr auto PI = xt::numeric_constants<double>::PI;
+	constexpr auto delta = 1e-15;
+	const circular<double> circ{};
+	const wind_smoothed still{circ, 0.0};
+	const wind_smoothed af{circ, 2.0, PI / 2};
+
+	for (auto u: {0.1, 0.5, 1.0, 2.0}) {
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(circ(u), still(u), delta);
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(circ(u, 0.0), af(u, 0.0), delta);
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(circ(0.0, u) * std::pow(std::sin(2 * PI * u) / (2 * PI * u), 2), af(0.0, u), delta);
+	}
+
+	/* sinc^2 vanishes at the integer shifts */
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, af(0.0, 0.5), delta);
+}
+
+void test_wind_smoothed_vec1() {
+	using namespace weif::af;
+
+	const auto delta = std::numeric_limits<double>::epsilon();
+	const xt::xarray<double> args = {0.0, 0.1, 1.0, 10.0, std::numeric_limits<double>::infinity()};
+	const wind_smoothed af{circular<double>{}, 0.5, 0.3};
+	const xt::xarray<double> expected = {af(0.0), af(0.1), af(1.0), af(10.0), 0.0};
+	xt::xarray<double> actual = af(args);
+
+	XT_ASSERT_XEXPRESSION_CLOSE(expected, actual, delta);
+
+	const xt::xarray<double> ex = {0.0, 0.3, 1.0};
+	const xt::xarray<double> ey = {-0.5, 0.2};
+	xt::xarray<double> actual2 = af(ex, ey);
+	CPPUNIT_ASSERT_EQUAL(std::size_t{3}, actual2.shape()[0]);
+	CPPUNIT_ASSERT_EQUAL(std::size_t{2}, actual2.shape()[1]);
+	for (std::size_t i = 0; i < ex.size(); ++i) {
+		for (std::size_t j = 0; j < ey.size(); ++j) {
+			CPPUNIT_ASSERT_DOUBLES_EQUAL(af(ex(i), ey(j)), actual2(i, j), delta);
+		}
+	}
+}
+
 };
 CPPUNIT_TEST_SUITE_REGISTRATION(test_af_suite);
 
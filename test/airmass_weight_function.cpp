@@ -0,0 +1,102 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#include <cstddef>
+
+#include <cppunit/TestAssert.h>
+#include <cppunit/TestCase.h>
+#include <cppunit/Portability.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/ui/text/TestRunner.h>
+
+#include <xtensor/io/xio.hpp>
+#include <xtensor/containers/xtensor.hpp>
+#include <xtensor/core/xmath.hpp>
+
+#include <weif/af/circular.h>
+#include <weif/sf/mono.h>
+#include <weif/sf/poly.h>
+#include <weif/airmass_weight_function.h>
+#include <weif/spectral_response.h>
+#include <weif/uniform_grid.h>
+#include <weif/weight_function.h>
+
+#include "xexpression.h"
+
+
+class test_airmass_weight_function_suite: public CppUnit::TestCase {
+CPPUNIT_TEST_SUITE(test_airmass_weight_function_suite);
+CPPUNIT_TEST(test_airmass1);
+CPPUNIT_TEST(test_airmass2);
+CPPUNIT_TEST_SUITE_END();
+
+void test_airmass1() {
+	using namespace weif;
+
+	constexpr double lambda = 550;
+	constexpr double aperture_scale = 10;
+	constexpr double delta = 1e-12;
+	const xt::xtensor<double, 1> altitudes = {0.5, 1.0, 4.0, 16.0};
+	const xt::xtensor<double, 1> airmasses = {1.0, 1.5, 2.0};
+	const airmass_weight_function<double> wf(sf::mono<double>{}, lambda, af::circular<double>{}, aperture_scale, 1024);
+	const weight_function<double> zenith(sf::mono<double>{}, lambda, af::circular<double>{}, aperture_scale, 1024);
+
+	const xt::xtensor<double, 2> actual = wf(altitudes, airmasses);
+	CPPUNIT_ASSERT_EQUAL(altitudes.size(), actual.shape()[0]);
+	CPPUNIT_ASSERT_EQUAL(airmasses.size(), actual.shape()[1]);
+	CPPUNIT_ASSERT_EQUAL(std::size_t{1}, wf.size());
+
+	for (std::size_t i = 0; i < altitudes.size(); ++i) {
+		for (std::size_t j = 0; j < airmasses.size(); ++j) {
+			const auto expected = airmasses(j) * zenith(altitudes(i) * airmasses(j));
+
+			CPPUNIT_ASSERT_DOUBLES_EQUAL(expected, actual(i, j), delta * expected);
+			CPPUNIT_ASSERT_DOUBLES_EQUAL(expected, wf(altitudes(i), airmasses(j)), delta * expected);
+		}
+	}
+}
+
+void test_airmass2() {
+	using namespace weif;
+
+	constexpr double aperture_scale = 10;
+	constexpr double delta = 1e-9;
+	const uniform_grid<double> grid{400.0, 1.0, 201};
+	const spectral_response<double> response{grid, xt::exp(-xt::square((grid.values() - 500.0) / 40.0))};
+	const spectral_response<double> transmission{grid, xt::exp(-0.2 * xt::pow(400.0 / grid.values(), 4))};
+	const xt::xtensor<double, 1> altitudes = {0.5, 1.0, 4.0, 16.0};
+	const xt::xtensor<double, 1> airmasses = {1.0, 2.0, 1.0};
+	const airmass_weight_function<double> wf(response, transmission, af::circular<double>{}, aperture_scale, 256, 4096);
+	CPPUNIT_ASSERT_EQUAL(std::size_t{0}, wf.size());
+
+	const xt::xtensor<double, 2> actual = wf(altitudes, airmasses);
+	CPPUNIT_ASSERT_EQUAL(std::size_t{2}, wf.size());
+	/* Rayleigh extinction shifts the effective response to the red */
+	CPPUNIT_ASSERT(wf.weight(2.0)->lambda() > wf.weight(1.0)->lambda());
+
+	auto sr = response.stacked(spectral_response<double>{grid, xt::square(transmission.data())}).normalized();
+	sf::poly<double> spectral_filter{sr, 4096};
+	const auto lambda = spectral_filter.equiv_lambda();
+	spectral_filter.normalize();
+	const weight_function<double> expected_wf(spectral_filter, lambda, af::circular<double>{}, aperture_scale, 256);
+
+	for (std::size_t i = 0; i < altitudes.size(); ++i) {
+		const auto expected = 2.0 * expected_wf(2.0 * altitudes(i));
+
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(expected, actual(i, 1), delta * expected);
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(actual(i, 0), actual(i, 2), delta * actual(i, 0));
+	}
+}
+};
+CPPUNIT_TEST_SUITE_REGISTRATION(test_airmass_weight_function_suite);
+
+int main(int argc, char **argv) {
+	CppUnit::TextUi::TestRunner runner;
+	CppUnit::TestFactoryRegistry &registry = CppUnit::TestFactoryRegistry::getRegistry();
+	runner.addTest(registry.makeTest());
+	return !runner.run("", false);
+}
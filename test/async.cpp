@@ -0,0 +1,76 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#include <cstddef>
+#include <functional>
+
+#include <cppunit/TestAssert.h>
+#include <cppunit/TestCase.h>
+#include <cppunit/Portability.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/ui/text/TestRunner.h>
+
+#include <xtensor/io/xio.hpp>
+#include <xtensor/containers/xarray.hpp> // IWYU pragma: keep
+
+#include <weif/af/circular.h>
+#include <weif/sf/mono.h>
+#include <weif/async.h>
+#include <weif/error.h>
+#include <weif/progress_token.h>
+#include <weif/weight_function.h>
+
+#include "xexpression.h"
+
+
+class test_async_suite: public CppUnit::TestCase {
+CPPUNIT_TEST_SUITE(test_async_suite);
+CPPUNIT_TEST(test_async1);
+CPPUNIT_TEST(test_async2);
+CPPUNIT_TEST_SUITE_END();
+
+void test_async1() {
+	using namespace weif;
+
+	constexpr double lambda = 550;
+	constexpr double aperture_scale = 10;
+	const xt::xarray<double> args = {0.0, 0.5, 1.0, 2.0, 4.0, 8.0, 16.0, 32.0};
+	const sf::mono<double> spectral_filter{};
+	auto future = make_async<weight_function<double>>(std::cref(spectral_filter), lambda, af::circular<double>{}, aperture_scale, std::size_t{1024});
+	const weight_function<double> expected(spectral_filter, lambda, af::circular<double>{}, aperture_scale, 1024);
+	const auto actual = future.get();
+
+	XT_ASSERT_XEXPRESSION_CLOSE(expected(args), actual(args), 0.0);
+}
+
+void test_async2() {
+	using namespace weif;
+
+	constexpr double lambda = 550;
+	constexpr double aperture_scale = 10;
+	std::size_t submitted = 0;
+	const auto executor = [&submitted] (auto&& task) {
+		++submitted;
+		task();
+	};
+	progress_token progress;
+	progress.cancel();
+
+	auto future = make_async_on<weight_function<double>>(executor, sf::mono<double>{}, lambda, af::circular<double>{}, aperture_scale, std::size_t{1024}, nullptr, &progress);
+
+	CPPUNIT_ASSERT_EQUAL(std::size_t{1}, submitted);
+	CPPUNIT_ASSERT_THROW(future.get(), weif::cancelled);
+}
+};
+CPPUNIT_TEST_SUITE_REGISTRATION(test_async_suite);
+
+int main(int argc, char **argv) {
+	CppUnit::TextUi::TestRunner runner;
+	CppUnit::TestFactoryRegistry &registry = CppUnit::TestFactoryRegistry::getRegistry();
+	runner.addTest(registry.makeTest());
+	return !runner.run("", false);
+}
@@ -0,0 +1,103 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+
+#include <cppunit/TestAssert.h>
+#include <cppunit/TestCase.h>
+#include <cppunit/Portability.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/ui/text/TestRunner.h>
+
+#include <xtensor/io/xio.hpp>
+#include <xtensor/containers/xtensor.hpp>
+#include <xtensor/core/xmath.hpp>
+#include <xtensor/generators/xbuilder.hpp>
+#include <xtensor/views/xview.hpp>
+
+#include <weif/covariance_map_2d.h>
+#include <weif/error.h>
+
+#include "xexpression.h"
+
+
+class test_covariance_map_2d_suite: public CppUnit::TestCase {
+CPPUNIT_TEST_SUITE(test_covariance_map_2d_suite);
+CPPUNIT_TEST(test_covariance_map_2d1);
+CPPUNIT_TEST_SUITE_END();
+
+void test_covariance_map_2d1() {
+	using namespace weif;
+
+	constexpr std::size_t nx = 8;
+	constexpr std::size_t ny = 6;
+	constexpr std::size_t frames = 5;
+	constexpr double delta = 1e-10;
+
+	xt::xtensor<double, 2> mask = xt::ones<double>({nx, ny});
+	mask(0, 0) = 0.0;
+	mask(nx - 1, ny - 1) = 0.0;
+
+	xt::xtensor<double, 3> images{std::array{frames, nx, ny}};
+	for (std::size_t f = 0; f < frames; ++f) {
+		for (std::size_t i = 0; i < nx; ++i) {
+			for (std::size_t j = 0; j < ny; ++j) {
+				images(f, i, j) = 100.0 + 10.0 * std::sin(0.7 * i + 1.3 * j + 2.1 * f) + 3.0 * std::cos(1.9 * i * j + f);
+			}
+		}
+	}
+
+	/* Direct sum over all pixel pairs with lags (+-j, +-k) */
+	xt::xtensor<double, 2> expected = xt::zeros<double>({4, 3});
+	xt::xtensor<double, 2> count = xt::zeros<double>({4, 3});
+	for (std::size_t f = 0; f < frames; ++f) {
+		const double mean = xt::sum(xt::view(images, f, xt::all(), xt::all()) * mask)() / xt::sum(mask)();
+		const xt::xtensor<double, 2> fluctuation = (xt::view(images, f, xt::all(), xt::all()) / mean - 1.0) * mask;
+
+		for (std::size_t i1 = 0; i1 < nx; ++i1) {
+			for (std::size_t j1 = 0; j1 < ny; ++j1) {
+				for (std::size_t i2 = 0; i2 < nx; ++i2) {
+					for (std::size_t j2 = 0; j2 < ny; ++j2) {
+						const auto dx = static_cast<std::size_t>(std::abs(static_cast<long>(i1) - static_cast<long>(i2)));
+						const auto dy = static_cast<std::size_t>(std::abs(static_cast<long>(j1) - static_cast<long>(j2)));
+
+						if (dx < 4 && dy < 3) {
+							expected(dx, dy) += fluctuation(i1, j1) * fluctuation(i2, j2);
+							count(dx, dy) += mask(i1, j1) * mask(i2, j2);
+						}
+					}
+				}
+			}
+		}
+	}
+	expected /= count;
+
+	covariance_map_2d<double> single(mask, {4, 3});
+	for (std::size_t f = 0; f < frames; ++f) {
+		single.push(xt::view(images, f, xt::all(), xt::all()));
+	}
+
+	covariance_map_2d<double> threaded(mask, {4, 3});
+	threaded.push_frames(images, 3);
+
+	CPPUNIT_ASSERT_EQUAL(frames, threaded.frames());
+	XT_ASSERT_XEXPRESSION_CLOSE(expected, single(), delta, delta * 1e-3);
+	XT_ASSERT_XEXPRESSION_CLOSE(expected, threaded(), delta, delta * 1e-3);
+
+	CPPUNIT_ASSERT_THROW(covariance_map_2d<double>(std::array<std::size_t, 2>{3, 3}, {4, 3}), weif::mismatched_shape);
+}
+};
+CPPUNIT_TEST_SUITE_REGISTRATION(test_covariance_map_2d_suite);
+
+int main(int argc, char **argv) {
+	CppUnit::TextUi::TestRunner runner;
+	CppUnit::TestFactoryRegistry &registry = CppUnit::TestFactoryRegistry::getRegistry();
+	runner.addTest(registry.makeTest());
+	return !runner.run("", false);
+}
@@ -42,6 +42,8 @@ CPPUNIT_TEST(test_spline11);
 CPPUNIT_TEST(test_spline12);
 CPPUNIT_TEST(test_spline13);
 CPPUNIT_TEST(test_spline14);
+CPPUNIT_TEST(test_spline_derivative1);
+CPPUNIT_TEST(test_spline_derivative2);
 CPPUNIT_TEST_SUITE_END();
 
 void test_spline1() {
@@ -198,6 +200,29 @@ void test_spline14() {
 	XT_ASSERT_XEXPRESSION_CLOSE(expected, actual, delta);
 };
 
+void test_spline_derivative1() {
+	constexpr auto delta = 4 * std::numeric_limits<value_type>::epsilon();
+
+	/* The spline reproduces the parabola, so the derivative is 2 x */
+	cubic_spline s{xt::square(xt::arange<value_type>(0.0f, 4.0f, 1.0f)),
+		second_order_boundary{2.0f, 2.0f}};
+
+	for (const auto x: {0.0f, 0.5f, 1.25f, 2.0f, 2.75f}) {
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(2 * x, s.derivative(x), delta * (1 + 2 * x));
+	}
+};
+
+void test_spline_derivative2() {
+	constexpr auto delta = 4 * std::numeric_limits<value_type>::epsilon();
+
+	cubic_spline s{xt::arange<value_type>(0.0f, 4.0f, 1.0f) + 1.0f,
+		first_order_boundary{1.0f, 1.0f}};
+
+	for (const auto x: {0.0f, 0.5f, 1.25f, 2.0f, 2.75f}) {
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0f, s.derivative(x), delta);
+	}
+};
+
 };
 CPPUNIT_TEST_SUITE_REGISTRATION(test_cubic_spline_suite);
 
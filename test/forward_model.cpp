@@ -0,0 +1,66 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#include <functional>
+#include <vector>
+
+#include <cppunit/TestAssert.h>
+#include <cppunit/TestCase.h>
+#include <cppunit/Portability.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/ui/text/TestRunner.h>
+
+#include <xtensor/io/xio.hpp>
+#include <xtensor/containers/xarray.hpp> // IWYU pragma: keep
+#include <xtensor/core/xmath.hpp>
+#include <xtensor/core/xoperation.hpp>
+#include <xtensor/views/xview.hpp>
+
+#include <weif/forward_model.h>
+
+#include "xexpression.h"
+
+
+class test_forward_model_suite: public CppUnit::TestCase {
+CPPUNIT_TEST_SUITE(test_forward_model_suite);
+CPPUNIT_TEST(test_forward_model1);
+CPPUNIT_TEST_SUITE_END();
+
+void test_forward_model1() {
+	using namespace weif;
+
+	constexpr double delta = 1e-12;
+	const std::vector<std::function<double(double)>> wfs{
+		[] (double) { return 1.0; },
+		[] (double h) { return h; },
+		[] (double h) { return h * h; }};
+	const xt::xarray<double> edges = {0.0, 1.0, 4.0, 16.0};
+	const forward_model<double> model(wfs, edges);
+
+	const xt::xarray<double> weights = {{1.0, 0.5, 1.0 / 3}, {1.0, 2.5, 7.0}, {1.0, 10.0, 112.0}};
+	XT_ASSERT_XEXPRESSION_CLOSE(weights, model.weights(), delta);
+
+	const prior::log_uniform<double> prior{1e-3, 1e-1, 0.5};
+	const std::size_t count = 1000;
+	const auto [profiles, indices] = model.generate(prior, count, 42, 3);
+	const auto [profiles1, indices1] = model.generate(prior, count, 42, 1);
+
+	CPPUNIT_ASSERT_EQUAL(count, profiles.shape()[0]);
+	CPPUNIT_ASSERT(xt::all(xt::equal(profiles, 0.0) || (profiles >= 1e-3 && profiles <= 1e-1)));
+	XT_ASSERT_XEXPRESSION_CLOSE(profiles1, profiles, 0.0, 0.0);
+	XT_ASSERT_XEXPRESSION_CLOSE(model(profiles), indices, delta);
+	XT_ASSERT_XEXPRESSION_CLOSE(xt::view(indices, xt::all(), 0), xt::sum(profiles, {1}), delta);
+}
+};
+CPPUNIT_TEST_SUITE_REGISTRATION(test_forward_model_suite);
+
+int main(int argc, char **argv) {
+	CppUnit::TextUi::TestRunner runner;
+	CppUnit::TestFactoryRegistry &registry = CppUnit::TestFactoryRegistry::getRegistry();
+	runner.addTest(registry.makeTest());
+	return !runner.run("", false);
+}
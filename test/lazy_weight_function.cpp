@@ -0,0 +1,118 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#include <limits>
+#include <thread>
+#include <vector>
+
+#include <cppunit/TestAssert.h>
+#include <cppunit/TestCase.h>
+#include <cppunit/Portability.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/ui/text/TestRunner.h>
+
+#include <xtensor/io/xio.hpp>
+#include <xtensor/containers/xarray.hpp> // IWYU pragma: keep
+#include <xtensor/generators/xbuilder.hpp>
+
+#include <weif/af/circular.h>
+#include <weif/sf/mono.h>
+#include <weif/lazy_weight_function.h>
+
+#include "xexpression.h"
+
+
+class test_lazy_weight_function_suite: public CppUnit::TestCase {
+CPPUNIT_TEST_SUITE(test_lazy_weight_function_suite);
+CPPUNIT_TEST(test_lazy1);
+CPPUNIT_TEST(test_lazy2);
+CPPUNIT_TEST(test_lazy3);
+CPPUNIT_TEST_SUITE_END();
+
+void test_lazy1() {
+	using namespace weif;
+
+	constexpr double lambda = 550;
+	constexpr double aperture_scale = 10;
+	constexpr double delta = 0.0003;
+	const xt::xarray<double> args = {0.0, 0.5, 1.0, 2.0, 4.0, 8.0, 16.0, 32.0, std::numeric_limits<double>::infinity()};
+	const lazy_weight_function<double> wf(sf::mono<double>{}, lambda, af::circular<double>{}, aperture_scale, 1024);
+	const xt::xarray<double> actual = wf(args);
+	const xt::xarray<double> expected = {
+		0.0,
+		46095950091.596612607102260600389647472116,
+		96324603994.200757824334431948993478379833,
+		188826153859.60382074969531148828372231882,
+		356304606621.6182453863281127220806838675,
+		657076804976.76374836331145577965938358833,
+		1195089206023.7645592517542497518071268875,
+		2155584522441.6070284117170416038147092549,
+		std::numeric_limits<double>::infinity()
+	};
+
+	XT_ASSERT_XEXPRESSION_CLOSE(expected, actual, delta);
+}
+
+void test_lazy2() {
+	using namespace weif;
+
+	constexpr double lambda = 550;
+	constexpr double aperture_scale = 10;
+	constexpr std::size_t size = 1024;
+	const lazy_weight_function<double> wf(sf::mono<double>{}, lambda, af::circular<double>{}, aperture_scale, size);
+
+	CPPUNIT_ASSERT_EQUAL(std::size_t{0}, wf.computed());
+
+	wf(1.0);
+	CPPUNIT_ASSERT(wf.computed() <= 4);
+
+	wf.precompute(0.0, 2.0);
+	const auto computed = wf.computed();
+	CPPUNIT_ASSERT(computed < size);
+
+	const xt::xarray<double> args = xt::linspace(0.0, 2.0, 100);
+	const xt::xarray<double> values = wf(args);
+	CPPUNIT_ASSERT_EQUAL(computed, wf.computed());
+}
+void test_lazy3() {
+	using namespace weif;
+
+	constexpr long double lambda = 550;
+	constexpr long double aperture_scale = 10;
+	constexpr std::size_t size = 256;
+	constexpr std::size_t threads = 4;
+	const lazy_weight_function<long double> wf(sf::mono<long double>{}, lambda, af::circular<long double>{}, aperture_scale, size);
+	const lazy_weight_function<long double> expected(sf::mono<long double>{}, lambda, af::circular<long double>{}, aperture_scale, size);
+	const xt::xarray<long double> args = xt::linspace(0.1L, 4.0L, 64);
+
+	/* Concurrent first accesses publish every node once */
+	std::vector<xt::xarray<long double>> actual(threads);
+	std::vector<std::thread> workers;
+	for (std::size_t i = 0; i < threads; ++i) {
+		workers.emplace_back([&wf, &args, &actual, i] () {
+			actual[i] = wf(args);
+		});
+	}
+	for (auto& w: workers) {
+		w.join();
+	}
+
+	const xt::xarray<long double> values = expected(args);
+	for (const auto& a: actual) {
+		XT_ASSERT_XEXPRESSION_CLOSE(values, a, 0.0L, 0.0L);
+	}
+	CPPUNIT_ASSERT_EQUAL(expected.computed(), wf.computed());
+}
+};
+CPPUNIT_TEST_SUITE_REGISTRATION(test_lazy_weight_function_suite);
+
+int main(int argc, char **argv) {
+	CppUnit::TextUi::TestRunner runner;
+	CppUnit::TestFactoryRegistry &registry = CppUnit::TestFactoryRegistry::getRegistry();
+	runner.addTest(registry.makeTest());
+	return !runner.run("", false);
+}
@@ -4,6 +4,8 @@
  * Copyright (C) 2012-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
  */
 
+#include <cmath>
+#include <complex>
 #include <limits>
 
 #include <cppunit/TestAssert.h>
@@ -26,6 +28,8 @@ CPPUNIT_TEST_SUITE(test_math_suite);
 CPPUNIT_TEST(test_jinc_pi1);
 CPPUNIT_TEST(test_jinc_pi_vec1);
 CPPUNIT_TEST(test_sinc_pi_vec1);
+CPPUNIT_TEST(test_lgamma1);
+CPPUNIT_TEST(test_lgamma2);
 CPPUNIT_TEST_SUITE_END();
 
 void test_jinc_pi1() {
@@ -91,6 +95,58 @@ void test_sinc_pi_vec1() {
 	XT_ASSERT_XEXPRESSION_CLOSE(expected, actual, delta);
 }
 
+void test_lgamma1() {
+	using namespace weif::math;
+
+	constexpr double delta = 1e-12;
+	constexpr double PI = xt::numeric_constants<double>::PI;
+	constexpr double LN2 = xt::numeric_constants<double>::LN2;
+
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, lgamma(std::complex<double>{1.0, 0.0}).real(), delta);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(std::log(PI) / 2, lgamma(std::complex<double>{0.5, 0.0}).real(), delta);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(std::lgamma(-2.5), lgamma(std::complex<double>{-2.5, 0.0}).real(), delta);
+
+	/* $|\Gamma(1 + iy)|^2 = \pi y / \sinh(\pi y)$, $|\Gamma(1/2 + iy)|^2 = \pi / \cosh(\pi y)$ */
+	for (const double y: {1.0, 20.0, 100.0}) {
+		const double log_sinh = PI * y - LN2 + std::log1p(-std::exp(-2 * PI * y));
+		const double log_cosh = PI * y - LN2 + std::log1p(std::exp(-2 * PI * y));
+
+		CPPUNIT_ASSERT_DOUBLES_EQUAL((std::log(PI * y) - log_sinh) / 2, lgamma(std::complex<double>{1.0, y}).real(), delta * y);
+		CPPUNIT_ASSERT_DOUBLES_EQUAL((std::log(PI) - log_cosh) / 2, lgamma(std::complex<double>{0.5, y}).real(), delta * y);
+	}
+
+	/* $\Gamma(z + 1) = z \Gamma(z)$ */
+	for (const auto z: {std::complex<double>{0.125, -20.0}, std::complex<double>{3.0, 7.0}}) {
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, std::abs(std::exp(lgamma(z + 1.0) - lgamma(z)) - z), delta * std::abs(z));
+	}
+}
+
+void test_lgamma2() {
+	using namespace weif::math;
+
+	/* CPPUNIT_ASSERT_DOUBLES_EQUAL() would round to double */
+	constexpr long double delta = 64 * std::numeric_limits<long double>::epsilon();
+	constexpr long double PI = xt::numeric_constants<long double>::PI;
+
+	for (const long double x: {0.125L, 0.5L, 1.0L, 3.7L, 10.25L, 30.0L, -2.5L}) {
+		const long double expected = std::lgamma(x);
+
+		CPPUNIT_ASSERT(std::abs(expected - lgamma(std::complex<long double>{x, 0.0L}).real()) < delta * (1 + std::abs(expected)));
+	}
+
+	/* $|\Gamma(1 + iy)|^2 = \pi y / \sinh(\pi y)$ */
+	for (const long double y: {1.0L, 20.0L}) {
+		const long double log_sinh = PI * y - std::log(2.0L) + std::log1p(-std::exp(-2 * PI * y));
+
+		CPPUNIT_ASSERT(std::abs((std::log(PI * y) - log_sinh) / 2 - lgamma(std::complex<long double>{1.0L, y}).real()) < delta * y);
+	}
+
+	/* $\Gamma(z + 1) = z \Gamma(z)$ */
+	for (const auto z: {std::complex<long double>{0.125L, -20.0L}, std::complex<long double>{0.875L, 3.0L}}) {
+		CPPUNIT_ASSERT(std::abs(std::exp(lgamma(z + 1.0L) - lgamma(z)) - z) < delta * std::abs(z));
+	}
+}
+
 };
 CPPUNIT_TEST_SUITE_REGISTRATION(test_math_suite);
 
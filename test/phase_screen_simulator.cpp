@@ -0,0 +1,82 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#include <cppunit/TestAssert.h>
+#include <cppunit/TestCase.h>
+#include <cppunit/Portability.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/ui/text/TestRunner.h>
+
+#include <xtensor/io/xio.hpp>
+#include <xtensor/containers/xarray.hpp> // IWYU pragma: keep
+#include <xtensor/core/xmath.hpp>
+#include <xtensor/generators/xbuilder.hpp>
+
+#include <weif/af/circular.h>
+#include <weif/sf/mono.h>
+#include <weif/phase_screen_simulator.h>
+#include <weif/weight_function.h>
+
+#include "xexpression.h"
+
+
+class test_phase_screen_simulator_suite: public CppUnit::TestCase {
+CPPUNIT_TEST_SUITE(test_phase_screen_simulator_suite);
+CPPUNIT_TEST(test_phase_screen_simulator1);
+CPPUNIT_TEST(test_phase_screen_simulator2);
+CPPUNIT_TEST_SUITE_END();
+
+void test_phase_screen_simulator1() {
+	using namespace weif;
+
+	constexpr double lambda = 500;
+	constexpr double aperture_scale = 40;
+	constexpr double altitude = 5;
+	constexpr double intensity = 1e-13;
+	constexpr double delta = 0.05;
+	const weight_function<double> wf(sf::mono<double>{}, lambda, af::circular<double>{}, aperture_scale, 1024);
+	const phase_screen_simulator<double> simulator(256, 5.0, [] (double x, double y) {
+		return (x * x + y * y <= aperture_scale * aperture_scale / 4 ? 1.0 : 0.0);
+	}, lambda);
+
+	const xt::xarray<double> altitudes = {altitude};
+	const xt::xarray<double> intensities = {intensity};
+	const auto actual = simulator(altitudes, intensities, 8, 42, 3);
+	const auto actual1 = simulator(altitudes, intensities, 8, 42, 1);
+
+	CPPUNIT_ASSERT_EQUAL(std::size_t{8}, actual.realizations);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(actual1.index, actual.index, 1e-12 * actual.index);
+	/* The deviation from the weight function is statistical */
+	CPPUNIT_ASSERT(actual.error < delta * actual.index);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(wf(altitude) * intensity, actual.index, 5 * actual.error);
+}
+
+void test_phase_screen_simulator2() {
+	using namespace weif;
+
+	constexpr double delta = 1e-10;
+	const phase_screen_simulator<double> simulator(64, 5.0, [] (double, double) { return 1.0; }, 500.0);
+
+	const xt::xarray<double> altitudes = {1.0, 8.0};
+	const xt::xarray<double> intensities = {1e-13, 1e-13};
+	const auto frames = simulator.pupil_intensity(altitudes, intensities, 4, 42);
+
+	CPPUNIT_ASSERT_EQUAL(std::size_t{4}, frames.shape()[0]);
+	XT_ASSERT_XEXPRESSION_CLOSE(xt::ones<double>({4}), xt::mean(frames, {1, 2}), delta);
+
+	const xt::xarray<double> zeros = {0.0, 0.0};
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, simulator(altitudes, zeros, 2).index, delta);
+}
+};
+CPPUNIT_TEST_SUITE_REGISTRATION(test_phase_screen_simulator_suite);
+
+int main(int argc, char **argv) {
+	CppUnit::TextUi::TestRunner runner;
+	CppUnit::TestFactoryRegistry &registry = CppUnit::TestFactoryRegistry::getRegistry();
+	runner.addTest(registry.makeTest());
+	return !runner.run("", false);
+}
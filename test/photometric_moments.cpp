@@ -0,0 +1,230 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#include <atomic>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <cppunit/TestAssert.h>
+#include <cppunit/TestCase.h>
+#include <cppunit/Portability.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/ui/text/TestRunner.h>
+
+#include <weif/detail/spsc_ring_buffer.h>
+#include <weif/photometric_moments.h>
+
+
+class test_photometric_moments_suite: public CppUnit::TestCase {
+CPPUNIT_TEST_SUITE(test_photometric_moments_suite);
+CPPUNIT_TEST(test_moments1);
+CPPUNIT_TEST(test_moments2);
+CPPUNIT_TEST(test_pipeline1);
+CPPUNIT_TEST(test_pipeline2);
+CPPUNIT_TEST(test_ring_buffer1);
+CPPUNIT_TEST_SUITE_END();
+
+using moments_type = weif::photometric_moments<double>;
+using sample_type = moments_type::sample_type;
+
+static std::vector<sample_type> make_samples(std::size_t size) {
+	std::vector<sample_type> ret(size);
+
+	for (std::size_t k = 0; k < size; ++k) {
+		for (std::size_t c = 0; c < moments_type::channels; ++c) {
+			ret[k][c] = 1000.0 * (c + 1) * (1.0 + 0.1 * std::sin(0.37 * k * (c + 1)) + 0.05 * std::cos(0.11 * k));
+		}
+	}
+
+	return ret;
+}
+
+/* Two-pass reference with dead time correction and photon noise bias */
+static moments_type::indices_type reference(const std::vector<sample_type>& samples, double dead_time_ratio) {
+	const auto m = static_cast<double>(samples.size());
+	sample_type mean{}, bias{};
+
+	for (const auto& s: samples) {
+		for (std::size_t c = 0; c < moments_type::channels; ++c) {
+			const auto n = s[c] / (1.0 - s[c] * dead_time_ratio);
+
+			mean[c] += n / m;
+			bias[c] += n * (1.0 + n * dead_time_ratio) / m;
+		}
+	}
+
+	moments_type::indices_type ret{};
+	for (std::size_t i = 0, k = 0; i < moments_type::channels; ++i) {
+		for (std::size_t j = 0; j <= i; ++j, ++k) {
+			double covariance = 0;
+
+			for (const auto& s: samples) {
+				const auto ni = s[i] / (1.0 - s[i] * dead_time_ratio);
+				const auto nj = s[j] / (1.0 - s[j] * dead_time_ratio);
+
+				covariance += (ni - mean[i]) * (nj - mean[j]) / (m - 1.0);
+			}
+
+			ret[k] = (covariance - (i == j ? bias[i] : 0.0)) / (mean[i] * mean[j]);
+		}
+	}
+
+	return ret;
+}
+
+void test_moments1() {
+	constexpr double delta = 1e-10;
+	constexpr double exposure = 1e-3;
+	const auto samples = make_samples(5000);
+
+	for (const double dead_time: {0.0, 20e-9}) {
+		moments_type moments{exposure, dead_time};
+		moments.add(samples.cbegin(), samples.cend());
+
+		const auto expected = reference(samples, dead_time / exposure);
+		const auto actual = moments.indices();
+
+		CPPUNIT_ASSERT_EQUAL(std::size_t{10}, actual.size());
+		for (std::size_t k = 0; k < expected.size(); ++k) {
+			CPPUNIT_ASSERT_DOUBLES_EQUAL(expected[k], actual[k], delta * std::abs(expected[k]));
+		}
+	}
+
+	moments_type empty;
+	CPPUNIT_ASSERT(std::isnan(empty.indices()[0]));
+}
+
+void test_moments2() {
+	/* Photon noise of constant flux is removed */
+	constexpr double mean = 1000;
+	std::mt19937 gen;
+	std::poisson_distribution<int> poisson{mean};
+	moments_type moments;
+
+	for (std::size_t k = 0; k < 200000; ++k) {
+		moments.add(sample_type{static_cast<double>(poisson(gen)), static_cast<double>(poisson(gen)),
+			static_cast<double>(poisson(gen)), static_cast<double>(poisson(gen))});
+	}
+
+	for (const auto index: moments.indices()) {
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, index, 2e-5);
+	}
+}
+
+void test_pipeline1() {
+	constexpr double exposure = 1e-3;
+	constexpr double dead_time = 20e-9;
+	constexpr std::size_t window = 1000;
+	const auto samples = make_samples(3500);
+
+	weif::photometric_pipeline<double> pipeline{window, exposure, dead_time, 256};
+	std::vector<moments_type::indices_type> actual;
+
+	const auto consume = [&actual] (const auto& indices) { actual.push_back(indices); };
+	std::atomic<bool> done{false};
+
+	std::thread producer([&] () {
+		for (const auto& s: samples) {
+			while (!pipeline.push(s)) {
+				std::this_thread::yield();
+			}
+		}
+
+		done.store(true, std::memory_order_release);
+	});
+
+	while (!done.load(std::memory_order_acquire)) {
+		pipeline.process(consume);
+		std::this_thread::yield();
+	}
+
+	producer.join();
+	pipeline.process(consume);
+
+	CPPUNIT_ASSERT_EQUAL(samples.size() / window, actual.size());
+	CPPUNIT_ASSERT_EQUAL(samples.size() % window, pipeline.moments().count());
+
+	for (std::size_t w = 0; w < actual.size(); ++w) {
+		const std::vector<sample_type> slice(samples.cbegin() + w * window, samples.cbegin() + (w + 1) * window);
+		const auto expected = reference(slice, dead_time / exposure);
+
+		for (std::size_t k = 0; k < expected.size(); ++k) {
+			CPPUNIT_ASSERT_DOUBLES_EQUAL(expected[k], actual[w][k], 1e-10 * std::abs(expected[k]));
+		}
+	}
+}
+
+void test_pipeline2() {
+	constexpr double exposure = 1e-3;
+	constexpr double dead_time = 20e-9;
+	constexpr std::size_t window = 10;
+	const auto samples = make_samples(35);
+
+	weif::photometric_pipeline<double> pipeline{window, exposure, dead_time, 64};
+	std::vector<moments_type::indices_type> actual;
+
+	for (const auto& s: samples) {
+		CPPUNIT_ASSERT(pipeline.push(s));
+	}
+
+	/* The window passed to the throwing callback is not accumulated again */
+	CPPUNIT_ASSERT_THROW(pipeline.process([] (const auto&) { throw std::runtime_error("process"); }), std::runtime_error);
+	CPPUNIT_ASSERT_EQUAL(std::size_t{0}, pipeline.moments().count());
+
+	CPPUNIT_ASSERT_EQUAL(std::size_t{2}, pipeline.process([&actual] (const auto& indices) { actual.push_back(indices); }));
+	CPPUNIT_ASSERT_EQUAL(samples.size() % window, pipeline.moments().count());
+
+	for (std::size_t w = 0; w < actual.size(); ++w) {
+		const std::vector<sample_type> slice(samples.cbegin() + (w + 1) * window, samples.cbegin() + (w + 2) * window);
+		const auto expected = reference(slice, dead_time / exposure);
+
+		for (std::size_t k = 0; k < expected.size(); ++k) {
+			CPPUNIT_ASSERT_DOUBLES_EQUAL(expected[k], actual[w][k], 1e-10 * std::abs(expected[k]));
+		}
+	}
+}
+
+void test_ring_buffer1() {
+	weif::detail::spsc_ring_buffer<int> buffer{6};
+
+	CPPUNIT_ASSERT_EQUAL(std::size_t{8}, buffer.capacity());
+
+	for (int i = 0; i < 8; ++i) {
+		CPPUNIT_ASSERT(buffer.try_push(i));
+	}
+	CPPUNIT_ASSERT(!buffer.try_push(8));
+
+	/* Elements processed before the exception are released */
+	std::vector<int> consumed;
+	CPPUNIT_ASSERT_THROW(buffer.consume([&consumed] (int value) {
+		if (value == 3)
+			throw std::runtime_error("consume");
+
+		consumed.push_back(value);
+	}), std::runtime_error);
+
+	CPPUNIT_ASSERT_EQUAL(std::size_t{3}, consumed.size());
+	CPPUNIT_ASSERT_EQUAL(std::size_t{5}, buffer.size());
+
+	consumed.clear();
+	CPPUNIT_ASSERT_EQUAL(std::size_t{5}, buffer.consume([&consumed] (int value) { consumed.push_back(value); }));
+	CPPUNIT_ASSERT_EQUAL(3, consumed.front());
+	CPPUNIT_ASSERT_EQUAL(std::size_t{0}, buffer.size());
+}
+
+};
+CPPUNIT_TEST_SUITE_REGISTRATION(test_photometric_moments_suite);
+
+int main(int argc, char **argv) {
+	CppUnit::TextUi::TestRunner runner;
+	CppUnit::TestFactoryRegistry &registry = CppUnit::TestFactoryRegistry::getRegistry();
+	runner.addTest(registry.makeTest());
+	return !runner.run("", false);
+}
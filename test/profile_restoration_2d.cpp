@@ -0,0 +1,104 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#include <cstddef>
+
+#include <cppunit/TestAssert.h>
+#include <cppunit/TestCase.h>
+#include <cppunit/Portability.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/ui/text/TestRunner.h>
+
+#include <xtensor/io/xio.hpp>
+#include <xtensor/containers/xarray.hpp> // IWYU pragma: keep
+#include <xtensor/containers/xtensor.hpp>
+#include <xtensor/generators/xbuilder.hpp>
+#include <xtensor/views/xview.hpp>
+
+#include <weif/af/circular.h>
+#include <weif/sf/mono.h>
+#include <weif/error.h>
+#include <weif/profile_restoration_2d.h>
+#include <weif/weight_function_grid_2d.h>
+
+#include "xexpression.h"
+
+
+class test_profile_restoration_2d_suite: public CppUnit::TestCase {
+CPPUNIT_TEST_SUITE(test_profile_restoration_2d_suite);
+CPPUNIT_TEST(test_restoration_2d1);
+CPPUNIT_TEST(test_restoration_2d2);
+CPPUNIT_TEST_SUITE_END();
+
+void test_restoration_2d1() {
+	using namespace weif;
+
+	constexpr double lambda = 550;
+	constexpr double aperture_scale = 10;
+	constexpr double delta = 1e-6;
+	const weight_function_grid_2d<double> wf(sf::mono<double>{}, lambda, af::circular<double>{}, aperture_scale, {7, 7});
+	const xt::xarray<double> altitudes = {0.5, 4.0, 16.0};
+	profile_restoration_2d<double> restoration(wf, altitudes);
+
+	const xt::xarray<double> profiles = {{1.0, 0.0, 2.0}, {1.5, 0.5, 2.0}, {0.0, 0.0, 0.0}};
+	xt::xtensor<double, 3> maps = xt::zeros<double>({3, 7, 7});
+	for (std::size_t i = 0; i < profiles.shape()[0]; ++i) {
+		for (std::size_t l = 0; l < altitudes.size(); ++l) {
+			xt::view(maps, i, xt::all(), xt::all()) += profiles(i, l) * wf(altitudes(l));
+		}
+	}
+
+	const auto actual = restoration.restore_stream(maps, 1e-12, 100000);
+	XT_ASSERT_XEXPRESSION_CLOSE(profiles, actual, delta, delta);
+
+	/* Negative covariance is restored as zero turbulence */
+	restoration.restore(-wf(4.0));
+	XT_ASSERT_XEXPRESSION_CLOSE(xt::zeros<double>({3}), restoration.profile(), 0.0);
+
+	CPPUNIT_ASSERT_THROW(restoration.restore(xt::zeros<double>({7, 5})), weif::mismatched_shape);
+}
+
+void test_restoration_2d2() {
+	using namespace weif;
+
+	constexpr double lambda = 550;
+	constexpr double aperture_scale = 10;
+	constexpr double delta = 1e-6;
+	const weight_function_grid_2d<double> wf(sf::mono<double>{}, lambda, af::circular<double>{}, aperture_scale, {5, 5});
+	const xt::xarray<double> altitudes = {1.0, 8.0};
+	const xt::xtensor<double, 2> mask = {
+		{0.0, 1.0, 1.0, 1.0, 1.0},
+		{1.0, 1.0, 1.0, 1.0, 1.0},
+		{1.0, 1.0, 1.0, 1.0, 0.0},
+		{1.0, 1.0, 1.0, 0.0, 0.0},
+		{1.0, 1.0, 0.0, 0.0, 0.0}};
+	const xt::xtensor<double, 2> weights = mask * profile_restoration_2d<double>::lag_multiplicity({5, 5});
+	profile_restoration_2d<double> restoration(wf, altitudes, weights);
+
+	XT_ASSERT_XEXPRESSION_CLOSE(xt::xtensor<double, 1>{1.0, 2.0, 2.0}, xt::view(profile_restoration_2d<double>::lag_multiplicity({3, 3}), 0, xt::all()), 0.0);
+	XT_ASSERT_XEXPRESSION_CLOSE(xt::xtensor<double, 1>{2.0, 4.0, 4.0}, xt::view(profile_restoration_2d<double>::lag_multiplicity({3, 3}), 1, xt::all()), 0.0);
+
+	/* Lags with zero weight do not affect the restoration */
+	xt::xtensor<double, 2> map = 0.7 * wf(1.0) + 1.3 * wf(8.0);
+	map(0, 0) = 100.0;
+	map(4, 4) = -100.0;
+
+	const xt::xarray<double> expected = {0.7, 1.3};
+	XT_ASSERT_XEXPRESSION_CLOSE(expected, restoration.restore(map, 1e-12, 100000), delta, delta);
+
+	CPPUNIT_ASSERT_THROW(profile_restoration_2d<double>(wf, altitudes, xt::ones<double>({3, 3})), weif::mismatched_shape);
+	CPPUNIT_ASSERT_THROW(profile_restoration_2d<double>(wf, altitudes, -weights), weif::error);
+}
+};
+CPPUNIT_TEST_SUITE_REGISTRATION(test_profile_restoration_2d_suite);
+
+int main(int argc, char **argv) {
+	CppUnit::TextUi::TestRunner runner;
+	CppUnit::TestFactoryRegistry &registry = CppUnit::TestFactoryRegistry::getRegistry();
+	runner.addTest(registry.makeTest());
+	return !runner.run("", false);
+}
@@ -0,0 +1,153 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#include <cmath>
+#include <limits>
+
+#include <boost/math/quadrature/exp_sinh.hpp>
+
+#include <cppunit/TestAssert.h>
+#include <cppunit/TestCase.h>
+#include <cppunit/Portability.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/ui/text/TestRunner.h>
+
+#include <xtensor/io/xio.hpp>
+#include <xtensor/containers/xarray.hpp> // IWYU pragma: keep
+
+#include <weif/af/circular.h>
+#include <weif/af/point.h>
+#include <weif/error.h>
+#include <weif/sf/mono.h>
+#include <weif/spectrum/von_karman.h>
+#include <weif/weight_function.h>
+
+#include "xexpression.h"
+
+
+class test_spectrum_suite: public CppUnit::TestCase {
+CPPUNIT_TEST_SUITE(test_spectrum_suite);
+CPPUNIT_TEST(test_von_karman1);
+CPPUNIT_TEST(test_von_karman2);
+CPPUNIT_TEST(test_von_karman3);
+CPPUNIT_TEST(test_von_karman4);
+CPPUNIT_TEST(test_von_karman5);
+CPPUNIT_TEST_SUITE_END();
+
+void test_von_karman1() {
+	using namespace weif;
+
+	constexpr double lambda = 550;
+	constexpr double aperture_scale = 10;
+	constexpr double outer_scale = 1000;
+	constexpr double delta = 0.0003;
+	const xt::xarray<double> args = {0.5, 1.0, 4.0, 16.0};
+	const weight_function<double> wf(sf::mono<double>{}, lambda, af::circular<double>{}, aperture_scale, spectrum::von_karman<double>{outer_scale}, 1024);
+	const xt::xarray<double> actual = wf(args);
+	const xt::xarray<double> expected = {
+		45825730496.26,
+		95383395463.44,
+		345803045524.3,
+		1089734915286.0
+	};
+
+	XT_ASSERT_XEXPRESSION_CLOSE(expected, actual, delta);
+}
+
+void test_von_karman2() {
+	using namespace weif;
+
+	constexpr double lambda = 550;
+	constexpr double aperture_scale = 10;
+	constexpr double inner_scale = 5;
+	constexpr double delta = 0.0003;
+	const xt::xarray<double> args = {0.5, 1.0, 4.0, 16.0};
+	const spectrum::von_karman<double> policy{std::numeric_limits<double>::infinity(), inner_scale};
+	const weight_function<double> wf(sf::mono<double>{}, lambda, af::circular<double>{}, aperture_scale, policy, 1024);
+	const xt::xarray<double> actual = wf(args);
+	const xt::xarray<double> expected = {
+		44724627869.02,
+		94566430139.25,
+		353900931097.9,
+		1192177130573.0
+	};
+
+	XT_ASSERT_XEXPRESSION_CLOSE(expected, actual, delta);
+}
+void test_von_karman3() {
+	using namespace weif;
+
+	constexpr double lambda = 550;
+	constexpr double aperture_scale = 10;
+	constexpr double outer_scale = 1e9;
+	constexpr double delta = 1e-8;
+	const xt::xarray<double> args = {0.5, 1.0, 4.0, 16.0};
+	const weight_function<double> wf(sf::mono<double>{}, lambda, af::circular<double>{}, aperture_scale, 1024);
+	const weight_function<double> wf_outer(sf::mono<double>{}, lambda, af::circular<double>{}, aperture_scale, spectrum::von_karman<double>{outer_scale}, 1024);
+
+	/* Large outer scale tends to the Kolmogorov spectrum */
+	XT_ASSERT_XEXPRESSION_CLOSE(wf(args), wf_outer(args), delta);
+}
+
+void test_von_karman4() {
+	using namespace weif;
+	using boost::math::quadrature::exp_sinh;
+
+	constexpr double lambda = 550;
+	constexpr double aperture_scale = 10;
+	constexpr double outer_scale = 1000;
+	constexpr double altitude = 4;
+	constexpr double delta = 1e-5;
+	const sf::mono<double> spectral_filter{};
+	const af::circular<double> aperture_filter{};
+	const weight_function<double> wf(spectral_filter, lambda, aperture_filter, aperture_scale, 1024);
+	const weight_function<double> wf_outer(spectral_filter, lambda, aperture_filter, aperture_scale, spectrum::von_karman<double>{outer_scale}, 1024);
+
+	/* Both weight functions share the normalization, so their ratio is
+	 * the ratio of the direct integrals over the spectra */
+	const double x = aperture_scale / std::sqrt(lambda * altitude);
+	const double outer = std::pow(aperture_scale / (x * outer_scale), 2);
+	const exp_sinh<double> integrator;
+	const auto integral = [&] (double s) {
+		return integrator.integrate([&] (double u) {
+			const double t = u * std::pow(u * u + s, -11.0 / 6);
+
+			if (!std::isfinite(t) || t == 0.0)
+				return 0.0;
+
+			return spectral_filter(u * u) * aperture_filter(x * u) * t;
+		});
+	};
+
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(integral(outer) / integral(0.0), wf_outer(altitude) / wf(altitude), delta);
+}
+
+void test_von_karman5() {
+	using namespace weif;
+
+	constexpr double lambda = 550;
+	constexpr double outer_scale = 1000;
+	constexpr double delta = 1e-12;
+	const xt::xarray<double> args = {0.5, 1.0, 4.0, 16.0};
+
+	/* The point aperture nodes do not depend on the scales of the spectrum */
+	CPPUNIT_ASSERT_THROW(weight_function<double>(sf::mono<double>{}, lambda, af::point<double>{}, 0.0, spectrum::von_karman<double>{outer_scale}, 1024), weif::error);
+	CPPUNIT_ASSERT_THROW(weight_function<double>(sf::mono<double>{}, lambda, af::point<double>{}, 0.0, spectrum::von_karman<double>{std::numeric_limits<double>::infinity(), 1.0}, 1024), weif::error);
+
+	const weight_function<double> wf(sf::mono<double>{}, lambda, af::point<double>{}, 0.0, 1024);
+	const weight_function<double> wf_inf(sf::mono<double>{}, lambda, af::point<double>{}, 0.0, spectrum::von_karman<double>{}, 1024);
+	XT_ASSERT_XEXPRESSION_CLOSE(wf(args), wf_inf(args), delta);
+}
+};
+CPPUNIT_TEST_SUITE_REGISTRATION(test_spectrum_suite);
+
+int main(int argc, char **argv) {
+	CppUnit::TextUi::TestRunner runner;
+	CppUnit::TestFactoryRegistry &registry = CppUnit::TestFactoryRegistry::getRegistry();
+	runner.addTest(registry.makeTest());
+	return !runner.run("", false);
+}
@@ -4,7 +4,9 @@
  * Copyright (C) 2012-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
  */
 
+#include <cmath>
 #include <limits>
+#include <memory>
 
 #include <cppunit/TestAssert.h>
 #include <cppunit/TestCase.h>
@@ -16,12 +18,16 @@
 #include <xtensor/io/xio.hpp>
 #include <xtensor/containers/xarray.hpp> // IWYU pragma: keep
 
+#include <weif/af/angle_averaged.h>
 #include <weif/af/point.h>
 #include <weif/af/circular.h>
 #include <weif/af/gauss.h>
+#include <weif/af/wind_smoothed.h>
 #include <weif/sf/mono.h>
 #include <weif/sf/gauss.h>
 #include <weif/detail/weight_function_base.h>
+#include <weif/error.h>
+#include <weif/progress_token.h>
 #include <weif/weight_function.h>
 
 #include "xexpression.h"
@@ -35,6 +41,10 @@ CPPUNIT_TEST(test_mono_gauss_vec1);
 CPPUNIT_TEST(test_gauss_point_vec1);
 CPPUNIT_TEST(test_gauss_point_vec2);
 CPPUNIT_TEST(test_gauss_point_vec3);
+CPPUNIT_TEST(test_mono_circular_series1);
+CPPUNIT_TEST(test_mono_annular_series1);
+CPPUNIT_TEST(test_moment_series1);
+CPPUNIT_TEST(test_moment_series2);
 CPPUNIT_TEST_SUITE_END();
 
 void test_mono_point_vec1() {
@@ -137,6 +147,76 @@ void test_gauss_point_vec3() {
 	XT_ASSERT_XEXPRESSION_CLOSE(expected, actual, delta);
 }
 
+void test_mono_circular_series1() {
+	using namespace weif;
+	using namespace weif::detail;
+
+	constexpr double delta = 1e-13;
+	const xt::xarray<double> expected = {
+		0.0,
+		0.18275258941523022772990138044815375061858,
+		0.44924254632329663701006876363839208048182,
+		0.86287430440237028413258369255107941758679,
+		1.2614994482444274348527859556314005305702,
+		1.5739245403642390458147778288821298254394,
+		1.7957566887471521401764802750648900234123,
+		1.9370991581536685585369784254993146893821,
+		1.9991032874390479724456646360827626800501
+	};
+	const xt::xarray<double> args = {0.0, 0.3, 0.4, 0.5, 0.6, 0.7, 0.8, 0.9, 1.0};
+	xt::xarray<double> actual = dimensionless_weight_function(sf::mono<double>{}, af::circular<double>{}, args);
+
+	XT_ASSERT_XEXPRESSION_CLOSE(expected, actual, delta);
+}
+
+void test_mono_annular_series1() {
+	using namespace weif;
+	using namespace weif::detail;
+
+	constexpr double delta = 1e-6;
+	const af::annular<double> aperture_filter{0.5};
+	const xt::xarray<double> args = {0.01, 0.3, 0.5, 0.7};
+	/* The wrapper has no analytic evaluation, so the quadrature is used */
+	xt::xarray<double> expected = dimensionless_weight_function(sf::mono<double>{}, [aperture_filter] (double u) {
+		return aperture_filter(u);
+	}, args);
+	xt::xarray<double> actual = dimensionless_weight_function(sf::mono<double>{}, aperture_filter, args);
+
+	XT_ASSERT_XEXPRESSION_CLOSE(expected, actual, delta);
+}
+
+void test_moment_series1() {
+	using namespace weif;
+	using namespace weif::detail;
+
+	constexpr double delta = 1e-5;
+	const af::gauss<double> aperture_filter;
+	const xt::xarray<double> args = {0.005, 0.01, 0.98, 0.99, 0.999};
+	/* The wrapper has no moments, so the quadrature is used */
+	xt::xarray<double> expected = dimensionless_weight_function(sf::mono<double>{}, [aperture_filter] (double u) {
+		return aperture_filter(u);
+	}, args);
+	xt::xarray<double> actual = dimensionless_weight_function(sf::mono<double>{}, aperture_filter, args);
+
+	XT_ASSERT_XEXPRESSION_CLOSE(expected, actual, delta);
+}
+
+void test_moment_series2() {
+	using namespace weif;
+	using namespace weif::detail;
+
+	constexpr double delta = 1e-5;
+	const sf::gauss<double> spectral_filter{0.5};
+	const xt::xarray<double> args = {0.005, 0.01, 0.99, 0.999};
+	/* The wrapper has no moments, so the quadrature is used */
+	xt::xarray<double> expected = dimensionless_weight_function([spectral_filter] (double x) {
+		return spectral_filter(x);
+	}, af::circular<double>{}, args);
+	xt::xarray<double> actual = dimensionless_weight_function(spectral_filter, af::circular<double>{}, args);
+
+	XT_ASSERT_XEXPRESSION_CLOSE(expected, actual, delta);
+}
+
 };
 CPPUNIT_TEST_SUITE_REGISTRATION(test_dimensionless_weight_function_suite);
 
@@ -261,6 +341,10 @@ CPPUNIT_TEST(test_mono_gauss_vec1);
 CPPUNIT_TEST(test_gauss_point_vec1);
 CPPUNIT_TEST(test_gauss_point_vec2);
 CPPUNIT_TEST(test_gauss_point_vec3);
+CPPUNIT_TEST(test_wind_smoothed1);
+CPPUNIT_TEST(test_statistics1);
+CPPUNIT_TEST(test_progress1);
+CPPUNIT_TEST_EXCEPTION(test_cancelled1, weif::cancelled);
 CPPUNIT_TEST_SUITE_END();
 
 void test_mono_point_vec1() {
@@ -407,7 +491,74 @@ void test_gauss_point_vec3() {
 	XT_ASSERT_XEXPRESSION_CLOSE(expected, actual, delta);
 }
 
+void test_wind_smoothed1() {
+	using namespace weif;
 
+	constexpr double lambda = 550;
+	constexpr double aperture_scale = 10;
+	constexpr double shift = 0.5;
+	constexpr double delta = 0.0003;
+	const xt::xarray<double> args = {0.5, 1.0, 2.0, 4.0, 8.0, 16.0, 32.0};
+	const af::wind_smoothed smoothed{af::circular<double>{}, shift};
+	/* The closed form of the direction average against the angular quadrature */
+	const weight_function<double> wf(sf::mono<double>{}, lambda, smoothed, aperture_scale, 1024);
+	const weight_function<double> expected(sf::mono<double>{}, lambda, af::angle_averaged<double>{smoothed, 8192}, aperture_scale, 1024);
+
+	XT_ASSERT_XEXPRESSION_CLOSE(expected(args), wf(args), delta);
+}
+
+void test_statistics1() {
+	using namespace weif;
+
+	constexpr double lambda = 550;
+	constexpr double aperture_scale = 10;
+	constexpr std::size_t size = 1024;
+	const xt::xarray<double> args = {0.0, 0.5, 1.0, 2.0, 4.0, 8.0, 16.0, 32.0};
+	const auto stats = std::make_shared<quadrature_statistics<double>>();
+	const weight_function<double> expected(sf::mono<double>{}, lambda, af::circular<double>{}, aperture_scale, size);
+	const weight_function<double> actual(sf::mono<double>{}, lambda, af::circular<double>{}, aperture_scale, size, stats);
+
+	CPPUNIT_ASSERT(expected.statistics() == nullptr);
+	CPPUNIT_ASSERT(actual.statistics() == stats);
+	CPPUNIT_ASSERT_EQUAL(size, stats->size());
+
+	/* Both the series and the quadrature are used for sf::mono and af::circular */
+	const auto records = stats->records();
+	const auto quadrature_size = size - stats->analytic_size();
+	CPPUNIT_ASSERT(stats->analytic_size() > 0);
+	CPPUNIT_ASSERT(quadrature_size > 0);
+	CPPUNIT_ASSERT(stats->total_evaluations() > quadrature_size);
+	for (const auto& r: records) {
+		CPPUNIT_ASSERT(r.analytic ? r.evaluations == 0 : r.evaluations > 0 && r.terms == 0);
+	}
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, stats->records().front().node, std::numeric_limits<double>::epsilon());
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, stats->records().back().node, std::numeric_limits<double>::epsilon());
+	XT_ASSERT_XEXPRESSION_CLOSE(expected(args), actual(args), 0.0);
+}
+
+void test_progress1() {
+	using namespace weif;
+
+	constexpr double lambda = 550;
+	constexpr double aperture_scale = 10;
+	constexpr std::size_t size = 1024;
+	progress_token progress;
+	const weight_function<double> wf(sf::mono<double>{}, lambda, af::circular<double>{}, aperture_scale, size, nullptr, &progress);
+
+	CPPUNIT_ASSERT_EQUAL(size, progress.total());
+	CPPUNIT_ASSERT_EQUAL(size, progress.completed());
+}
+
+void test_cancelled1() {
+	using namespace weif;
+
+	constexpr double lambda = 550;
+	constexpr double aperture_scale = 10;
+	progress_token progress;
+	progress.cancel();
+
+	const weight_function<double> wf(sf::mono<double>{}, lambda, af::circular<double>{}, aperture_scale, 1024, nullptr, &progress);
+}
 };
 CPPUNIT_TEST_SUITE_REGISTRATION(test_weight_function_suite);
 
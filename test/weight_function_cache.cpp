@@ -0,0 +1,76 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#include <cppunit/TestAssert.h>
+#include <cppunit/TestCase.h>
+#include <cppunit/Portability.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/ui/text/TestRunner.h>
+
+#include <xtensor/io/xio.hpp>
+#include <xtensor/containers/xarray.hpp> // IWYU pragma: keep
+
+#include <weif/af/circular.h>
+#include <weif/af/point.h>
+#include <weif/error.h>
+#include <weif/sf/mono.h>
+#include <weif/spectrum/von_karman.h>
+#include <weif/weight_function.h>
+#include <weif/weight_function_cache.h>
+
+#include "xexpression.h"
+
+
+class test_weight_function_cache_suite: public CppUnit::TestCase {
+CPPUNIT_TEST_SUITE(test_weight_function_cache_suite);
+CPPUNIT_TEST(test_cache1);
+CPPUNIT_TEST(test_cache2);
+CPPUNIT_TEST_SUITE_END();
+
+void test_cache1() {
+	using namespace weif;
+
+	constexpr double lambda = 550;
+	constexpr double aperture_scale = 10;
+	constexpr double outer_scale = 1000;
+	constexpr double delta = 1e-12;
+	const xt::xarray<double> args = {0.5, 1.0, 4.0, 16.0};
+	const weight_function_cache<double> cache(sf::mono<double>{}, af::circular<double>{}, 1024);
+	const weight_function<double> wf(sf::mono<double>{}, lambda, af::circular<double>{}, aperture_scale, spectrum::von_karman<double>{outer_scale}, 1024);
+
+	const xt::xarray<double> expected = wf(args);
+	const xt::xarray<double> actual = cache(lambda, aperture_scale, spectrum::von_karman<double>{outer_scale})(args);
+	CPPUNIT_ASSERT_EQUAL(std::size_t{1}, cache.size());
+	XT_ASSERT_XEXPRESSION_CLOSE(expected, actual, delta);
+
+	cache(2 * lambda, aperture_scale, spectrum::von_karman<double>{outer_scale});
+	cache(lambda, 2 * aperture_scale, spectrum::von_karman<double>{2 * outer_scale});
+	CPPUNIT_ASSERT_EQUAL(std::size_t{1}, cache.size());
+
+	cache(lambda, aperture_scale, spectrum::von_karman<double>{2 * outer_scale});
+	CPPUNIT_ASSERT_EQUAL(std::size_t{2}, cache.size());
+}
+
+void test_cache2() {
+	using namespace weif;
+
+	constexpr double lambda = 550;
+	constexpr double outer_scale = 1000;
+	const weight_function_cache<double> cache(sf::mono<double>{}, af::point<double>{}, 1024);
+
+	CPPUNIT_ASSERT_THROW(cache(lambda, 0.0, spectrum::von_karman<double>{outer_scale}), weif::error);
+	CPPUNIT_ASSERT_EQUAL(std::size_t{0}, cache.size());
+}
+};
+CPPUNIT_TEST_SUITE_REGISTRATION(test_weight_function_cache_suite);
+
+int main(int argc, char **argv) {
+	CppUnit::TextUi::TestRunner runner;
+	CppUnit::TestFactoryRegistry &registry = CppUnit::TestFactoryRegistry::getRegistry();
+	runner.addTest(registry.makeTest());
+	return !runner.run("", false);
+}
@@ -0,0 +1,125 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#include <cstddef>
+
+#include <cppunit/TestAssert.h>
+#include <cppunit/TestCase.h>
+#include <cppunit/Portability.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/ui/text/TestRunner.h>
+
+#include <xtensor/io/xio.hpp>
+#include <xtensor/containers/xarray.hpp> // IWYU pragma: keep
+#include <xtensor/generators/xbuilder.hpp>
+
+#include <weif/af/circular.h>
+#include <weif/af/point.h>
+#include <weif/sf/mono.h>
+#include <weif/spectrum/von_karman.h>
+#include <weif/weight_function.h>
+#include <weif/weight_function_covariance.h>
+
+#include "xexpression.h"
+
+
+class test_weight_function_covariance_suite: public CppUnit::TestCase {
+CPPUNIT_TEST_SUITE(test_weight_function_covariance_suite);
+CPPUNIT_TEST(test_covariance1);
+CPPUNIT_TEST(test_covariance2);
+CPPUNIT_TEST(test_covariance3);
+CPPUNIT_TEST(test_covariance4);
+CPPUNIT_TEST_SUITE_END();
+
+void test_covariance1() {
+	using namespace weif;
+
+	constexpr double lambda = 550;
+	constexpr double aperture_scale = 10;
+	constexpr double delta = 0.0003;
+	const xt::xarray<double> args = {0.5, 1.0, 2.0, 4.0, 8.0, 16.0, 32.0};
+	const weight_function<double> wf(sf::mono<double>{}, lambda, af::circular<double>{}, aperture_scale, 1024);
+	const weight_function_covariance<double> cov(sf::mono<double>{}, lambda, af::circular<double>{}, aperture_scale);
+	const xt::xarray<double> expected = wf(args);
+	xt::xarray<double> actual = xt::zeros_like(args);
+
+	for (std::size_t i = 0; i < args.size(); ++i) {
+		actual(i) = cov(args(i), xt::xarray<double>{0.0})(0);
+	}
+
+	XT_ASSERT_XEXPRESSION_CLOSE(expected, actual, delta);
+}
+
+void test_covariance2() {
+	using namespace weif;
+
+	/* Fresnel radius is equal to the aperture scale, so separations are $\{0, 0.3, 1\}$ in dimensionless units */
+	constexpr double lambda = 550;
+	constexpr double aperture_scale = 10;
+	constexpr double altitude = aperture_scale * aperture_scale / lambda;
+	constexpr double delta = 0.0003;
+	constexpr double c = 0.86287430440237028413258369255107941758679;
+	const xt::xarray<double> args = {0.0, 3.0, 10.0};
+	const weight_function<double> wf(sf::mono<double>{}, lambda, af::circular<double>{}, aperture_scale, 1024);
+	const weight_function_covariance<double> cov(sf::mono<double>{}, lambda, af::circular<double>{}, aperture_scale);
+	const xt::xarray<double> expected = xt::xarray<double>{c, 0.710905365041, 0.018282949522} * (wf(altitude) / c);
+	const xt::xarray<double> actual = cov(altitude, args);
+
+	XT_ASSERT_XEXPRESSION_CLOSE(expected, actual, delta);
+}
+
+void test_covariance3() {
+	using namespace weif;
+
+	constexpr double lambda = 550;
+	constexpr double aperture_scale = 10;
+	constexpr double outer_scale = 1000;
+	constexpr double delta = 0.0003;
+	const xt::xarray<double> args = {0.5, 1.0, 4.0, 16.0};
+	const weight_function<double> wf(sf::mono<double>{}, lambda, af::circular<double>{}, aperture_scale, spectrum::von_karman<double>{outer_scale}, 1024);
+	const weight_function_covariance<double> cov(sf::mono<double>{}, lambda, af::circular<double>{}, aperture_scale, spectrum::von_karman<double>{outer_scale});
+	const xt::xarray<double> expected = wf(args);
+	xt::xarray<double> actual = xt::zeros_like(args);
+
+	for (std::size_t i = 0; i < args.size(); ++i) {
+		actual(i) = cov(args(i), xt::xarray<double>{0.0})(0);
+	}
+
+	XT_ASSERT_XEXPRESSION_CLOSE(expected, actual, delta);
+}
+
+void test_covariance4() {
+	using namespace weif;
+
+	constexpr double lambda = 550;
+	constexpr double outer_scale = 1000;
+	constexpr double delta = 0.0003;
+	const xt::xarray<double> args = {0.5, 1.0, 4.0, 16.0};
+	const spectrum::von_karman<double> spectrum{outer_scale};
+
+	/* Point aperture is the limit of vanishing aperture scale */
+	const weight_function_covariance<double> cov(sf::mono<double>{}, lambda, af::point<double>{}, 0.0, spectrum);
+	const weight_function_covariance<double> cov_small(sf::mono<double>{}, lambda, af::circular<double>{}, 1e-3, spectrum);
+	xt::xarray<double> expected = xt::zeros_like(args);
+	xt::xarray<double> actual = xt::zeros_like(args);
+
+	for (std::size_t i = 0; i < args.size(); ++i) {
+		expected(i) = cov_small(args(i), xt::xarray<double>{10.0})(0);
+		actual(i) = cov(args(i), xt::xarray<double>{10.0})(0);
+	}
+
+	XT_ASSERT_XEXPRESSION_CLOSE(expected, actual, delta);
+}
+};
+CPPUNIT_TEST_SUITE_REGISTRATION(test_weight_function_covariance_suite);
+
+int main(int argc, char **argv) {
+	CppUnit::TextUi::TestRunner runner;
+	CppUnit::TestFactoryRegistry &registry = CppUnit::TestFactoryRegistry::getRegistry();
+	runner.addTest(registry.makeTest());
+	return !runner.run("", false);
+}
@@ -0,0 +1,180 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#include <cmath>
+#include <cstddef>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <cppunit/TestAssert.h>
+#include <cppunit/TestCase.h>
+#include <cppunit/Portability.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/ui/text/TestRunner.h>
+
+#include <xtensor/io/xio.hpp>
+#include <xtensor/containers/xarray.hpp> // IWYU pragma: keep
+#include <xtensor/containers/xtensor.hpp>
+#include <xtensor/core/xmath.hpp>
+
+#include <weif/af/circular.h>
+#include <weif/af/point.h>
+#include <weif/sf/mono.h>
+#include <weif/spectrum/von_karman.h>
+#include <weif/weight_function_grid_2d.h>
+
+#include "xexpression.h"
+
+
+class test_weight_function_grid_2d_suite: public CppUnit::TestCase {
+CPPUNIT_TEST_SUITE(test_weight_function_grid_2d_suite);
+CPPUNIT_TEST(test_grid_2d_baselines1);
+CPPUNIT_TEST(test_grid_2d_baselines2);
+CPPUNIT_TEST(test_grid_2d_baselines3);
+CPPUNIT_TEST(test_grid_2d_von_karman1);
+CPPUNIT_TEST(test_grid_2d_von_karman2);
+CPPUNIT_TEST_SUITE_END();
+
+void test_grid_2d_baselines1() {
+	using namespace weif;
+
+	constexpr double lambda = 550;
+	constexpr double aperture_scale = 10;
+	constexpr double altitude = 5;
+	constexpr double delta = 1e-9;
+	const weight_function_grid_2d<double> wf(sf::mono<double>{}, lambda, af::circular<double>{}, aperture_scale, {9, 7});
+	const auto grid = wf(altitude);
+	const xt::xarray<double> expected = {grid(0, 0), grid(1, 0), grid(2, 3), grid(8, 6), grid(2, 3)};
+	const xt::xarray<double> baselines = {{0.0, 0.0}, {10.0, 0.0}, {20.0, 30.0}, {80.0, 60.0}, {-20.0, 30.0}};
+	const xt::xarray<double> actual = wf(altitude, baselines);
+
+	XT_ASSERT_XEXPRESSION_CLOSE(expected, actual, delta);
+}
+
+void test_grid_2d_baselines2() {
+	using namespace weif;
+
+	constexpr double lambda = 550;
+	constexpr double aperture_scale = 10;
+	constexpr double altitude = 5;
+	constexpr double delta = 1e-9;
+	constexpr double PI = xt::numeric_constants<double>::PI;
+	const weight_function_grid_2d<double> wf(sf::mono<double>{}, lambda, af::circular<double>{}, aperture_scale, {9, 7});
+	const xt::xtensor<double, 2> grid = wf(altitude);
+	const std::size_t n0 = grid.shape()[0];
+	const std::size_t n1 = grid.shape()[1];
+
+	/* The lattice is the REDFT00 of the spectrum samples, so the samples
+	 * are recovered by the inverse transform, and the discretized integral
+	 * is summed directly at arbitrary offsets. */
+	const auto weight = [] (std::size_t j, std::size_t n) {
+		return (j == 0 || j == n - 1 ? 1.0 : 2.0);
+	};
+	const auto cosine_sum = [&weight, n0, n1] (const xt::xtensor<double, 2>& x, double p0, double p1) {
+		double ret = 0;
+
+		for (std::size_t j = 0; j < n0; ++j) {
+			for (std::size_t k = 0; k < n1; ++k) {
+				ret += weight(j, n0) * weight(k, n1) * x(j, k)
+					* std::cos(PI * j * p0 / (n0 - 1)) * std::cos(PI * k * p1 / (n1 - 1));
+			}
+		}
+
+		return ret;
+	};
+
+	xt::xtensor<double, 2> samples = xt::zeros<double>({n0, n1});
+	for (std::size_t j = 0; j < n0; ++j) {
+		for (std::size_t k = 0; k < n1; ++k) {
+			samples(j, k) = cosine_sum(grid, j, k) / (4 * (n0 - 1) * (n1 - 1));
+		}
+	}
+
+	const xt::xtensor<double, 2> baselines = {{13.7, -4.2}, {-3.1, 27.5}, {0.0, 11.3}, {55.5, 0.0}, {71.9, 48.8}};
+	const auto actual = wf(altitude, baselines);
+	const double scale = xt::amax(xt::abs(grid))();
+
+	for (std::size_t i = 0; i < baselines.shape()[0]; ++i) {
+		const auto expected = cosine_sum(samples, std::abs(baselines(i, 0)) / aperture_scale, std::abs(baselines(i, 1)) / aperture_scale);
+
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(expected, actual(i), delta * scale);
+	}
+}
+
+void test_grid_2d_baselines3() {
+	using namespace weif;
+
+	constexpr double lambda = 550;
+	constexpr double aperture_scale = 10;
+	constexpr double altitude = 5;
+	constexpr std::size_t threads = 4;
+	const weight_function_grid_2d<double> expected(sf::mono<double>{}, lambda, af::circular<double>{}, aperture_scale, {9, 7});
+	weight_function_grid_2d<double> source(sf::mono<double>{}, lambda, af::circular<double>{}, aperture_scale, {9, 7});
+	const weight_function_grid_2d<double> wf(std::move(source));
+	const xt::xarray<double> baselines = {{0.0, 0.0}, {5.5, 3.25}, {17.0, 41.5}, {73.0, 12.0}};
+
+	/* Concurrent first off-lattice calls build the NUFFT plan once */
+	std::vector<xt::xarray<double>> actual(threads);
+	std::vector<std::thread> workers;
+	for (std::size_t i = 0; i < threads; ++i) {
+		workers.emplace_back([&wf, &baselines, &actual, i] () {
+			actual[i] = wf(altitude, baselines);
+		});
+	}
+	for (auto& w: workers) {
+		w.join();
+	}
+
+	const xt::xarray<double> values = expected(altitude, baselines);
+	for (const auto& a: actual) {
+		XT_ASSERT_XEXPRESSION_CLOSE(values, a, 0.0, 0.0);
+	}
+}
+
+void test_grid_2d_von_karman1() {
+	using namespace weif;
+
+	constexpr double lambda = 550;
+	constexpr double aperture_scale = 10;
+	constexpr double altitude = 5;
+	constexpr double delta = 1e-12;
+	const weight_function_grid_2d<double> wf(sf::mono<double>{}, lambda, af::circular<double>{}, aperture_scale, {9, 7});
+	const weight_function_grid_2d<double> wf_inf(sf::mono<double>{}, lambda, af::circular<double>{}, aperture_scale, spectrum::von_karman<double>{}, aperture_scale, {9, 7});
+	const weight_function_grid_2d<double> wf_outer(sf::mono<double>{}, lambda, af::circular<double>{}, aperture_scale, spectrum::von_karman<double>{1000}, aperture_scale, {9, 7});
+
+	XT_ASSERT_XEXPRESSION_CLOSE(wf(altitude), wf_inf(altitude), delta);
+	CPPUNIT_ASSERT(wf_outer(altitude)(0, 0) < wf(altitude)(0, 0));
+}
+
+void test_grid_2d_von_karman2() {
+	using namespace weif;
+
+	constexpr double lambda = 550;
+	constexpr double grid_step = 10;
+	constexpr double altitude = 5;
+	constexpr double delta = 1e-6;
+	const spectrum::von_karman<double> spectrum{1000};
+
+	/* Point aperture is the limit of vanishing aperture scale, the spectrum is scaled by the grid step */
+	const weight_function_grid_2d<double> wf(sf::mono<double>{}, lambda, af::point<double>{}, 0.0, spectrum, grid_step, {9, 7});
+	const weight_function_grid_2d<double> wf_small(sf::mono<double>{}, lambda, af::circular<double>{}, 1e-3, spectrum, grid_step, {9, 7});
+	const weight_function_grid_2d<double> wf_kolmogorov(sf::mono<double>{}, lambda, af::point<double>{}, 0.0, grid_step, {9, 7});
+
+	XT_ASSERT_XEXPRESSION_CLOSE(wf_small(altitude), wf(altitude), delta);
+	CPPUNIT_ASSERT(wf(altitude)(0, 0) > 0.0);
+	CPPUNIT_ASSERT(wf(altitude)(0, 0) < wf_kolmogorov(altitude)(0, 0));
+}
+};
+CPPUNIT_TEST_SUITE_REGISTRATION(test_weight_function_grid_2d_suite);
+
+int main(int argc, char **argv) {
+	CppUnit::TextUi::TestRunner runner;
+	CppUnit::TestFactoryRegistry &registry = CppUnit::TestFactoryRegistry::getRegistry();
+	runner.addTest(registry.makeTest());
+	return !runner.run("", false);
+}
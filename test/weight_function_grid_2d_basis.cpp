@@ -0,0 +1,85 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#include <cstddef>
+
+#include <cppunit/TestAssert.h>
+#include <cppunit/TestCase.h>
+#include <cppunit/Portability.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/ui/text/TestRunner.h>
+
+#include <xtensor/io/xio.hpp>
+#include <xtensor/containers/xtensor.hpp>
+#include <xtensor/core/xmath.hpp>
+#include <xtensor/generators/xbuilder.hpp>
+#include <xtensor/misc/xmanipulation.hpp>
+#include <xtensor/views/xview.hpp>
+
+#include <weif/af/circular.h>
+#include <weif/sf/mono.h>
+#include <weif/detail/linalg.h>
+#include <weif/error.h>
+#include <weif/weight_function_grid_2d.h>
+#include <weif/weight_function_grid_2d_basis.h>
+
+#include "xexpression.h"
+
+
+class test_weight_function_grid_2d_basis_suite: public CppUnit::TestCase {
+CPPUNIT_TEST_SUITE(test_weight_function_grid_2d_basis_suite);
+CPPUNIT_TEST(test_grid_2d_basis1);
+CPPUNIT_TEST(test_grid_2d_basis2);
+CPPUNIT_TEST_SUITE_END();
+
+void test_grid_2d_basis1() {
+	using namespace weif;
+
+	constexpr double lambda = 550;
+	constexpr double aperture_scale = 10;
+	const weight_function_grid_2d<double> wf(sf::mono<double>{}, lambda, af::circular<double>{}, aperture_scale, {5, 5});
+	const weight_function_grid_2d_basis<double> basis(wf, 0.5, 20.0, 65, 25);
+
+	CPPUNIT_ASSERT_EQUAL(std::size_t{25}, basis.rank());
+	CPPUNIT_ASSERT(basis.truncation_error() < 1e-6);
+	CPPUNIT_ASSERT_THROW(basis(0.1), weif::altitude_out_of_range);
+
+	for (const double altitude: {0.5, 0.7, 3.3, 12.1, 20.0}) {
+		const auto expected = wf(altitude);
+
+		XT_ASSERT_XEXPRESSION_CLOSE(expected, basis(altitude), 0.0, 1e-5 * xt::amax(xt::abs(expected))());
+		XT_ASSERT_XEXPRESSION_CLOSE(basis.coefficients(altitude), basis.project(expected), 0.0, 1e-5 * xt::amax(xt::abs(expected))());
+	}
+}
+
+void test_grid_2d_basis2() {
+	using namespace weif;
+
+	constexpr double lambda = 550;
+	constexpr double aperture_scale = 10;
+	const weight_function_grid_2d<double> wf(sf::mono<double>{}, lambda, af::circular<double>{}, aperture_scale, {5, 5});
+	const weight_function_grid_2d_basis<double> basis2(wf, 0.5, 20.0, 33, 2);
+	const weight_function_grid_2d_basis<double> basis4(wf, 0.5, 20.0, 33, 4);
+
+	CPPUNIT_ASSERT_EQUAL(std::size_t{2}, basis2.rank());
+	CPPUNIT_ASSERT(basis2.truncation_error() >= 0.0);
+	CPPUNIT_ASSERT(basis4.truncation_error() <= basis2.truncation_error());
+	XT_ASSERT_XEXPRESSION_CLOSE(xt::view(basis4.singular_values(), xt::range(0, 2)), basis2.singular_values(), 1e-8);
+
+	/* The lag modes are orthonormal */
+	const auto gram = weif::detail::multiply(basis4.modes(), xt::eval(xt::transpose(basis4.modes())));
+	XT_ASSERT_XEXPRESSION_CLOSE(xt::eye<double>(4), gram, 0.0, 1e-10);
+}
+};
+CPPUNIT_TEST_SUITE_REGISTRATION(test_weight_function_grid_2d_basis_suite);
+
+int main(int argc, char **argv) {
+	CppUnit::TextUi::TestRunner runner;
+	CppUnit::TestFactoryRegistry &registry = CppUnit::TestFactoryRegistry::getRegistry();
+	runner.addTest(registry.makeTest());
+	return !runner.run("", false);
+}
@@ -0,0 +1,166 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include <cppunit/TestAssert.h>
+#include <cppunit/TestCase.h>
+#include <cppunit/Portability.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/ui/text/TestRunner.h>
+
+#include <xtensor/io/xio.hpp>
+#include <xtensor/containers/xtensor.hpp>
+#include <xtensor/core/xmath.hpp>
+
+#include <weif/af/circular.h>
+#include <weif/sf/mono.h>
+#include <weif/error.h>
+#include <weif/weight_function_grid_2d.h>
+#include <weif/weight_function_grid_2d_table.h>
+
+#include "xexpression.h"
+
+
+class test_weight_function_grid_2d_table_suite: public CppUnit::TestCase {
+CPPUNIT_TEST_SUITE(test_weight_function_grid_2d_table_suite);
+CPPUNIT_TEST(test_grid_2d_table1);
+CPPUNIT_TEST(test_grid_2d_table2);
+CPPUNIT_TEST(test_grid_2d_table3);
+CPPUNIT_TEST(test_grid_2d_table4);
+CPPUNIT_TEST(test_grid_2d_table5);
+CPPUNIT_TEST_SUITE_END();
+
+void test_grid_2d_table1() {
+	using namespace weif;
+
+	constexpr double lambda = 550;
+	constexpr double aperture_scale = 10;
+	constexpr double tolerance = 1e-6;
+	const weight_function_grid_2d<double> wf(sf::mono<double>{}, lambda, af::circular<double>{}, aperture_scale, {5, 5});
+	const weight_function_grid_2d_table<double> table(wf, 0.5, 20.0, tolerance);
+
+	CPPUNIT_ASSERT(table.estimated_error() <= tolerance);
+	CPPUNIT_ASSERT_THROW(table(0.1), weif::altitude_out_of_range);
+
+	for (const double altitude: {0.5, 0.7, 3.3, 12.1, 20.0}) {
+		const auto expected = wf(altitude);
+		const auto actual = table(altitude);
+
+		XT_ASSERT_XEXPRESSION_CLOSE(expected, actual, 0.0, 10 * tolerance * xt::amax(xt::abs(expected))());
+	}
+}
+
+void test_grid_2d_table2() {
+	using namespace weif;
+
+	constexpr double lambda = 550;
+	constexpr double aperture_scale = 10;
+	const auto filename = (std::filesystem::temp_directory_path() / "weif_test_grid_2d_table2.bin").string();
+	const weight_function_grid_2d_table<double> table(sf::mono<double>{}, lambda, af::circular<double>{}, aperture_scale, aperture_scale, {5, 3}, 1.0, 10.0, 1e-4);
+
+	table.save(filename);
+	const auto loaded = weight_function_grid_2d_table<double>::load(filename);
+	CPPUNIT_ASSERT_THROW(weight_function_grid_2d_table<float>::load(filename), weif::error);
+	std::remove(filename.c_str());
+
+	CPPUNIT_ASSERT_EQUAL(table.size(), loaded.size());
+	CPPUNIT_ASSERT(table.shape() == loaded.shape());
+
+	for (const double altitude: {1.0, 2.5, 10.0}) {
+		XT_ASSERT_XEXPRESSION_CLOSE(table(altitude), loaded(altitude), 0.0);
+	}
+}
+
+void test_grid_2d_table3() {
+	using namespace weif;
+
+	constexpr long double lambda = 550;
+	constexpr long double aperture_scale = 10;
+	const auto filename = (std::filesystem::temp_directory_path() / "weif_test_grid_2d_table3.bin").string();
+	const weight_function_grid_2d_table<long double> table(sf::mono<long double>{}, lambda, af::circular<long double>{}, aperture_scale, aperture_scale,
+		{3, 3}, 1.0L, 10.0L, 1e-4L);
+
+	/* Long double table is stored natively and does not lose precision */
+	table.save(filename);
+	const auto loaded = weight_function_grid_2d_table<long double>::load(filename);
+	CPPUNIT_ASSERT_THROW(weight_function_grid_2d_table<double>::load(filename), weif::error);
+	std::remove(filename.c_str());
+
+	CPPUNIT_ASSERT(table.altitude_min() == loaded.altitude_min());
+	CPPUNIT_ASSERT(table.altitude_max() == loaded.altitude_max());
+	CPPUNIT_ASSERT(table.estimated_error() == loaded.estimated_error());
+	CPPUNIT_ASSERT(xt::all(xt::equal(table(2.5L), loaded(2.5L))));
+}
+
+void test_grid_2d_table4() {
+	using namespace weif;
+
+	constexpr double lambda = 550;
+	constexpr double aperture_scale = 10;
+	const auto filename = (std::filesystem::temp_directory_path() / "weif_test_grid_2d_table4.bin").string();
+	const weight_function_grid_2d_table<double> table(sf::mono<double>{}, lambda, af::circular<double>{}, aperture_scale, aperture_scale, {3, 3}, 1.0, 10.0, 1e-2);
+
+	const auto load_with = [&] (std::uint64_t size, std::uint64_t shape0, std::uint64_t shape1) {
+		table.save(filename);
+
+		detail::table_file_header header;
+		{
+			std::ifstream stm(filename, std::ios::binary);
+			stm.read(reinterpret_cast<char*>(&header), sizeof(header));
+		}
+
+		header.size = size;
+		header.shape[0] = shape0;
+		header.shape[1] = shape1;
+
+		{
+			std::fstream stm(filename, std::ios::binary | std::ios::in | std::ios::out);
+			stm.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		}
+
+		/* The length of the data wraps around to zero here */
+		if (2 * size * shape0 * shape1 * sizeof(double) == 0) {
+			std::filesystem::resize_file(filename, detail::table_file_data_offset);
+		}
+
+		return weight_function_grid_2d_table<double>::load(filename);
+	};
+
+	CPPUNIT_ASSERT_THROW(load_with(1, 3, 3), weif::error);
+	CPPUNIT_ASSERT_THROW(load_with(0, 3, 3), weif::error);
+	CPPUNIT_ASSERT_THROW(load_with(table.size(), 0, 3), weif::error);
+	CPPUNIT_ASSERT_THROW(load_with(table.size(), 3, 0), weif::error);
+	CPPUNIT_ASSERT_THROW(load_with(2, std::uint64_t{1} << 62, 1), weif::error);
+	CPPUNIT_ASSERT_THROW(load_with(std::uint64_t{1} << 61, 2, 2), weif::error);
+	std::remove(filename.c_str());
+}
+
+void test_grid_2d_table5() {
+	using namespace weif;
+
+	constexpr double lambda = 550;
+	constexpr double aperture_scale = 10;
+	const weight_function_grid_2d<double> wf(sf::mono<double>{}, lambda, af::circular<double>{}, aperture_scale, aperture_scale, {3, 3});
+
+	CPPUNIT_ASSERT_THROW(weight_function_grid_2d_table<double>(wf, 0.0, 10.0), weif::error);
+	CPPUNIT_ASSERT_THROW(weight_function_grid_2d_table<double>(wf, -1.0, 10.0), weif::error);
+	CPPUNIT_ASSERT_THROW(weight_function_grid_2d_table<double>(wf, 10.0, 1.0), weif::error);
+}
+};
+CPPUNIT_TEST_SUITE_REGISTRATION(test_weight_function_grid_2d_table_suite);
+
+int main(int argc, char **argv) {
+	CppUnit::TextUi::TestRunner runner;
+	CppUnit::TestFactoryRegistry &registry = CppUnit::TestFactoryRegistry::getRegistry();
+	runner.addTest(registry.makeTest());
+	return !runner.run("", false);
+}
@@ -0,0 +1,88 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Copyright (C) 2022-2024  Matwey V. Kornilov <matwey.kornilov@gmail.com>
+ */
+
+#include <cmath>
+#include <limits>
+
+#include <cppunit/TestAssert.h>
+#include <cppunit/TestCase.h>
+#include <cppunit/Portability.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/ui/text/TestRunner.h>
+
+#include <weif/af/circular.h>
+#include <weif/error.h>
+#include <weif/sf/mono.h>
+#include <weif/spectrum/von_karman.h>
+#include <weif/weight_function.h>
+#include <weif/weight_function_sensitivity.h>
+
+
+class test_weight_function_sensitivity_suite: public CppUnit::TestCase {
+CPPUNIT_TEST_SUITE(test_weight_function_sensitivity_suite);
+CPPUNIT_TEST(test_sensitivity1);
+CPPUNIT_TEST(test_sensitivity2);
+CPPUNIT_TEST_SUITE_END();
+
+void test_sensitivity1() {
+	using namespace weif;
+
+	constexpr double lambda = 550;
+	constexpr double aperture_scale = 10;
+	constexpr double obscuration = 0.3;
+	constexpr double altitude = 4;
+	constexpr double step = 1e-3;
+	constexpr double delta = 1e-3;
+	const weight_function_sensitivity<double> wf(sf::mono<double>{}, lambda, af::annular<double>{obscuration}, aperture_scale, 1024);
+	const auto actual = wf(altitude);
+
+	const auto w = [altitude] (double l, double d, double e) {
+		return weight_function<double>(sf::mono<double>{}, l, af::annular<double>{e}, d, 1024)(altitude);
+	};
+
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(w(lambda, aperture_scale, obscuration), actual.value, 1e-12 * actual.value);
+
+	const auto d_aperture_scale = (w(lambda, aperture_scale * (1 + step), obscuration) - w(lambda, aperture_scale * (1 - step), obscuration)) / (2 * step * aperture_scale);
+	const auto d_lambda = (w(lambda * (1 + step), aperture_scale, obscuration) - w(lambda * (1 - step), aperture_scale, obscuration)) / (2 * step * lambda);
+	const auto d_obscuration = (w(lambda, aperture_scale, obscuration + step) - w(lambda, aperture_scale, obscuration - step)) / (2 * step);
+
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(d_aperture_scale, actual.aperture_scale, delta * std::abs(d_aperture_scale));
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(d_lambda, actual.lambda, delta * std::abs(d_lambda));
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(d_obscuration, actual.parameter, delta * std::abs(d_obscuration));
+}
+void test_sensitivity2() {
+	using namespace weif;
+
+	constexpr double lambda = 550;
+	constexpr double aperture_scale = 10;
+	constexpr double altitude = 4;
+	constexpr double delta = 1e-6;
+	const weight_function<double> wf(sf::mono<double>{}, lambda, af::circular<double>{}, aperture_scale, 1024);
+	const weight_function<double> wf_inf(sf::mono<double>{}, lambda, af::circular<double>{}, aperture_scale, spectrum::von_karman<double>{}, 1024);
+	const weight_function<double> wf_outer(sf::mono<double>{}, lambda, af::circular<double>{}, aperture_scale, spectrum::von_karman<double>{1000}, 1024);
+	const weight_function<double> wf_inner(sf::mono<double>{}, lambda, af::circular<double>{}, aperture_scale,
+		spectrum::von_karman<double>{std::numeric_limits<double>::infinity(), 5}, 1024);
+
+	/* The scales of the spectrum are frozen in the table in the units of the aperture scale */
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(wf.aperture_scale_derivative(altitude), wf_inf.aperture_scale_derivative(altitude),
+		delta * std::abs(wf.aperture_scale_derivative(altitude)));
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(wf.lambda_derivative(altitude), wf_inf.lambda_derivative(altitude),
+		delta * std::abs(wf.lambda_derivative(altitude)));
+	CPPUNIT_ASSERT_THROW(wf_outer.aperture_scale_derivative(altitude), weif::error);
+	CPPUNIT_ASSERT_THROW(wf_outer.lambda_derivative(altitude), weif::error);
+	CPPUNIT_ASSERT_THROW(wf_inner.aperture_scale_derivative(altitude), weif::error);
+	CPPUNIT_ASSERT_THROW(wf_inner.lambda_derivative(altitude), weif::error);
+}
+};
+CPPUNIT_TEST_SUITE_REGISTRATION(test_weight_function_sensitivity_suite);
+
+int main(int argc, char **argv) {
+	CppUnit::TextUi::TestRunner runner;
+	CppUnit::TestFactoryRegistry &registry = CppUnit::TestFactoryRegistry::getRegistry();
+	runner.addTest(registry.makeTest());
+	return !runner.run("", false);
+}